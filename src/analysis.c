@@ -0,0 +1,150 @@
+#include "analysis.h"
+#include "pixels.h"
+#include <math.h>
+#include <string.h>
+
+// Share of the score lost by a window at the far edge versus the centre
+#define ANALYSIS_CENTER_BIAS 0.25
+
+Eina_Bool analysis_crop(const uint32_t* px, int w, int h, double aspect, Analysis_Rect* out)
+{
+    if (!px || !out || w <= 1 || h <= 1 || aspect <= 0.0)
+        return EINA_FALSE;
+
+    // Crop along x when the image is wider than the screen, else along y
+    Eina_Bool along_x = (double) w / h > aspect;
+    int span = along_x ? w : h;
+    int window = along_x ? (int) (h * aspect + 0.5) : (int) (w / aspect + 0.5);
+    if (window >= span) {
+        *out = (Analysis_Rect) { 0.0, 0.0, 1.0, 1.0 };
+        return EINA_TRUE;
+    }
+    if (window < 1)
+        window = 1;
+
+    size_t n = (size_t) w * h;
+    uint8_t* luma = malloc(n * 2);
+    double* sums = calloc((size_t) span + 1, sizeof(double));
+    if (!luma || !sums) {
+        free(luma);
+        free(sums);
+        return EINA_FALSE;
+    }
+    uint8_t* energy = luma + n;
+    pixels_luma(px, n, luma);
+    pixels_edge_energy(luma, w, h, energy);
+
+    // Energy per column (or row) as a prefix sum
+    for (int y = 0; y < h; y++) {
+        const uint8_t* row = energy + (size_t) y * w;
+        for (int x = 0; x < w; x++)
+            sums[(along_x ? x : y) + 1] += row[x];
+    }
+    for (int i = 1; i <= span; i++)
+        sums[i] += sums[i - 1];
+
+    int slack = span - window;
+    int best = slack / 2;
+    double best_score = -1.0;
+    for (int start = 0; start <= slack; start++) {
+        double off = fabs(start - slack / 2.0) / (slack / 2.0);
+        double score = (sums[start + window] - sums[start]) * (1.0 - ANALYSIS_CENTER_BIAS * off);
+        if (score > best_score) {
+            best_score = score;
+            best = start;
+        }
+    }
+    free(luma);
+    free(sums);
+
+    if (along_x)
+        *out = (Analysis_Rect) { (double) best / w, 0.0, (double) window / w, 1.0 };
+    else
+        *out = (Analysis_Rect) { 0.0, (double) best / h, 1.0, (double) window / h };
+    return EINA_TRUE;
+}
+
+// Colour bins for the dominant colour: 4 bits per channel
+#define ANALYSIS_COLOR_BITS 4
+#define ANALYSIS_COLOR_BINS (1 << (3 * ANALYSIS_COLOR_BITS))
+// Sampling step in both directions
+#define ANALYSIS_TONE_STEP 2
+
+static unsigned char _percentile(const uint32_t hist[256], unsigned int total, double p)
+{
+    unsigned int want = (unsigned int) (total * p);
+    unsigned int seen = 0;
+    for (int b = 0; b < 256; b++) {
+        seen += hist[b];
+        if (seen > want)
+            return (unsigned char) b;
+    }
+    return 255;
+}
+
+void analysis_tone(const uint32_t* px, int w, int h, const Analysis_Rect* rect, Analysis_Tone* out)
+{
+    memset(out, 0, sizeof(*out));
+    out->dominant = 0xff000000;
+    if (!px || !rect || w <= 0 || h <= 0)
+        return;
+    int x0 = (int) (rect->x * w), y0 = (int) (rect->y * h);
+    int x1 = (int) ((rect->x + rect->w) * w), y1 = (int) ((rect->y + rect->h) * h);
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > w ? w : x1;
+    y1 = y1 > h ? h : y1;
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    int cols = (x1 - x0 + ANALYSIS_TONE_STEP - 1) / ANALYSIS_TONE_STEP;
+    uint32_t* row = malloc((size_t) cols * sizeof(uint32_t));
+    uint8_t* luma = malloc((size_t) cols);
+    uint32_t* bins = calloc(ANALYSIS_COLOR_BINS, sizeof(uint32_t));
+    if (!row || !luma || !bins) {
+        free(row);
+        free(luma);
+        free(bins);
+        return;
+    }
+
+    uint32_t hist[256];
+    memset(hist, 0, sizeof(hist));
+    unsigned long long sum = 0;
+    unsigned int total = 0;
+    const int shift = 8 - ANALYSIS_COLOR_BITS;
+    for (int y = y0; y < y1; y += ANALYSIS_TONE_STEP) {
+        const uint32_t* src = px + (size_t) y * w;
+        for (int i = 0; i < cols; i++) {
+            uint32_t p = src[x0 + i * ANALYSIS_TONE_STEP];
+            row[i] = p;
+            bins[(((p >> 16) & 0xff) >> shift) << (2 * ANALYSIS_COLOR_BITS)
+                | (((p >> 8) & 0xff) >> shift) << ANALYSIS_COLOR_BITS | ((p & 0xff) >> shift)]++;
+        }
+        pixels_luma(row, (size_t) cols, luma);
+        pixels_histogram(luma, (size_t) cols, hist);
+        total += (unsigned int) cols;
+    }
+    for (int b = 0; b < 256; b++)
+        sum += (unsigned long long) hist[b] * b;
+
+    int best = 0;
+    for (int b = 1; b < ANALYSIS_COLOR_BINS; b++) {
+        if (bins[b] > bins[best])
+            best = b;
+    }
+    // Centre of the winning bin
+    const int mask = (1 << ANALYSIS_COLOR_BITS) - 1;
+    const uint32_t half = 1u << (shift - 1);
+    uint32_t r = (uint32_t) ((best >> (2 * ANALYSIS_COLOR_BITS)) & mask) << shift | half;
+    uint32_t g = (uint32_t) ((best >> ANALYSIS_COLOR_BITS) & mask) << shift | half;
+    uint32_t b = (uint32_t) (best & mask) << shift | half;
+
+    out->mean = (unsigned char) (sum / total);
+    out->low = _percentile(hist, total, 0.10);
+    out->high = _percentile(hist, total, 0.90);
+    out->dominant = 0xff000000 | (r << 16) | (g << 8) | b;
+    free(row);
+    free(luma);
+    free(bins);
+}
@@ -0,0 +1,36 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "common.h"
+#include <stdint.h>
+
+// Image analysis run on decode workers over small downscaled copies of a
+// slide: where to crop it, and what the overlays will be drawn on.
+
+// A rectangle in fractions (0..1) of the upright image
+typedef struct {
+    double x;
+    double y;
+    double w;
+    double h;
+} Analysis_Rect;
+
+// Largest crop of the upright w x h buffer with the given aspect (w / h),
+// slid along the free axis to the window with the most edge energy. A mild
+// bias towards the centre keeps flat images centred.
+Eina_Bool analysis_crop(const uint32_t* px, int w, int h, double aspect, Analysis_Rect* out);
+
+// Tone of the image under one screen region
+typedef struct {
+    unsigned char mean; // mean luma
+    unsigned char low;  // 10th percentile luma
+    unsigned char high; // 90th percentile luma
+    uint32_t dominant;  // average ARGB of the most populated colour bin
+} Analysis_Tone;
+
+// Tone of the part of the w x h buffer covered by rect (fractions of the
+// buffer). Samples every other row and column. An empty rectangle reads as
+// black, like the letterbox bars around the image.
+void analysis_tone(const uint32_t* px, int w, int h, const Analysis_Rect* rect, Analysis_Tone* out);
+
+#endif /* ANALYSIS_H */
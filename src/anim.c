@@ -0,0 +1,497 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "anim.h"
+#include "pixels.h"
+#ifdef HAVE_GIFLIB
+#include <gif_lib.h>
+#endif
+
+// Memory the decoded frames of one animation may take
+#define ANIM_CACHE_BYTES (48 * 1024 * 1024)
+// Ring size limits, whatever the frame size
+#define ANIM_FRAMES_MIN 2
+#define ANIM_FRAMES_MAX 256
+// Browsers play delays under 20 ms at 100 ms; so do we
+#define ANIM_DELAY_MIN 0.02
+#define ANIM_DELAY_DEFAULT 0.1
+// Recheck interval while the worker is behind the display
+#define ANIM_STALL_RETRY 0.02
+
+typedef struct {
+    uint32_t* pixels; // w x h, reused for the next frame stored in this slot
+    double delay;     // seconds the frame stays on screen
+} Anim_Frame;
+
+// Shared by the worker and the main loop; freed once both are done with it
+typedef struct {
+    char* path;
+    int target_w;
+    int target_h;
+
+    Eina_Lock lock;
+    Eina_Condition cond;
+    // Ring of decoded frames in display order, oldest first (all under lock)
+    Anim_Frame* ring;
+    int cap;
+    int first; // slot of the oldest frame held
+    int count; // frames held
+    int w, h;  // frame size
+    Eina_Bool complete; // every frame is held; the worker has finished
+    Eina_Bool stop;     // the main loop has let go of this job
+
+    // Main loop only
+    Ecore_Thread* thread;
+    Eina_Bool worker_done;
+    Eina_Bool main_done;
+} Anim_Job;
+
+static Anim_Job* current = NULL;
+static Ecore_Timer* tick_timer = NULL;
+static Anim_Frame_Cb frame_cb = NULL;
+static const void* frame_data = NULL;
+static Eina_Bool paused = EINA_FALSE;
+// Frame on screen, as an offset from the oldest frame held
+static int shown = -1;
+
+static void _job_free(Anim_Job* job)
+{
+    if (job->ring) {
+        for (int i = 0; i < job->cap; i++)
+            free(job->ring[i].pixels);
+        free(job->ring);
+    }
+    eina_condition_free(&job->cond);
+    eina_lock_free(&job->lock);
+    free(job->path);
+    free(job);
+}
+
+#ifdef HAVE_GIFLIB
+// Decoder state for one pass over the file
+typedef struct {
+    GifFileType* gif;
+    uint32_t* canvas;   // logical screen, composed frame by frame
+    uint32_t* previous; // canvas saved for DISPOSE_PREVIOUS
+    GifPixelType* line;
+    int sw, sh;
+} Gif_Pass;
+
+static void _pass_close(Gif_Pass* p)
+{
+    if (p->gif)
+        DGifCloseFile(p->gif, NULL);
+    free(p->canvas);
+    free(p->previous);
+    free(p->line);
+    memset(p, 0, sizeof(*p));
+}
+
+static Eina_Bool _pass_open(Gif_Pass* p, const char* path)
+{
+    memset(p, 0, sizeof(*p));
+    int err = 0;
+    p->gif = DGifOpenFileName(path, &err);
+    if (!p->gif)
+        return EINA_FALSE;
+    p->sw = p->gif->SWidth;
+    p->sh = p->gif->SHeight;
+    if (p->sw <= 0 || p->sh <= 0) {
+        _pass_close(p);
+        return EINA_FALSE;
+    }
+    size_t n = (size_t) p->sw * p->sh;
+    p->canvas = malloc(n * sizeof(uint32_t));
+    p->previous = malloc(n * sizeof(uint32_t));
+    p->line = malloc((size_t) p->sw);
+    if (!p->canvas || !p->previous || !p->line) {
+        _pass_close(p);
+        return EINA_FALSE;
+    }
+    // Slides sit on black: background and transparent areas are black too
+    for (size_t i = 0; i < n; i++)
+        p->canvas[i] = 0xff000000;
+    return EINA_TRUE;
+}
+
+// Read the current image descriptor's pixels onto the canvas
+static Eina_Bool _pass_draw(Gif_Pass* p, int transparent)
+{
+    GifFileType* gif = p->gif;
+    const GifImageDesc* d = &gif->Image;
+    const ColorMapObject* map = d->ColorMap ? d->ColorMap : gif->SColorMap;
+    if (d->Width <= 0 || d->Height <= 0 || d->Width > p->sw)
+        return EINA_FALSE;
+    // Interlaced images arrive in four passes of rows
+    static const int starts[] = { 0, 4, 2, 1 };
+    static const int steps[] = { 8, 8, 4, 2 };
+    int passes = d->Interlace ? 4 : 1;
+    for (int pass = 0; pass < passes; pass++) {
+        int start = d->Interlace ? starts[pass] : 0;
+        int step = d->Interlace ? steps[pass] : 1;
+        for (int row = start; row < d->Height; row += step) {
+            if (DGifGetLine(gif, p->line, d->Width) != GIF_OK)
+                return EINA_FALSE;
+            int y = d->Top + row;
+            if (y < 0 || y >= p->sh || !map)
+                continue;
+            uint32_t* dst = p->canvas + (size_t) y * p->sw;
+            for (int i = 0; i < d->Width; i++) {
+                int x = d->Left + i;
+                int c = p->line[i];
+                if (x < 0 || x >= p->sw || c == transparent || c >= map->ColorCount)
+                    continue;
+                const GifColorType* col = &map->Colors[c];
+                dst[x] = 0xff000000 | (uint32_t) col->Red << 16 | (uint32_t) col->Green << 8
+                    | col->Blue;
+            }
+        }
+    }
+    return EINA_TRUE;
+}
+
+static void _fill_rect(Gif_Pass* p, int x, int y, int w, int h)
+{
+    for (int j = y < 0 ? 0 : y; j < y + h && j < p->sh; j++) {
+        for (int i = x < 0 ? 0 : x; i < x + w && i < p->sw; i++)
+            p->canvas[(size_t) j * p->sw + i] = 0xff000000;
+    }
+}
+
+// Frame size: the screen fitted inside the target, never enlarged
+static void _fit_size(int sw, int sh, int tw, int th, int* w, int* h)
+{
+    double scale = 1.0;
+    if (tw > 0 && th > 0) {
+        double sx = (double) tw / sw, sy = (double) th / sh;
+        scale = sx < sy ? sx : sy;
+        if (scale > 1.0)
+            scale = 1.0;
+    }
+    *w = (int) (sw * scale + 0.5);
+    *h = (int) (sh * scale + 0.5);
+    if (*w < 1)
+        *w = 1;
+    if (*h < 1)
+        *h = 1;
+}
+
+// Store a composed canvas as the next frame, waiting for a free slot. Returns
+// EINA_FALSE once the main loop has stopped the job.
+static Eina_Bool _push_frame(
+    Anim_Job* job, const uint32_t* canvas, int sw, int sh, double delay, Ecore_Thread* thread)
+{
+    uint32_t* scaled = NULL;
+    const uint32_t* src = canvas;
+    if (sw != job->w || sh != job->h) {
+        scaled = pixels_resample(canvas, sw, sh, job->w, job->h, PIXELS_KERNEL_AREA);
+        if (!scaled)
+            return EINA_FALSE;
+        src = scaled;
+    }
+
+    eina_lock_take(&job->lock);
+    while (job->count == job->cap && !job->stop)
+        eina_condition_wait(&job->cond);
+    Eina_Bool ok = !job->stop;
+    if (ok) {
+        Anim_Frame* f = &job->ring[(job->first + job->count) % job->cap];
+        if (!f->pixels)
+            f->pixels = malloc((size_t) job->w * job->h * sizeof(uint32_t));
+        ok = f->pixels != NULL;
+        if (ok) {
+            memcpy(f->pixels, src, (size_t) job->w * job->h * sizeof(uint32_t));
+            f->delay = delay < ANIM_DELAY_MIN ? ANIM_DELAY_DEFAULT : delay;
+            job->count++;
+        }
+    }
+    int count = job->count;
+    eina_lock_release(&job->lock);
+    free(scaled);
+    // The first frame starts playback
+    if (ok && count == 1)
+        ecore_thread_feedback(thread, NULL);
+    return ok;
+}
+#endif
+
+static void _anim_run(void* data, Ecore_Thread* thread)
+{
+#ifdef HAVE_GIFLIB
+    Anim_Job* job = data;
+    int total = 0;
+    Eina_Bool first_pass = EINA_TRUE;
+    Eina_Bool evicted = EINA_FALSE;
+
+    while (!ecore_thread_check(thread)) {
+        Gif_Pass p;
+        if (!_pass_open(&p, job->path))
+            return;
+        if (first_pass) {
+            int w, h;
+            _fit_size(p.sw, p.sh, job->target_w, job->target_h, &w, &h);
+            int cap = ANIM_CACHE_BYTES / (w * h * (int) sizeof(uint32_t));
+            cap = cap < ANIM_FRAMES_MIN ? ANIM_FRAMES_MIN : cap;
+            cap = cap > ANIM_FRAMES_MAX ? ANIM_FRAMES_MAX : cap;
+            Anim_Frame* ring = calloc((size_t) cap, sizeof(Anim_Frame));
+            if (!ring) {
+                _pass_close(&p);
+                return;
+            }
+            eina_lock_take(&job->lock);
+            job->ring = ring;
+            job->cap = cap;
+            job->w = w;
+            job->h = h;
+            eina_lock_release(&job->lock);
+        }
+
+        int transparent = NO_TRANSPARENT_COLOR;
+        int disposal = DISPOSAL_UNSPECIFIED;
+        double delay = 0.0;
+        GifRecordType type;
+        Eina_Bool ok = EINA_TRUE;
+        int frames = 0;
+        do {
+            if (DGifGetRecordType(p.gif, &type) != GIF_OK) {
+                ok = EINA_FALSE;
+                break;
+            }
+            if (type == EXTENSION_RECORD_TYPE) {
+                int code;
+                GifByteType* ext = NULL;
+                if (DGifGetExtension(p.gif, &code, &ext) != GIF_OK) {
+                    ok = EINA_FALSE;
+                    break;
+                }
+                if (code == GRAPHICS_EXT_FUNC_CODE && ext) {
+                    GraphicsControlBlock gcb;
+                    if (DGifExtensionToGCB(ext[0], ext + 1, &gcb) == GIF_OK) {
+                        transparent = gcb.TransparentColor;
+                        disposal = gcb.DisposalMode;
+                        delay = gcb.DelayTime / 100.0;
+                    }
+                }
+                while (ext && ok)
+                    ok = DGifGetExtensionNext(p.gif, &ext) == GIF_OK;
+            } else if (type == IMAGE_DESC_RECORD_TYPE) {
+                if (DGifGetImageDesc(p.gif) != GIF_OK) {
+                    ok = EINA_FALSE;
+                    break;
+                }
+                GifImageDesc d = p.gif->Image;
+                if (disposal == DISPOSE_PREVIOUS)
+                    memcpy(p.previous, p.canvas, (size_t) p.sw * p.sh * sizeof(uint32_t));
+                if (!_pass_draw(&p, transparent)) {
+                    ok = EINA_FALSE;
+                    break;
+                }
+                if (!_push_frame(job, p.canvas, p.sw, p.sh, delay, thread)) {
+                    _pass_close(&p);
+                    return;
+                }
+                frames++;
+                if (disposal == DISPOSE_BACKGROUND)
+                    _fill_rect(&p, d.Left, d.Top, d.Width, d.Height);
+                else if (disposal == DISPOSE_PREVIOUS)
+                    memcpy(p.canvas, p.previous, (size_t) p.sw * p.sh * sizeof(uint32_t));
+                transparent = NO_TRANSPARENT_COLOR;
+                disposal = DISPOSAL_UNSPECIFIED;
+                delay = 0.0;
+            }
+        } while (type != TERMINATE_RECORD_TYPE && !ecore_thread_check(thread));
+        _pass_close(&p);
+        // A truncated file plays the frames it has
+        if (!ok)
+            WRN("Animation: %s is damaged after %d frames", job->path, frames);
+
+        if (first_pass) {
+            total = frames;
+            first_pass = EINA_FALSE;
+            eina_lock_take(&job->lock);
+            // Nothing had to make room: every frame is held, loop from memory
+            evicted = job->count < total;
+            if (!evicted)
+                job->complete = EINA_TRUE;
+            eina_lock_release(&job->lock);
+            if (!evicted)
+                return;
+        }
+        if (frames == 0)
+            return;
+        // Long animation: decode the next loop into recycled slots
+    }
+#else
+    (void) data;
+    (void) thread;
+#endif
+}
+
+static void _show(Anim_Job* job, int offset)
+{
+    const Anim_Frame* f = &job->ring[(job->first + offset) % job->cap];
+    Decoded_Slide frame = { 0 };
+    frame.pixels = f->pixels;
+    frame.w = job->w;
+    frame.h = job->h;
+    frame.orientation = 1;
+    shown = offset;
+    if (frame_cb)
+        frame_cb((void*) frame_data, &frame);
+}
+
+static Eina_Bool _tick_cb(void* data EINA_UNUSED)
+{
+    Anim_Job* job = current;
+    if (!job)
+        return ECORE_CALLBACK_CANCEL;
+
+    // Copy under the lock: the worker may only write slots that were released
+    eina_lock_take(&job->lock);
+    double delay = ANIM_STALL_RETRY;
+    if (job->complete) {
+        if (job->count > 1) {
+            _show(job, (shown + 1) % job->count);
+            delay = job->ring[(job->first + shown) % job->cap].delay;
+        } else {
+            delay = 0.0;
+        }
+    } else if (shown + 1 < job->count) {
+        _show(job, shown + 1);
+        delay = job->ring[(job->first + shown) % job->cap].delay;
+        // Once the ring is full, frames already shown make room for new ones
+        if (job->count == job->cap) {
+            job->first = (job->first + shown) % job->cap;
+            job->count -= shown;
+            shown = 0;
+            eina_condition_signal(&job->cond);
+        }
+    }
+    eina_lock_release(&job->lock);
+
+    tick_timer = NULL;
+    // A single still frame needs no timer
+    if (delay > 0.0)
+        tick_timer = ecore_timer_add(delay, _tick_cb, NULL);
+    if (tick_timer && paused)
+        ecore_timer_freeze(tick_timer);
+    return ECORE_CALLBACK_CANCEL;
+}
+
+// First frame decoded: put it up and start the clock
+static void _anim_notify(void* data, Ecore_Thread* thread EINA_UNUSED, void* msg EINA_UNUSED)
+{
+    Anim_Job* job = data;
+    if (job != current || shown >= 0)
+        return;
+    eina_lock_take(&job->lock);
+    double delay = 0.0;
+    if (job->count > 0) {
+        _show(job, 0);
+        delay = job->ring[job->first].delay;
+    }
+    eina_lock_release(&job->lock);
+    if (delay > 0.0) {
+        tick_timer = ecore_timer_add(delay, _tick_cb, NULL);
+        if (paused)
+            ecore_timer_freeze(tick_timer);
+    }
+}
+
+static void _anim_end(void* data, Ecore_Thread* thread EINA_UNUSED)
+{
+    Anim_Job* job = data;
+    job->worker_done = EINA_TRUE;
+    job->thread = NULL;
+    if (job->main_done)
+        _job_free(job);
+}
+
+Eina_Bool anim_is_animated(const char* path)
+{
+#ifdef HAVE_GIFLIB
+    return path && eina_str_has_extension(path, ".gif");
+#else
+    (void) path;
+    return EINA_FALSE;
+#endif
+}
+
+Eina_Bool anim_start(
+    const char* path, int target_w, int target_h, Anim_Frame_Cb cb, const void* data)
+{
+    anim_stop();
+    if (!anim_is_animated(path))
+        return EINA_FALSE;
+    Anim_Job* job = calloc(1, sizeof(Anim_Job));
+    if (!job)
+        return EINA_FALSE;
+    job->path = strdup(path);
+    job->target_w = target_w;
+    job->target_h = target_h;
+    if (!job->path || !eina_lock_new(&job->lock)) {
+        free(job->path);
+        free(job);
+        return EINA_FALSE;
+    }
+    if (!eina_condition_new(&job->cond, &job->lock)) {
+        eina_lock_free(&job->lock);
+        free(job->path);
+        free(job);
+        return EINA_FALSE;
+    }
+
+    frame_cb = cb;
+    frame_data = data;
+    shown = -1;
+    current = job;
+    job->thread
+        = ecore_thread_feedback_run(_anim_run, _anim_notify, _anim_end, _anim_end, job, EINA_FALSE);
+    if (!job->thread && job->worker_done) {
+        // The cancel callback already ran
+        current = NULL;
+        _job_free(job);
+        return EINA_FALSE;
+    }
+    DBG("Animation started: %s", path);
+    return EINA_TRUE;
+}
+
+void anim_pause(Eina_Bool pause)
+{
+    if (paused == pause)
+        return;
+    paused = pause;
+    if (!tick_timer)
+        return;
+    if (pause)
+        ecore_timer_freeze(tick_timer);
+    else
+        ecore_timer_thaw(tick_timer);
+}
+
+void anim_stop(void)
+{
+    if (tick_timer) {
+        ecore_timer_del(tick_timer);
+        tick_timer = NULL;
+    }
+    Anim_Job* job = current;
+    current = NULL;
+    shown = -1;
+    frame_cb = NULL;
+    frame_data = NULL;
+    if (!job)
+        return;
+
+    // Wake a worker waiting for a free slot so it sees the stop
+    eina_lock_take(&job->lock);
+    job->stop = EINA_TRUE;
+    eina_condition_broadcast(&job->cond);
+    eina_lock_release(&job->lock);
+    job->main_done = EINA_TRUE;
+    if (job->thread)
+        ecore_thread_cancel(job->thread);
+    if (job->worker_done)
+        _job_free(job);
+}
@@ -0,0 +1,30 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include "common.h"
+#include "decode.h"
+
+// Animated GIF playback. A worker decodes and composes frames at the slide's
+// fit size into a ring of frames bounded by a memory budget. Animations that
+// fit are decoded once and looped from memory; longer ones stream through the
+// ring, the worker reusing each slot's buffer once its frame has been shown.
+// Frames are handed to the main loop at their GIF delays.
+
+// Frame delivery, on the main loop. frame is only valid during the call.
+typedef void (*Anim_Frame_Cb)(void* data, const Decoded_Slide* frame);
+
+// Whether path is played as an animation (GIF, when built with giflib)
+Eina_Bool anim_is_animated(const char* path);
+
+// Play path fitted inside target_w x target_h, replacing any animation in
+// progress. Returns EINA_FALSE if no worker could be started.
+Eina_Bool anim_start(
+    const char* path, int target_w, int target_h, Anim_Frame_Cb cb, const void* data);
+
+// Stop ticking (e.g. while a transition runs) and resume again
+void anim_pause(Eina_Bool paused);
+
+// Stop and release the animation in progress, if any
+void anim_stop(void);
+
+#endif /* ANIM_H */
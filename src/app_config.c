@@ -22,6 +22,26 @@ App_Config config_defaults(void)
     cfg.news_visible = EINA_FALSE;    // news overlay hidden by default
     cfg.endpoint_url = NULL;          // plaintext endpoint disabled by default
     cfg.endpoint_interval = 60.0;     // default 60s polling
+    cfg.transition = "crossfade";     // image-to-image transition
+    cfg.ken_burns = EINA_FALSE;       // static stills by default
+    cfg.resample_kernel = "lanczos";  // downscale filter for decoded slides
+    cfg.sharpen = 0.0;                // no sharpening after resampling
+    cfg.blur_fill = EINA_FALSE;       // plain black letterbox bars
+    cfg.fill_screen = EINA_FALSE;     // fit whole images inside the letterbox
+    cfg.night = NULL;                 // no night mode schedule
+    cfg.night_level = 0.5;            // half-strength dimming and warming
+    cfg.proxy_cache = 0;              // videos always play from their source
+    cfg.wall = NULL;                  // one screen shows whole slides
+    cfg.wall_port = 47811;            // WALL_DEFAULT_PORT
+    cfg.wall_leader = NULL;           // follow the first leader heard from
+    cfg.timelapse = EINA_FALSE;       // numbered stills are slides of their own
+    cfg.version = CONFIG_VERSION;
+    cfg.export_dest = NULL;           // show the slideshow instead of exporting it
+    cfg.export_size = NULL;           // EXPORT_DEFAULT_W x EXPORT_DEFAULT_H
+    cfg.export_fps = 0;               // EXPORT_DEFAULT_FPS
+    cfg.pack_dest = NULL;             // show the slideshow instead of packing it
+    cfg.pack_size = NULL;             // PACK_DEFAULT_W x PACK_DEFAULT_H
+    cfg.pack_lz4 = EINA_FALSE;        // frames stored raw
     return cfg;
 }
 
@@ -52,6 +72,30 @@ static const Ecore_Getopt _opts = { .prog = "eslide",
         ECORE_GETOPT_STORE_STR(0, "endpoint", "Plaintext endpoint URL (e.g., http://host/path)."),
         ECORE_GETOPT_STORE_DOUBLE(0, "endpoint-interval",
             "Plaintext endpoint polling interval (seconds, default 60)."),
+        ECORE_GETOPT_STORE_STR(0, "transition",
+            "Image transition: crossfade, slide, push, zoom, wipe, cut or random."),
+        ECORE_GETOPT_STORE_TRUE(0, "ken-burns", "Slowly pan and zoom still images."),
+        ECORE_GETOPT_STORE_FALSE(0, "no-ken-burns", "Show still images without motion."),
+        ECORE_GETOPT_STORE_STR(0, "resample", "Image downscale filter: area or lanczos."),
+        ECORE_GETOPT_STORE_DOUBLE(0, "sharpen", "Sharpening after downscaling (0-1, default 0)."),
+        ECORE_GETOPT_STORE_TRUE(0, "blur-fill", "Fill letterbox bars with a blurred copy."),
+        ECORE_GETOPT_STORE_FALSE(0, "no-blur-fill", "Leave letterbox bars black."),
+        ECORE_GETOPT_STORE_TRUE(0, "fill-screen", "Crop images around their subject."),
+        ECORE_GETOPT_STORE_FALSE(0, "no-fill-screen", "Fit whole images inside the screen."),
+        ECORE_GETOPT_STORE_STR(0, "night", "Dim and warm slides during HH:MM-HH:MM (\"\" = off)."),
+        ECORE_GETOPT_STORE_DOUBLE(0, "night-level", "Night mode strength (0-1, default 0.5)."),
+        ECORE_GETOPT_STORE_INT(0, "proxy-cache", "Transcode stuttering videos, cache size MB."),
+        ECORE_GETOPT_STORE_STR(0, "wall", "Video wall tile COLSxROWS:COL,ROW (\"\" = off)."),
+        ECORE_GETOPT_STORE_INT(0, "wall-port", "UDP port for video wall sync (default 47811)."),
+        ECORE_GETOPT_STORE_STR(0, "wall-leader", "Follow only the wall leader at this IPv4."),
+        ECORE_GETOPT_STORE_TRUE(0, "timelapse", "Play runs of numbered stills as time-lapses."),
+        ECORE_GETOPT_STORE_FALSE(0, "no-timelapse", "Show numbered stills one by one."),
+        ECORE_GETOPT_STORE_STR(0, "export", "Render the slideshow to a PNG dir/, - or a video."),
+        ECORE_GETOPT_STORE_STR(0, "export-size", "Export frame size WxH (default 1920x1080)."),
+        ECORE_GETOPT_STORE_INT(0, "export-fps", "Export frame rate (default 30)."),
+        ECORE_GETOPT_STORE_STR(0, "pack", "Decode the stills into a slideshow pack file."),
+        ECORE_GETOPT_STORE_STR(0, "pack-size", "Pack frame size WxH (default 1920x1080)."),
+        ECORE_GETOPT_STORE_TRUE(0, "pack-lz4", "LZ4-compress pack frames."),
 
         ECORE_GETOPT_VERSION('V', "version"), ECORE_GETOPT_HELP('h', "help"),
         ECORE_GETOPT_SENTINEL } };
@@ -88,6 +132,21 @@ static void _config_edd_setup(void)
     EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "endpoint_url", endpoint_url, EET_T_STRING);
     EET_DATA_DESCRIPTOR_ADD_BASIC(
         _cfg_edd, App_Config, "endpoint_interval", endpoint_interval, EET_T_DOUBLE);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "transition", transition, EET_T_STRING);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "ken_burns", ken_burns, EET_T_INT);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(
+        _cfg_edd, App_Config, "resample_kernel", resample_kernel, EET_T_STRING);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "sharpen", sharpen, EET_T_DOUBLE);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "blur_fill", blur_fill, EET_T_INT);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "fill_screen", fill_screen, EET_T_INT);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "night", night, EET_T_STRING);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "night_level", night_level, EET_T_DOUBLE);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "proxy_cache", proxy_cache, EET_T_INT);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "wall", wall, EET_T_STRING);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "wall_port", wall_port, EET_T_INT);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "wall_leader", wall_leader, EET_T_STRING);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "timelapse", timelapse, EET_T_INT);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_cfg_edd, App_Config, "version", version, EET_T_INT);
 }
 
 void config_eet_init(void)
@@ -107,6 +166,37 @@ void config_eet_shutdown(void)
     eet_shutdown();
 }
 
+// Fields missing from a file written by an older version read as zero; give
+// them their defaults instead
+static void _config_upgrade(App_Config* cfg)
+{
+    App_Config defaults = config_defaults();
+    if (cfg->version < 1) {
+        cfg->transition = defaults.transition;
+        cfg->ken_burns = defaults.ken_burns;
+        cfg->resample_kernel = defaults.resample_kernel;
+        cfg->sharpen = defaults.sharpen;
+        cfg->blur_fill = defaults.blur_fill;
+        cfg->fill_screen = defaults.fill_screen;
+        cfg->night = defaults.night;
+        cfg->night_level = defaults.night_level;
+        cfg->proxy_cache = defaults.proxy_cache;
+        cfg->wall = defaults.wall;
+        cfg->wall_port = defaults.wall_port;
+        cfg->wall_leader = defaults.wall_leader;
+        cfg->timelapse = defaults.timelapse;
+        INF("Config from an older version; new settings take their defaults");
+    }
+    // Never persisted
+    cfg->export_dest = defaults.export_dest;
+    cfg->export_size = defaults.export_size;
+    cfg->export_fps = defaults.export_fps;
+    cfg->pack_dest = defaults.pack_dest;
+    cfg->pack_size = defaults.pack_size;
+    cfg->pack_lz4 = defaults.pack_lz4;
+    cfg->version = CONFIG_VERSION;
+}
+
 Eina_Bool config_load_from_eet(App_Config* out_cfg, const char* path)
 {
     if (!out_cfg || !path) {
@@ -126,6 +216,7 @@ Eina_Bool config_load_from_eet(App_Config* out_cfg, const char* path)
     }
     *out_cfg = *read_cfg;
     free(read_cfg);
+    _config_upgrade(out_cfg);
     return EINA_TRUE;
 }
 
@@ -169,6 +260,25 @@ void config_merge_cli(App_Config* cfg, int argc, char** argv)
     Eina_Bool news = cfg->news_visible;
     char* endpoint_url = (char*) cfg->endpoint_url;
     double endpoint_interval = cfg->endpoint_interval;
+    char* transition = (char*) cfg->transition;
+    Eina_Bool ken_burns = cfg->ken_burns;
+    char* resample_kernel = (char*) cfg->resample_kernel;
+    double sharpen = cfg->sharpen;
+    Eina_Bool blur_fill = cfg->blur_fill;
+    Eina_Bool fill_screen = cfg->fill_screen;
+    char* night = (char*) cfg->night;
+    double night_level = cfg->night_level;
+    int proxy_cache = cfg->proxy_cache;
+    char* wall = (char*) cfg->wall;
+    int wall_port = cfg->wall_port;
+    char* wall_leader = (char*) cfg->wall_leader;
+    Eina_Bool timelapse = cfg->timelapse;
+    char* export_dest = (char*) cfg->export_dest;
+    char* export_size = (char*) cfg->export_size;
+    int export_fps = cfg->export_fps;
+    char* pack_dest = (char*) cfg->pack_dest;
+    char* pack_size = (char*) cfg->pack_size;
+    Eina_Bool pack_lz4 = cfg->pack_lz4;
 
     Ecore_Getopt_Value values[]
         = { ECORE_GETOPT_VALUE_DOUBLE(interval), ECORE_GETOPT_VALUE_DOUBLE(fade),
@@ -181,6 +291,18 @@ void config_merge_cli(App_Config* cfg, int argc, char** argv)
               ECORE_GETOPT_VALUE_BOOL(news), ECORE_GETOPT_VALUE_BOOL(news),
               ECORE_GETOPT_VALUE_STR(endpoint_url),
               ECORE_GETOPT_VALUE_DOUBLE(endpoint_interval),
+              ECORE_GETOPT_VALUE_STR(transition), ECORE_GETOPT_VALUE_BOOL(ken_burns),
+              ECORE_GETOPT_VALUE_BOOL(ken_burns), ECORE_GETOPT_VALUE_STR(resample_kernel),
+              ECORE_GETOPT_VALUE_DOUBLE(sharpen), ECORE_GETOPT_VALUE_BOOL(blur_fill),
+              ECORE_GETOPT_VALUE_BOOL(blur_fill), ECORE_GETOPT_VALUE_BOOL(fill_screen),
+              ECORE_GETOPT_VALUE_BOOL(fill_screen), ECORE_GETOPT_VALUE_STR(night),
+              ECORE_GETOPT_VALUE_DOUBLE(night_level), ECORE_GETOPT_VALUE_INT(proxy_cache),
+              ECORE_GETOPT_VALUE_STR(wall), ECORE_GETOPT_VALUE_INT(wall_port),
+              ECORE_GETOPT_VALUE_STR(wall_leader), ECORE_GETOPT_VALUE_BOOL(timelapse),
+              ECORE_GETOPT_VALUE_BOOL(timelapse),
+              ECORE_GETOPT_VALUE_STR(export_dest), ECORE_GETOPT_VALUE_STR(export_size),
+              ECORE_GETOPT_VALUE_INT(export_fps), ECORE_GETOPT_VALUE_STR(pack_dest),
+              ECORE_GETOPT_VALUE_STR(pack_size), ECORE_GETOPT_VALUE_BOOL(pack_lz4),
               ECORE_GETOPT_VALUE_NONE, // version handled by Ecore_Getopt
               ECORE_GETOPT_VALUE_NONE, // help handled by Ecore_Getopt
               ECORE_GETOPT_VALUE_NONE };
@@ -210,6 +332,35 @@ void config_merge_cli(App_Config* cfg, int argc, char** argv)
         cfg->endpoint_url = endpoint_url;
     }
     cfg->endpoint_interval = endpoint_interval;
+    if (transition) {
+        cfg->transition = transition;
+    }
+    cfg->ken_burns = ken_burns;
+    if (resample_kernel) {
+        cfg->resample_kernel = resample_kernel;
+    }
+    cfg->sharpen = sharpen;
+    cfg->blur_fill = blur_fill;
+    cfg->fill_screen = fill_screen;
+    if (night) {
+        cfg->night = night;
+    }
+    cfg->night_level = night_level;
+    cfg->proxy_cache = proxy_cache;
+    if (wall) {
+        cfg->wall = wall;
+    }
+    cfg->wall_port = wall_port;
+    if (wall_leader) {
+        cfg->wall_leader = wall_leader;
+    }
+    cfg->timelapse = timelapse;
+    cfg->export_dest = export_dest;
+    cfg->export_size = export_size;
+    cfg->export_fps = export_fps;
+    cfg->pack_dest = pack_dest;
+    cfg->pack_size = pack_size;
+    cfg->pack_lz4 = pack_lz4;
 }
 
 // Retain original API for callers expecting a full parse from defaults
@@ -309,7 +460,10 @@ void config_log(const App_Config* cfg)
         return;
     }
     INF("Config: interval=%.2f s, fade=%.2f s, images_dir=%s, fullscreen=%s, shuffle=%s, clock=%s, "
-        "clock_format=%s, weather=%s, station=%s, news=%s, endpoint=%s, endpoint_interval=%.2f s",
+        "clock_format=%s, weather=%s, station=%s, news=%s, endpoint=%s, endpoint_interval=%.2f s, "
+        "transition=%s, ken_burns=%s, resample=%s, sharpen=%.2f, blur_fill=%s, "
+        "fill_screen=%s, night=%s, night_level=%.2f, proxy_cache=%d MB, "
+        "wall=%s, wall_port=%d, wall_leader=%s, timelapse=%s",
         cfg->slideshow_interval, cfg->fade_duration, cfg->images_dir ? cfg->images_dir : "(null)",
         cfg->fullscreen ? "true" : "false", cfg->shuffle ? "true" : "false",
         cfg->clock_visible ? "true" : "false", cfg->clock_24h ? "24h" : "12h",
@@ -317,5 +471,12 @@ void config_log(const App_Config* cfg)
         cfg->weather_station ? cfg->weather_station : "(null)",
         cfg->news_visible ? "true" : "false",
         cfg->endpoint_url ? cfg->endpoint_url : "(null)",
-        cfg->endpoint_interval);
+        cfg->endpoint_interval, cfg->transition ? cfg->transition : "(null)",
+        cfg->ken_burns ? "true" : "false",
+        cfg->resample_kernel ? cfg->resample_kernel : "(null)", cfg->sharpen,
+        cfg->blur_fill ? "true" : "false", cfg->fill_screen ? "true" : "false",
+        cfg->night ? cfg->night : "(null)", cfg->night_level, cfg->proxy_cache,
+        cfg->wall ? cfg->wall : "(null)", cfg->wall_port,
+        cfg->wall_leader ? cfg->wall_leader : "(null)",
+        cfg->timelapse ? "true" : "false");
 }
\ No newline at end of file
@@ -3,6 +3,10 @@
 
 #include <Eina.h>
 
+// Layout of the persisted config. Files without a version predate every field
+// from transition on; those fields take their defaults when such a file loads.
+#define CONFIG_VERSION 1
+
 typedef struct {
     double slideshow_interval;
     double fade_duration;
@@ -16,6 +20,28 @@ typedef struct {
     Eina_Bool news_visible;      // news overlay visibility
     const char* endpoint_url;    // plaintext endpoint URL (e.g., http://host/path)
     double endpoint_interval;    // polling interval for endpoint (seconds)
+    const char* transition;      // image transition name or "random"
+    Eina_Bool ken_burns;         // slow pan/zoom on still images
+    const char* resample_kernel; // "area" or "lanczos" for decoded slides
+    double sharpen;              // unsharp amount after resampling (0-1)
+    Eina_Bool blur_fill;         // blurred photo instead of black letterbox bars
+    Eina_Bool fill_screen;       // smart-crop images to the screen aspect
+    const char* night;           // night mode schedule "HH:MM-HH:MM", NULL = off
+    double night_level;          // night dimming and warming strength (0-1)
+    int proxy_cache;             // video proxy cache size in MB, 0 = no proxies
+    const char* wall;            // video wall tile "COLSxROWS:COL,ROW", NULL = off
+    int wall_port;               // UDP port the wall tiles talk on
+    const char* wall_leader;     // IPv4 address of the wall leader, NULL = first heard
+    Eina_Bool timelapse;         // play numbered runs of stills as time-lapses
+    int version;                 // CONFIG_VERSION the settings were written with
+    // One-shot export run; never persisted
+    const char* export_dest;     // PNG directory, "-" or video file, NULL = none
+    const char* export_size;     // "WxH", NULL = 1920x1080
+    int export_fps;              // 0 = 30
+    // One-shot pack build; never persisted
+    const char* pack_dest;       // slideshow pack file to write, NULL = none
+    const char* pack_size;       // "WxH" the frames are fitted inside, NULL = 1920x1080
+    Eina_Bool pack_lz4;          // LZ4-compress pack frames
 } App_Config;
 
 // Initialize defaults from compile-time constants and current module defaults
@@ -1,4 +1,5 @@
 #include "clock.h"
+#include "contrast.h"
 
 // Clock state variables
 Evas_Object* clock_label = NULL;
@@ -30,15 +31,15 @@ Eina_Bool clock_timer_cb(void* data EINA_UNUSED)
     // Use %-d to drop leading zero in day of month
     strftime(date_string, sizeof(date_string), "%A, %B %-d", time_info);
 
-    // Create HTML formatted string with Open Sans Light and white color
-    // Date on a line above time; time larger than date
+    // Create HTML formatted string with Open Sans Light, coloured to stand out
+    // from the slide behind it. Date on a line above time; time larger than date
     // If Open Sans is unavailable, fontconfig will fallback to a default sans
     snprintf(formatted_text, sizeof(formatted_text),
-        "<font=Open Sans:style=Light><color=#FFFFFF>"
+        "<font=Open Sans:style=Light>%s"
         "<font_size=32>%s</font_size><br>"
         "<font_size=96>%s</font_size>"
         "</color></font>",
-        date_string, time_string);
+        contrast_color_tag(CONTRAST_CLOCK), date_string, time_string);
 
     // Update clock label
     if (clock_label) {
@@ -66,6 +67,7 @@ void on_letterbox_resize(
     if (ch <= 0)
         ch = 180;
     evas_object_move(clock_label, x + w - cw - 20, y + h - ch - 20);
+    contrast_region_set(CONTRAST_CLOCK, obj, clock_label);
 }
 
 // Toggle clock visibility
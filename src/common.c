@@ -1,5 +1,14 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "common.h"
 
+extern char** environ;
+
 // Global logging domain definition
 int _log_domain = -1;
 
@@ -23,4 +32,128 @@ void common_cleanup_logging(void)
         eina_log_domain_unregister(_log_domain);
         _log_domain = -1;
     }
-}
\ No newline at end of file
+}
+
+Eina_Bool common_in_path(const char* name)
+{
+    const char* path = getenv("PATH");
+    if (!path)
+        return EINA_FALSE;
+    char** dirs = eina_str_split(path, ":", 0);
+    if (!dirs)
+        return EINA_FALSE;
+    Eina_Bool found = EINA_FALSE;
+    for (int i = 0; dirs[i] && !found; i++) {
+        char file[PATH_MAX];
+        snprintf(file, sizeof(file), "%s/%s", dirs[i][0] ? dirs[i] : ".", name);
+        found = access(file, X_OK) == 0;
+    }
+    free(dirs[0]);
+    free(dirs);
+    return found;
+}
+
+Eina_Bool common_parse_size(const char* s, int max, int* w, int* h)
+{
+    int n = 0;
+    return s && sscanf(s, "%dx%d%n", w, h, &n) == 2 && s[n] == '\0' && *w >= 16 && *h >= 16
+        && *w <= max && *h <= max;
+}
+
+Eina_Bool common_run_capture(
+    char* const argv[], size_t max_bytes, unsigned char** out_data, size_t* out_size)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        return EINA_FALSE;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    pid_t pid;
+    int err = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (err != 0) {
+        close(fds[0]);
+        return EINA_FALSE;
+    }
+
+    size_t cap = 64 * 1024, len = 0;
+    unsigned char* buf = malloc(cap);
+    while (buf) {
+        if (len + 1 == cap) {
+            unsigned char* grown = cap < max_bytes ? realloc(buf, cap * 2) : NULL;
+            if (!grown) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fds[0], buf + len, cap - len - 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        len += (size_t) n;
+    }
+    close(fds[0]);
+    // The status is not used: Ecore may reap the child first, and the output
+    // is validated by whoever parses it
+    while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+        ;
+    if (!buf || len == 0) {
+        free(buf);
+        return EINA_FALSE;
+    }
+    buf[len] = '\0';
+    *out_data = buf;
+    *out_size = len;
+    return EINA_TRUE;
+}
+
+pid_t common_spawn(char* const argv[], int nice, int* stdin_fd)
+{
+    int fds[2] = { -1, -1 };
+    // Close-on-exec, so later children do not hold the pipe open
+    if (stdin_fd
+        && (pipe(fds) != 0 || fcntl(fds[0], F_SETFD, FD_CLOEXEC) != 0
+            || fcntl(fds[1], F_SETFD, FD_CLOEXEC) != 0)) {
+        int err = errno;
+        if (fds[0] >= 0) {
+            close(fds[0]);
+            close(fds[1]);
+        }
+        errno = err;
+        return -1;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (stdin_fd)
+        posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+    else
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    int err = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (stdin_fd)
+        close(fds[0]);
+    if (err != 0) {
+        if (stdin_fd)
+            close(fds[1]);
+        errno = err;
+        return -1;
+    }
+    // Lowered right after the start; the child has barely begun by then
+    if (nice != 0)
+        setpriority(PRIO_PROCESS, (id_t) pid, nice);
+    if (stdin_fd)
+        *stdin_fd = fds[1];
+    return pid;
+}
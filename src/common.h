@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <sys/types.h>
 #include <Elementary.h>
 #include <Emotion.h>
 #include <Eina.h>
@@ -39,4 +40,24 @@ int common_init_logging(void);
 // Function to cleanup logging domain
 void common_cleanup_logging(void);
 
+// Whether an executable called name is found on PATH
+Eina_Bool common_in_path(const char* name);
+
+// Run argv (looked up on PATH) with stdout captured into a malloc'd buffer,
+// NUL-terminated and not counted in *out_size; output beyond about max_bytes
+// fails the call. stdin and stderr go to /dev/null. Blocks until the child
+// exits, so helpers that take a while belong on a worker.
+Eina_Bool common_run_capture(
+    char* const argv[], size_t max_bytes, unsigned char** out_data, size_t* out_size);
+
+// Parse a "WxH" frame size with each side between 16 and max
+Eina_Bool common_parse_size(const char* s, int max, int* w, int* h);
+
+// Start argv (looked up on PATH) without waiting for it, at niceness nice (0
+// to inherit). With stdin_fd the child reads stdin from a pipe whose write
+// end is returned there; otherwise from /dev/null. stdout goes to /dev/null,
+// stderr is inherited. Returns the pid, or -1 with errno set. The main loop
+// reports the exit as an ECORE_EXE_EVENT_DEL with this pid and no Ecore_Exe.
+pid_t common_spawn(char* const argv[], int nice, int* stdin_fd);
+
 #endif /* COMMON_H */
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "contrast.h"
+#include "clock.h"
+#include "news.h"
+#include "weather.h"
+
+// Backgrounds whose 90th percentile luma stays below this keep plain text
+#define CONTRAST_DARK_HIGH 96
+// Backgrounds at least this bright on average, with few dark pixels, get
+// dark text
+#define CONTRAST_BRIGHT_MEAN 170
+#define CONTRAST_BRIGHT_LOW 100
+// Share of the dominant colour kept in dark text
+#define CONTRAST_TINT 0.2
+
+#define CONTRAST_PLAIN_TAG "<color=#FFFFFF>"
+#define CONTRAST_TAG_MAX 96
+
+static Analysis_Rect regions[CONTRAST_REGIONS];
+static char tags[CONTRAST_REGIONS][CONTRAST_TAG_MAX];
+
+static void _tag_for(const Analysis_Tone* t, char* out)
+{
+    if (!t || t->high < CONTRAST_DARK_HIGH) {
+        snprintf(out, CONTRAST_TAG_MAX, CONTRAST_PLAIN_TAG);
+    } else if (t->mean >= CONTRAST_BRIGHT_MEAN && t->low >= CONTRAST_BRIGHT_LOW) {
+        // Dark text in the hue of the background, lifted off it by a glow
+        unsigned int r = (unsigned int) (((t->dominant >> 16) & 0xff) * CONTRAST_TINT);
+        unsigned int g = (unsigned int) (((t->dominant >> 8) & 0xff) * CONTRAST_TINT);
+        unsigned int b = (unsigned int) ((t->dominant & 0xff) * CONTRAST_TINT);
+        snprintf(out, CONTRAST_TAG_MAX, "<color=#%02X%02X%02X style=glow glow_color=#FFFFFF60>", r,
+            g, b);
+    } else {
+        snprintf(out, CONTRAST_TAG_MAX, "<color=#FFFFFF style=soft_shadow shadow_color=#000000C0>");
+    }
+}
+
+void contrast_region_set(Contrast_Region region, Evas_Object* letterbox, Evas_Object* label)
+{
+    if (region >= CONTRAST_REGIONS || !letterbox || !label)
+        return;
+    Evas_Coord lx, ly, lw, lh, x, y, w, h;
+    evas_object_geometry_get(letterbox, &lx, &ly, &lw, &lh);
+    evas_object_geometry_get(label, &x, &y, &w, &h);
+    if (lw <= 0 || lh <= 0)
+        return;
+    regions[region].x = (double) (x - lx) / lw;
+    regions[region].y = (double) (y - ly) / lh;
+    regions[region].w = (double) w / lw;
+    regions[region].h = (double) h / lh;
+    decode_set_tone_regions(regions, CONTRAST_REGIONS);
+}
+
+void contrast_apply(const Decoded_Slide* slide)
+{
+    Eina_Bool changed[CONTRAST_REGIONS];
+    for (int i = 0; i < CONTRAST_REGIONS; i++) {
+        char tag[CONTRAST_TAG_MAX];
+        const Analysis_Tone* t = slide && i < slide->tone_count ? &slide->tones[i] : NULL;
+        _tag_for(t, tag);
+        changed[i] = strcmp(tag, contrast_color_tag(i)) != 0;
+        if (changed[i])
+            memcpy(tags[i], tag, sizeof(tag));
+    }
+
+    if (changed[CONTRAST_CLOCK] && clock_label)
+        clock_timer_cb(NULL);
+    if (changed[CONTRAST_WEATHER] || changed[CONTRAST_ENDPOINT])
+        weather_refresh();
+    if (changed[CONTRAST_NEWS])
+        news_refresh();
+}
+
+const char* contrast_color_tag(Contrast_Region region)
+{
+    if (region >= CONTRAST_REGIONS || !tags[region][0])
+        return CONTRAST_PLAIN_TAG;
+    return tags[region];
+}
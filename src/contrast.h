@@ -0,0 +1,30 @@
+#ifndef CONTRAST_H
+#define CONTRAST_H
+
+#include "common.h"
+#include "decode.h"
+
+// Overlay contrast: decode workers measure the tone of the slide under each
+// overlay (see decode_set_tone_regions()); at transition time the overlays
+// switch between plain white, white with a shadow and dark tinted text from
+// those measurements, without touching pixels on the main loop.
+
+typedef enum {
+    CONTRAST_CLOCK,
+    CONTRAST_WEATHER,
+    CONTRAST_ENDPOINT,
+    CONTRAST_NEWS,
+    CONTRAST_REGIONS
+} Contrast_Region;
+
+// Record where label sits inside letterbox; call after moving the label
+void contrast_region_set(Contrast_Region region, Evas_Object* letterbox, Evas_Object* label);
+
+// Restyle the overlays for slide, or back to plain white when slide is NULL
+// or carries no tones. Labels are re-rendered only when their style changes.
+void contrast_apply(const Decoded_Slide* slide);
+
+// Opening colour tag for a label's markup, closed with </color>
+const char* contrast_color_tag(Contrast_Region region);
+
+#endif /* CONTRAST_H */
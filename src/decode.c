@@ -0,0 +1,1183 @@
+#include <sys/stat.h>
+#include "decode.h"
+#include "analysis.h"
+#include "document.h"
+#include "exif.h"
+#include "media.h"
+#include "pack.h"
+#include "pixels.h"
+#include "poster.h"
+#include <Emile.h>
+#include <math.h>
+
+// Number of decoded slides kept resident (current, next and one spare)
+#define DECODE_CACHE_SLOTS 3
+// Largest unsharp amount accepted from the config
+#define DECODE_SHARPEN_MAX 1.0
+// Blurred fill: built at 1/8 of the letterbox size, blurred, dimmed and
+// scaled back up. Bars narrower than DECODE_FILL_MIN_BAR pixels stay black.
+#define DECODE_FILL_SHRINK 8
+#define DECODE_FILL_RADIUS 6
+#define DECODE_FILL_DIM 0.55
+#define DECODE_FILL_MIN_BAR 8
+// Mean difference per channel between a region decode and the same block of
+// a full decode still taken as the same pixels
+#define DECODE_REGION_TOLERANCE 4
+// Smart-crop rectangles remembered before the table is reset
+#define DECODE_CROP_CACHE_MAX 1024
+
+typedef struct {
+    Decode_Done_Cb cb;
+    const void* data;
+} Decode_Waiter;
+
+typedef struct _Decode_Slot Decode_Slot;
+
+// Work item owned by a worker thread until its end/cancel callback runs
+typedef struct {
+    char* path;
+    int target_w;
+    int target_h;
+    Decoded_Slide* result;
+    double decode_time;
+    double resample_time; // 0 when the slide was already the right size
+    double fill_time;     // 0 when no blurred fill was built
+    Analysis_Rect tone_regions[DECODE_TONE_REGIONS_MAX];
+    int tone_region_count;
+    Pixels_Lut lut;        // colour LUT to apply, when lut_tag is not 0
+    unsigned int lut_tag;
+    Decode_Slot* slot;    // NULL once the slot has been dropped
+    Ecore_Thread* thread;
+} Decode_Job;
+
+struct _Decode_Slot {
+    char* path;
+    int target_w;
+    int target_h;
+    Decoded_Slide* slide; // NULL while decoding
+    unsigned int lut_tag; // colour LUT slide was processed with (0 = none)
+    unsigned int gen;     // settings_gen when the slot was created
+    Decode_Job* job;      // in-flight worker job, if any
+    Eina_List* waiters;   // Decode_Waiter* to notify on completion
+    Eina_Bool notifying;  // waiters are being called; do not evict
+};
+
+// Decode slots, most recently used first
+static Eina_List* slots = NULL;
+static int slot_limit = DECODE_CACHE_SLOTS;
+// Resampler settings; written on the main loop before workers read them
+static Pixels_Kernel resample_kernel = PIXELS_KERNEL_LANCZOS;
+static double resample_sharpen = 0.0;
+static Eina_Bool blur_fill = EINA_FALSE;
+static Eina_Bool fill_screen = EINA_FALSE;
+// Video wall layout and the tile decoded here (1x1 for whole slides)
+static int wall_cols = 1, wall_rows = 1, wall_col = 0, wall_row = 0;
+// Bumped when any of the above changes, so slots decoded before are missed
+static unsigned int settings_gen = 0;
+// Overlay regions copied into each job when it starts
+static Analysis_Rect tone_regions[DECODE_TONE_REGIONS_MAX];
+static int tone_region_count = 0;
+// Colour LUT for new decodes; each change gets a new tag, 0 means none.
+// Written on the main loop under lut_lock, which decode_file() takes to copy
+// it from other threads.
+static Pixels_Lut colour_lut;
+static unsigned int lut_tag = 0;
+static unsigned int lut_tag_next = 1;
+static Eina_Lock lut_lock;
+static Eina_Bool lut_lock_ready = EINA_FALSE;
+// Cleared if the JPEG loader turns out not to honour decode regions, set once
+// the first region decode was checked against a full one. Shared by the
+// workers, so only accessed atomically.
+static Eina_Bool region_decode = EINA_TRUE;
+static Eina_Bool region_checked = EINA_FALSE;
+
+// Smart-crop result for one file version and screen aspect
+typedef struct {
+    long long size;
+    long long mtime;
+    double aspect;
+    Analysis_Rect rect;
+} Crop_Entry;
+
+// path -> Crop_Entry*, shared by the workers. The lock outlives the table:
+// cancelled workers may still finish after decode_shutdown().
+static Eina_Hash* crop_cache = NULL;
+static Eina_Lock crop_lock;
+static Eina_Bool crop_lock_ready = EINA_FALSE;
+static Decode_Stats stats;
+
+void decoded_slide_free(Decoded_Slide* slide)
+{
+    if (!slide)
+        return;
+    free(slide->pixels);
+    free(slide);
+}
+
+Eina_Bool decode_is_supported(const char* path)
+{
+    if (!path)
+        return EINA_FALSE;
+    return eina_str_has_extension(path, ".jpg") || eina_str_has_extension(path, ".jpeg")
+        || is_raw_file(path) || document_is_supported(path) || is_pack_file(path);
+}
+
+// Largest libjpeg DCT scale (1/2/4/8) whose output still covers the letterbox
+// fit rectangle once the image is upright
+static int _pick_scale_down(unsigned int w, unsigned int h, int orientation, int tw, int th)
+{
+    if (tw <= 0 || th <= 0 || w == 0 || h == 0)
+        return 1;
+    if (orientation >= 5) {
+        unsigned int t = w;
+        w = h;
+        h = t;
+    }
+    double fit = (double) tw / w;
+    if ((double) th / h < fit)
+        fit = (double) th / h;
+    int scale = 1;
+    while (scale < 8 && fit * scale * 2 <= 1.0)
+        scale *= 2;
+    return scale;
+}
+
+// Region of the stored (pre-orientation) image that becomes the upright
+// rectangle r once the EXIF orientation is applied
+static Analysis_Rect _rect_to_stored(const Analysis_Rect* r, int orientation)
+{
+    switch (orientation) {
+    case 2:
+        return (Analysis_Rect) { 1.0 - r->x - r->w, r->y, r->w, r->h };
+    case 3:
+        return (Analysis_Rect) { 1.0 - r->x - r->w, 1.0 - r->y - r->h, r->w, r->h };
+    case 4:
+        return (Analysis_Rect) { r->x, 1.0 - r->y - r->h, r->w, r->h };
+    case 5:
+        return (Analysis_Rect) { r->y, r->x, r->h, r->w };
+    case 6:
+        return (Analysis_Rect) { r->y, 1.0 - r->x - r->w, r->h, r->w };
+    case 7:
+        return (Analysis_Rect) { 1.0 - r->y - r->h, 1.0 - r->x - r->w, r->h, r->w };
+    case 8:
+        return (Analysis_Rect) { 1.0 - r->y - r->h, r->x, r->h, r->w };
+    default:
+        return *r;
+    }
+}
+
+// Pixel rectangle of fractions r within a w x h image, at least 1x1
+static Eina_Rectangle _rect_pixels(const Analysis_Rect* r, unsigned int w, unsigned int h)
+{
+    Eina_Rectangle px;
+    px.x = (int) (r->x * w);
+    px.y = (int) (r->y * h);
+    px.w = (int) (r->w * w + 0.5);
+    px.h = (int) (r->h * h + 0.5);
+    px.x = px.x < 0 ? 0 : (px.x > (int) w - 1 ? (int) w - 1 : px.x);
+    px.y = px.y < 0 ? 0 : (px.y > (int) h - 1 ? (int) h - 1 : px.y);
+    px.w = px.w < 1 ? 1 : (px.x + px.w > (int) w ? (int) w - px.x : px.w);
+    px.h = px.h < 1 ? 1 : (px.y + px.h > (int) h ? (int) h - px.y : px.h);
+    return px;
+}
+
+// Cut the upright crop out of a decoded buffer, for loaders without regions
+static Eina_Bool _crop_in_memory(Decoded_Slide* slide, const Analysis_Rect* crop)
+{
+    Eina_Rectangle r = _rect_pixels(crop, slide->w, slide->h);
+    if (r.w == slide->w && r.h == slide->h)
+        return EINA_TRUE;
+    uint32_t* px = malloc((size_t) r.w * r.h * sizeof(uint32_t));
+    if (!px)
+        return EINA_FALSE;
+    for (int y = 0; y < r.h; y++)
+        memcpy(px + (size_t) y * r.w, slide->pixels + (size_t) (r.y + y) * slide->w + r.x,
+            (size_t) r.w * sizeof(uint32_t));
+    free(slide->pixels);
+    slide->pixels = px;
+    slide->w = r.w;
+    slide->h = r.h;
+    return EINA_TRUE;
+}
+
+static Emile_Image* _jpeg_open(Eina_Binbuf* bin, Emile_Image_Load_Opts* opts,
+    Emile_Image_Property* prop, Emile_Image_Load_Error* err);
+
+// Decode the whole image at the scale of opts and compare the block a region
+// decode returned with the same block of it. A loader can honour the size of
+// a region yet ignore its offset, which only this catches. Returns whether
+// they match; when they do not, *full gets the whole decode to crop instead.
+static Eina_Bool _region_matches(Eina_Binbuf* bin, const Emile_Image_Load_Opts* opts,
+    const uint32_t* px, unsigned int w, unsigned int h, uint32_t** full,
+    Emile_Image_Property* full_prop)
+{
+    Emile_Image_Load_Opts whole = *opts;
+    Emile_Image_Load_Error err = EMILE_IMAGE_LOAD_ERROR_NONE;
+    memset(&whole.region, 0, sizeof(whole.region));
+    Emile_Image* img = _jpeg_open(bin, &whole, full_prop, &err);
+    if (!img)
+        return EINA_TRUE; // nothing to compare with; keep the region decode
+    uint32_t* all = malloc((size_t) full_prop->w * full_prop->h * sizeof(uint32_t));
+    full_prop->cspace = EMILE_COLORSPACE_ARGB8888;
+    if (!all || !emile_image_data(img, full_prop, sizeof(*full_prop), all, &err)) {
+        emile_image_close(img);
+        free(all);
+        return EINA_TRUE;
+    }
+    emile_image_close(img);
+
+    // Chroma upsampling may differ by a little at the region's edges
+    unsigned int x0 = (unsigned int) opts->region.x, y0 = (unsigned int) opts->region.y;
+    Eina_Bool inside = x0 + w <= full_prop->w && y0 + h <= full_prop->h;
+    unsigned long long diff = 0, samples = 0;
+    for (unsigned int y = 0; inside && y < h; y += 8) {
+        const uint32_t* a = px + (size_t) y * w;
+        const uint32_t* b = all + (size_t) (y0 + y) * full_prop->w + x0;
+        for (unsigned int x = 0; x < w; x += 8, samples++) {
+            for (int s = 0; s < 24; s += 8) {
+                int ca = (int) ((a[x] >> s) & 0xff), cb = (int) ((b[x] >> s) & 0xff);
+                diff += (unsigned int) abs(ca - cb);
+            }
+        }
+    }
+    Eina_Bool match = inside && samples > 0 && diff <= samples * 3 * DECODE_REGION_TOLERANCE;
+    if (match)
+        free(all);
+    else
+        *full = all;
+    return match;
+}
+
+static Emile_Image* _jpeg_open(Eina_Binbuf* bin, Emile_Image_Load_Opts* opts,
+    Emile_Image_Property* prop, Emile_Image_Load_Error* err)
+{
+    memset(prop, 0, sizeof(*prop));
+    Emile_Image* img = emile_image_jpeg_memory_open(bin, opts, NULL, err);
+    if (img && !emile_image_head(img, prop, sizeof(*prop), err)) {
+        WRN("JPEG decode failed: %s", emile_load_error_str(img, *err));
+        emile_image_close(img);
+        return NULL;
+    }
+    return img;
+}
+
+// Decode a JPEG at the largest DCT scale that still covers the target. With
+// a crop (fractions of the upright image) only that region is decoded.
+static Decoded_Slide* _decode_jpeg(const unsigned char* data, size_t size, int orientation,
+    int target_w, int target_h, const Analysis_Rect* crop)
+{
+    if (!data || size == 0)
+        return NULL;
+
+    // Read-only wrapper: emile reads straight from the caller's mapping
+    Eina_Binbuf* bin = eina_binbuf_manage_new(data, size, EINA_TRUE);
+    if (!bin)
+        return NULL;
+
+    Emile_Image_Load_Opts opts;
+    Emile_Image_Property prop;
+    Emile_Image_Load_Error err = EMILE_IMAGE_LOAD_ERROR_NONE;
+    memset(&opts, 0, sizeof(opts));
+    // Orientation is applied by our own kernels below, not by the loader
+    opts.orientation = EINA_FALSE;
+
+    Emile_Image* img = _jpeg_open(bin, &opts, &prop, &err);
+    if (!img)
+        goto fail;
+
+    Eina_Rectangle region = { 0, 0, (int) prop.w, (int) prop.h };
+    if (crop) {
+        Analysis_Rect stored = _rect_to_stored(crop, orientation);
+        region = _rect_pixels(&stored, prop.w, prop.h);
+    }
+    int scale = _pick_scale_down(region.w, region.h, orientation, target_w, target_h);
+    Eina_Bool use_region
+        = crop && __atomic_load_n(&region_decode, __ATOMIC_RELAXED)
+        && (region.w < (int) prop.w || region.h < (int) prop.h);
+    if (scale > 1 || use_region) {
+        // Re-open so libjpeg decodes directly at the reduced DCT scale, and
+        // skips the rows and columns outside the region
+        emile_image_close(img);
+        opts.scale_down_by = scale;
+        if (use_region) {
+            // In the coordinates of the scaled image
+            opts.region.x = region.x / scale;
+            opts.region.y = region.y / scale;
+            opts.region.w = region.w / scale > 0 ? region.w / scale : 1;
+            opts.region.h = region.h / scale > 0 ? region.h / scale : 1;
+        }
+        img = _jpeg_open(bin, &opts, &prop, &err);
+        if (img && use_region && (prop.w != (unsigned int) opts.region.w
+                                     || prop.h != (unsigned int) opts.region.h)) {
+            WRN("JPEG loader ignored the decode region; cropping in memory instead");
+            __atomic_store_n(&region_decode, EINA_FALSE, __ATOMIC_RELAXED);
+            use_region = EINA_FALSE;
+            emile_image_close(img);
+            memset(&opts.region, 0, sizeof(opts.region));
+            img = _jpeg_open(bin, &opts, &prop, &err);
+        }
+        if (!img)
+            goto fail;
+    }
+    if (prop.w == 0 || prop.h == 0)
+        goto fail;
+
+    uint32_t* pixels = malloc((size_t) prop.w * prop.h * sizeof(uint32_t));
+    if (!pixels)
+        goto fail;
+    prop.cspace = EMILE_COLORSPACE_ARGB8888;
+    if (!emile_image_data(img, &prop, sizeof(prop), pixels, &err)) {
+        WRN("JPEG decode failed: %s", emile_load_error_str(img, err));
+        free(pixels);
+        goto fail;
+    }
+    emile_image_close(img);
+    img = NULL;
+    if (use_region && (opts.region.x > 0 || opts.region.y > 0)
+        && !__atomic_exchange_n(&region_checked, EINA_TRUE, __ATOMIC_RELAXED)) {
+        uint32_t* full = NULL;
+        Emile_Image_Property full_prop;
+        if (!_region_matches(bin, &opts, pixels, prop.w, prop.h, &full, &full_prop)) {
+            WRN("JPEG loader ignored the decode region offset; cropping in memory instead");
+            __atomic_store_n(&region_decode, EINA_FALSE, __ATOMIC_RELAXED);
+            use_region = EINA_FALSE;
+            free(pixels);
+            pixels = full;
+            prop.w = full_prop.w;
+            prop.h = full_prop.h;
+        }
+    }
+    eina_binbuf_free(bin);
+
+    Decoded_Slide* slide = calloc(1, sizeof(Decoded_Slide));
+    if (!slide) {
+        free(pixels);
+        return NULL;
+    }
+    slide->pixels = pixels_orient(pixels, (int) prop.w, (int) prop.h, orientation, &slide->w,
+        &slide->h);
+    slide->orientation = orientation;
+    if (!slide->pixels || (crop && !use_region && !_crop_in_memory(slide, crop))) {
+        decoded_slide_free(slide);
+        return NULL;
+    }
+    return slide;
+
+fail:
+    if (img)
+        emile_image_close(img);
+    eina_binbuf_free(bin);
+    return NULL;
+}
+
+Decoded_Slide* decode_jpeg_memory(
+    const unsigned char* data, size_t size, int orientation, int target_w, int target_h)
+{
+    return _decode_jpeg(data, size, orientation, target_w, target_h, NULL);
+}
+
+// A half-copied JPEG still decodes (libjpeg pads it with grey), so require an
+// EOI marker after the first scan. The header segments are walked to the SOS,
+// then the rest is searched: 0xFF 0xD9 cannot occur inside entropy-coded data,
+// and searching forward keeps trailers (motion photo videos, MPF images,
+// vendor data) from hiding the primary image's EOI.
+static Eina_Bool _jpeg_has_eoi(const unsigned char* data, size_t size)
+{
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+        return EINA_FALSE;
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF)
+            return EINA_FALSE;
+        unsigned char marker = data[pos + 1];
+        if (marker == 0xFF) {
+            pos++; // fill byte
+            continue;
+        }
+        if (marker == 0xD9)
+            return EINA_FALSE; // image ends before any scan
+        size_t seg_len = ((size_t) data[pos + 2] << 8) | data[pos + 3];
+        if (seg_len < 2)
+            return EINA_FALSE;
+        pos += 2 + seg_len;
+        if (marker == 0xDA)
+            break;
+    }
+    while (pos + 2 <= size) {
+        const unsigned char* ff = memchr(data + pos, 0xFF, size - pos - 1);
+        if (!ff)
+            return EINA_FALSE;
+        if (ff[1] == 0xD9)
+            return EINA_TRUE;
+        pos = (size_t) (ff - data) + 1;
+    }
+    return EINA_FALSE;
+}
+
+// Resample a slide to the fit rectangle of the target. The DCT scale leaves
+// it up to twice too large; smaller images are left for Evas to upscale.
+static void _resample_to_fit(Decoded_Slide* slide, int target_w, int target_h)
+{
+    if (target_w <= 1 || target_h <= 1)
+        return;
+    double fit = (double) target_w / slide->w;
+    if ((double) target_h / slide->h < fit)
+        fit = (double) target_h / slide->h;
+    if (fit >= 1.0)
+        return;
+    int dw = (int) (slide->w * fit + 0.5);
+    int dh = (int) (slide->h * fit + 0.5);
+    if (dw < 1 || dh < 1)
+        return;
+    uint32_t* px = pixels_resample(slide->pixels, slide->w, slide->h, dw, dh, resample_kernel);
+    if (!px)
+        return; // keep the larger buffer; Evas scales it instead
+    pixels_sharpen(px, dw, dh, resample_sharpen);
+    free(slide->pixels);
+    slide->pixels = px;
+    slide->w = dw;
+    slide->h = dh;
+}
+
+// Place a slide that leaves bars in the letterbox onto a full letterbox-size
+// buffer filled with a blurred, dimmed crop of itself. The renderer then
+// draws one opaque 1:1 image instead of bars plus an extra layer.
+static Eina_Bool _compose_blur_fill(Decoded_Slide* slide, int target_w, int target_h)
+{
+    if (target_w <= 1 || target_h <= 1 || slide->w > target_w || slide->h > target_h)
+        return EINA_FALSE;
+    int bar_x = target_w - slide->w, bar_y = target_h - slide->h;
+    // Small photos that Evas still has to upscale keep plain bars
+    if (bar_x > 1 && bar_y > 1)
+        return EINA_FALSE;
+    if (bar_x < DECODE_FILL_MIN_BAR * 2 && bar_y < DECODE_FILL_MIN_BAR * 2)
+        return EINA_FALSE;
+
+    // Centre crop of the photo with the letterbox aspect
+    double cover = (double) target_w / slide->w;
+    if ((double) target_h / slide->h > cover)
+        cover = (double) target_h / slide->h;
+    int cw = (int) (target_w / cover);
+    int ch = (int) (target_h / cover);
+    cw = cw < 1 ? 1 : (cw > slide->w ? slide->w : cw);
+    ch = ch < 1 ? 1 : (ch > slide->h ? slide->h : ch);
+    int bw = target_w / DECODE_FILL_SHRINK, bh = target_h / DECODE_FILL_SHRINK;
+    bw = bw < 1 ? 1 : bw;
+    bh = bh < 1 ? 1 : bh;
+
+    uint32_t* small = pixels_resample_region(slide->pixels, slide->w, (slide->w - cw) / 2,
+        (slide->h - ch) / 2, cw, ch, bw, bh, PIXELS_KERNEL_AREA);
+    if (!small || !pixels_blur(small, bw, bh, DECODE_FILL_RADIUS, DECODE_FILL_DIM)) {
+        free(small);
+        return EINA_FALSE;
+    }
+    uint32_t* full = pixels_resample(small, bw, bh, target_w, target_h, PIXELS_KERNEL_AREA);
+    free(small);
+    if (!full)
+        return EINA_FALSE;
+
+    int ox = (target_w - slide->w) / 2, oy = (target_h - slide->h) / 2;
+    for (int y = 0; y < slide->h; y++)
+        memcpy(full + (size_t) (oy + y) * target_w + ox, slide->pixels + (size_t) y * slide->w,
+            (size_t) slide->w * sizeof(uint32_t));
+    free(slide->pixels);
+    slide->pixels = full;
+    slide->w = target_w;
+    slide->h = target_h;
+    return EINA_TRUE;
+}
+
+// Crop of the upright image that fills the target aspect around its most
+// detailed region. Computed from a 1/8-scale decode and cached per file.
+static Eina_Bool _smart_crop(const char* path, const unsigned char* data, size_t size,
+    int orientation, int target_w, int target_h, Analysis_Rect* out)
+{
+    struct stat st;
+    if (target_w <= 1 || target_h <= 1 || stat(path, &st) != 0)
+        return EINA_FALSE;
+    double aspect = (double) target_w / target_h;
+
+    eina_lock_take(&crop_lock);
+    Crop_Entry* e = crop_cache ? eina_hash_find(crop_cache, path) : NULL;
+    Eina_Bool hit = e && e->size == (long long) st.st_size && e->mtime == (long long) st.st_mtime
+        && fabs(e->aspect - aspect) < 0.01;
+    if (hit)
+        *out = e->rect;
+    eina_lock_release(&crop_lock);
+    if (hit)
+        return EINA_TRUE;
+
+    // A 1x1 target selects the cheapest 1/8 DCT scale
+    Decoded_Slide* small = _decode_jpeg(data, size, orientation, 1, 1, NULL);
+    Eina_Bool ok = small && analysis_crop(small->pixels, small->w, small->h, aspect, out);
+    decoded_slide_free(small);
+    if (!ok)
+        return EINA_FALSE;
+
+    e = malloc(sizeof(Crop_Entry));
+    if (!e)
+        return EINA_TRUE;
+    e->size = (long long) st.st_size;
+    e->mtime = (long long) st.st_mtime;
+    e->aspect = aspect;
+    e->rect = *out;
+    eina_lock_take(&crop_lock);
+    if (crop_cache) {
+        if (eina_hash_population(crop_cache) >= DECODE_CROP_CACHE_MAX)
+            eina_hash_free_buckets(crop_cache);
+        // eina_hash_set() hands back the entry it replaced
+        free(eina_hash_set(crop_cache, path, e));
+    } else {
+        free(e);
+    }
+    eina_lock_release(&crop_lock);
+    DBG("Smart crop for %s: %.2f,%.2f %.2fx%.2f", path, out->x, out->y, out->w, out->h);
+    return EINA_TRUE;
+}
+
+// Upright size of a JPEG, from its header
+static Eina_Bool _jpeg_upright_size(
+    const unsigned char* data, size_t size, int orientation, int* w, int* h)
+{
+    Eina_Binbuf* bin = eina_binbuf_manage_new(data, size, EINA_TRUE);
+    if (!bin)
+        return EINA_FALSE;
+    Emile_Image_Load_Opts opts;
+    Emile_Image_Property prop;
+    Emile_Image_Load_Error err = EMILE_IMAGE_LOAD_ERROR_NONE;
+    memset(&opts, 0, sizeof(opts));
+    Emile_Image* img = _jpeg_open(bin, &opts, &prop, &err);
+    if (img)
+        emile_image_close(img);
+    eina_binbuf_free(bin);
+    if (!img || prop.w == 0 || prop.h == 0)
+        return EINA_FALSE;
+    *w = (int) (orientation >= 5 ? prop.h : prop.w);
+    *h = (int) (orientation >= 5 ? prop.w : prop.h);
+    return EINA_TRUE;
+}
+
+// Decode this instance's tile of a slide spread across the whole video wall.
+// The slide is fitted (or smart-cropped) to the wall as a single screen would
+// fit it; only the part under this tile is decoded, at the DCT scale for the
+// tile's share, and placed on a black buffer of the tile's size.
+static Decoded_Slide* _decode_wall_tile(const char* path, const unsigned char* data,
+    size_t size, int orientation, int target_w, int target_h)
+{
+    int wall_w = target_w * wall_cols, wall_h = target_h * wall_rows;
+    int iw, ih;
+    if (!_jpeg_upright_size(data, size, orientation, &iw, &ih))
+        return NULL;
+    Analysis_Rect base = { 0.0, 0.0, 1.0, 1.0 };
+    if (fill_screen && !_smart_crop(path, data, size, orientation, wall_w, wall_h, &base))
+        base = (Analysis_Rect) { 0.0, 0.0, 1.0, 1.0 };
+
+    // Where the slide lands on the wall, and its overlap with this tile
+    double bw = iw * base.w, bh = ih * base.h;
+    double fit = (double) wall_w / bw < (double) wall_h / bh ? wall_w / bw : wall_h / bh;
+    double dw = bw * fit, dh = bh * fit;
+    double ox = (wall_w - dw) / 2.0, oy = (wall_h - dh) / 2.0;
+    double tx = (double) wall_col * target_w, ty = (double) wall_row * target_h;
+    double x0 = tx > ox ? tx : ox, y0 = ty > oy ? ty : oy;
+    double x1 = tx + target_w < ox + dw ? tx + target_w : ox + dw;
+    double y1 = ty + target_h < oy + dh ? ty + target_h : oy + dh;
+
+    Decoded_Slide* tile = calloc(1, sizeof(Decoded_Slide));
+    if (!tile)
+        return NULL;
+    tile->pixels = malloc((size_t) target_w * target_h * sizeof(uint32_t));
+    if (!tile->pixels) {
+        free(tile);
+        return NULL;
+    }
+    for (size_t i = 0; i < (size_t) target_w * target_h; i++)
+        tile->pixels[i] = 0xff000000;
+    tile->w = target_w;
+    tile->h = target_h;
+    tile->orientation = orientation;
+    int px = (int) (x0 - tx + 0.5), py = (int) (y0 - ty + 0.5);
+    int pw = (int) (x1 - tx + 0.5) - px, ph = (int) (y1 - ty + 0.5) - py;
+    // The slide does not reach this tile: it stays black
+    if (pw < 1 || ph < 1)
+        return tile;
+
+    Analysis_Rect crop = { base.x + (x0 - ox) / dw * base.w, base.y + (y0 - oy) / dh * base.h,
+        (x1 - x0) / dw * base.w, (y1 - y0) / dh * base.h };
+    Decoded_Slide* part = _decode_jpeg(data, size, orientation, pw, ph, &crop);
+    if (!part) {
+        decoded_slide_free(tile);
+        return NULL;
+    }
+    // Unlike a whole slide, a tile's part is scaled up too: Evas shows the
+    // tile 1:1 so the parts meet at the bezels
+    const uint32_t* src = part->pixels;
+    uint32_t* scaled = NULL;
+    if (part->w != pw || part->h != ph) {
+        scaled = pixels_resample(part->pixels, part->w, part->h, pw, ph, resample_kernel);
+        if (scaled && part->w > pw)
+            pixels_sharpen(scaled, pw, ph, resample_sharpen);
+        src = scaled;
+    }
+    if (src) {
+        for (int y = 0; y < ph; y++)
+            memcpy(tile->pixels + (size_t) (py + y) * target_w + px, src + (size_t) y * pw,
+                (size_t) pw * sizeof(uint32_t));
+    }
+    free(scaled);
+    decoded_slide_free(part);
+    if (!src) {
+        decoded_slide_free(tile);
+        return NULL;
+    }
+    return tile;
+}
+
+// Decode JPEG data for a file, cropped to fill the screen when enabled
+static Decoded_Slide* _decode_for_path(const char* path, const unsigned char* data, size_t size,
+    int orientation, int target_w, int target_h)
+{
+    // Video posters stay whole: each tile plays the whole video
+    if (wall_cols * wall_rows > 1 && target_w > 1 && target_h > 1 && !is_video_file(path))
+        return _decode_wall_tile(path, data, size, orientation, target_w, target_h);
+    Analysis_Rect crop;
+    if (fill_screen && _smart_crop(path, data, size, orientation, target_w, target_h, &crop))
+        return _decode_jpeg(data, size, orientation, target_w, target_h, &crop);
+    return _decode_jpeg(data, size, orientation, target_w, target_h, NULL);
+}
+
+// Worker-side decode of a file path (JPEG, RAW preview, video poster,
+// document page or pack frame)
+static Decoded_Slide* _decode_path(const char* path, int target_w, int target_h)
+{
+    Decoded_Slide* slide = NULL;
+
+    // Rasterized at the fit size; shown whole on every tile of a wall
+    if (is_document_file(path))
+        return document_render(path, target_w, target_h);
+    // Already decoded and fitted when the pack was built
+    if (is_pack_file(path))
+        return pack_frame_get(path);
+
+    if (is_video_file(path)) {
+        unsigned char* jpeg = NULL;
+        size_t size = 0;
+        // ffmpeg has already applied any rotation
+        if (poster_extract(path, target_w, target_h, &jpeg, &size)) {
+            slide = _decode_for_path(path, jpeg, size, 1, target_w, target_h);
+            free(jpeg);
+        }
+        return slide;
+    }
+
+    if (is_raw_file(path)) {
+        unsigned char* jpeg = NULL;
+        size_t size = 0;
+        if (exif_raw_preview_get(path, &jpeg, &size)) {
+            slide = _decode_for_path(
+                path, jpeg, size, exif_orientation_get(path), target_w, target_h);
+            free(jpeg);
+        }
+        return slide;
+    }
+
+    Eina_File* f = eina_file_open(path, EINA_FALSE);
+    if (!f)
+        return NULL;
+    size_t size = eina_file_size_get(f);
+    const unsigned char* map = eina_file_map_all(f, EINA_FILE_SEQUENTIAL);
+    if (map) {
+        if (_jpeg_has_eoi(map, size)) {
+            int orientation = exif_orientation_from_jpeg(map, size);
+            slide = _decode_for_path(path, map, size, orientation, target_w, target_h);
+        } else {
+            WRN("Truncated JPEG (no EOI marker): %s", path);
+        }
+        eina_file_map_free(f, (void*) map);
+    }
+    eina_file_close(f);
+    return slide;
+}
+
+Eina_Bool decode_probe(const char* path)
+{
+    if (!path)
+        return EINA_FALSE;
+    // A 1x1 target selects the cheapest 1/8 DCT scale
+    Decoded_Slide* slide = _decode_path(path, 1, 1);
+    Eina_Bool ok = slide != NULL;
+    decoded_slide_free(slide);
+    return ok;
+}
+
+Decoded_Slide* decode_file(const char* path, int target_w, int target_h)
+{
+    if (!path)
+        return NULL;
+    Decoded_Slide* slide = _decode_path(path, target_w, target_h);
+    if (!slide)
+        return NULL;
+    _resample_to_fit(slide, target_w, target_h);
+    if (lut_lock_ready) {
+        Pixels_Lut lut;
+        eina_lock_take(&lut_lock);
+        unsigned int tag = lut_tag;
+        if (tag)
+            lut = colour_lut;
+        eina_lock_release(&lut_lock);
+        if (tag)
+            pixels_lut_apply(slide->pixels, (size_t) slide->w * slide->h, &lut);
+    }
+    return slide;
+}
+
+// Measure the tone under each overlay region. Regions are letterbox
+// fractions; the slide is shown centred and scaled to fit (or to cover in
+// fill-screen mode), so each region is mapped onto the slide and the part
+// falling on the black bars darkens the result.
+static void _measure_tones(
+    Decoded_Slide* slide, int target_w, int target_h, const Analysis_Rect* regions, int count)
+{
+    double sx = (double) target_w / slide->w, sy = (double) target_h / slide->h;
+    double scale = fill_screen ? (sx > sy ? sx : sy) : (sx < sy ? sx : sy);
+    double dw = slide->w * scale, dh = slide->h * scale;
+    double ox = (target_w - dw) / 2.0, oy = (target_h - dh) / 2.0;
+
+    for (int i = 0; i < count; i++) {
+        const Analysis_Rect* r = &regions[i];
+        double x0 = r->x * target_w, y0 = r->y * target_h;
+        double x1 = x0 + r->w * target_w, y1 = y0 + r->h * target_h;
+        double ix0 = x0 > ox ? x0 : ox, iy0 = y0 > oy ? y0 : oy;
+        double ix1 = x1 < ox + dw ? x1 : ox + dw, iy1 = y1 < oy + dh ? y1 : oy + dh;
+        Analysis_Tone* t = &slide->tones[i];
+        Analysis_Rect on_slide = { 0.0, 0.0, 0.0, 0.0 };
+        if (ix1 > ix0 && iy1 > iy0) {
+            on_slide.x = (ix0 - ox) / dw;
+            on_slide.y = (iy0 - oy) / dh;
+            on_slide.w = (ix1 - ix0) / dw;
+            on_slide.h = (iy1 - iy0) / dh;
+        }
+        analysis_tone(slide->pixels, slide->w, slide->h, &on_slide, t);
+
+        double area = (x1 - x0) * (y1 - y0);
+        double outside = area > 0.0 ? 1.0 - on_slide.w * dw * on_slide.h * dh / area : 0.0;
+        if (outside > 0.0) {
+            t->mean = (unsigned char) (t->mean * (1.0 - outside));
+            if (outside >= 0.10)
+                t->low = 0;
+            if (outside >= 0.90)
+                t->high = 0;
+            if (outside >= 0.50)
+                t->dominant = 0xff000000;
+        }
+    }
+    slide->tone_count = count;
+}
+
+static void _decode_job_run(void* data, Ecore_Thread* thread)
+{
+    Decode_Job* job = data;
+    if (ecore_thread_check(thread))
+        return;
+    double start = ecore_time_get();
+    job->result = _decode_path(job->path, job->target_w, job->target_h);
+    if (!job->result)
+        return;
+    double decoded = ecore_time_get();
+    int w = job->result->w, h = job->result->h;
+    _resample_to_fit(job->result, job->target_w, job->target_h);
+    double end = ecore_time_get();
+    job->decode_time = end - start;
+    if (job->result->w != w || job->result->h != h)
+        job->resample_time = end - decoded;
+    if (blur_fill && _compose_blur_fill(job->result, job->target_w, job->target_h)) {
+        job->fill_time = ecore_time_get() - end;
+        job->decode_time += job->fill_time;
+    }
+    if (job->lut_tag) {
+        double lut_start = ecore_time_get();
+        pixels_lut_apply(job->result->pixels, (size_t) job->result->w * job->result->h, &job->lut);
+        job->decode_time += ecore_time_get() - lut_start;
+    }
+    // Measured after the LUT: overlays sit on what is actually shown
+    if (job->tone_region_count > 0)
+        _measure_tones(job->result, job->target_w, job->target_h, job->tone_regions,
+            job->tone_region_count);
+    DBG("Decoded %s to %dx%d (orientation %d) in %.1f ms, %s resample %.1f ms", job->path,
+        job->result->w, job->result->h, job->result->orientation, job->decode_time * 1000.0,
+        pixels_kernel_name(resample_kernel), job->resample_time * 1000.0);
+}
+
+static void _slot_free(Decode_Slot* slot)
+{
+    Decode_Waiter* w;
+    EINA_LIST_FREE(slot->waiters, w)
+    {
+        free(w);
+    }
+    if (slot->job) {
+        // Let the worker finish on its own; its result is discarded
+        slot->job->slot = NULL;
+        ecore_thread_cancel(slot->job->thread);
+    }
+    decoded_slide_free(slot->slide);
+    free(slot->path);
+    free(slot);
+}
+
+// Drop least recently used slots that are neither decoding nor notifying
+static void _slots_trim(void)
+{
+    while ((int) eina_list_count(slots) > slot_limit) {
+        Eina_List* l;
+        Decode_Slot* slot;
+        Eina_List* victim = NULL;
+        EINA_LIST_REVERSE_FOREACH(slots, l, slot)
+        {
+            if (!slot->job && !slot->notifying) {
+                victim = l;
+                break;
+            }
+        }
+        if (!victim)
+            break;
+        _slot_free(eina_list_data_get(victim));
+        slots = eina_list_remove_list(slots, victim);
+    }
+}
+
+static void _decode_job_finish(void* data, Ecore_Thread* thread);
+
+// New job for slot with the current settings, attached to it but not started
+static Decode_Job* _job_new(Decode_Slot* slot)
+{
+    Decode_Job* job = calloc(1, sizeof(Decode_Job));
+    if (!job)
+        return NULL;
+    job->path = strdup(slot->path);
+    job->target_w = slot->target_w;
+    job->target_h = slot->target_h;
+    memcpy(job->tone_regions, tone_regions, sizeof(tone_regions));
+    job->tone_region_count = tone_region_count;
+    if (lut_tag)
+        job->lut = colour_lut;
+    job->lut_tag = lut_tag;
+    job->slot = slot;
+    slot->job = job;
+    return job;
+}
+
+// If no worker can be started the cancel callback runs synchronously, which
+// notifies the slot's waiters and may drop the slot
+static void _job_launch(Decode_Job* job)
+{
+    Ecore_Thread* thread
+        = ecore_thread_run(_decode_job_run, _decode_job_finish, _decode_job_finish, job);
+    if (thread)
+        job->thread = thread;
+}
+
+static void _job_free(Decode_Job* job)
+{
+    decoded_slide_free(job->result);
+    free(job->path);
+    free(job);
+}
+
+// Shared end/cancel handler: publish the result and notify waiters
+static void _decode_job_finish(void* data, Ecore_Thread* thread EINA_UNUSED)
+{
+    Decode_Job* job = data;
+    Decode_Slot* slot = job->slot;
+
+    if (job->result) {
+        stats.decoded++;
+        stats.decode_time += job->decode_time;
+        if (job->resample_time > 0.0) {
+            stats.resampled++;
+            stats.resample_time += job->resample_time;
+        }
+        if (job->fill_time > 0.0) {
+            stats.filled++;
+            stats.fill_time += job->fill_time;
+        }
+    }
+
+    if (slot) {
+        slot->job = NULL;
+        // The colour LUT changed while this job ran: its waiters wait for a
+        // run with the new one
+        if (job->result && job->lut_tag != lut_tag) {
+            _job_free(job);
+            Decode_Job* again = _job_new(slot);
+            if (again)
+                _job_launch(again);
+            return;
+        }
+        decoded_slide_free(slot->slide);
+        slot->slide = job->result;
+        slot->lut_tag = job->lut_tag;
+        job->result = NULL;
+        if (!slot->slide)
+            WRN("Background decode failed: %s", slot->path);
+
+        // Callbacks may issue new requests; keep this slot pinned meanwhile
+        slot->notifying = EINA_TRUE;
+        Eina_List* waiters = slot->waiters;
+        slot->waiters = NULL;
+        Decode_Waiter* w;
+        EINA_LIST_FREE(waiters, w)
+        {
+            if (w->cb)
+                w->cb((void*) w->data, slot->path, slot->slide);
+            free(w);
+        }
+        slot->notifying = EINA_FALSE;
+
+        // Failed decodes are not cached so a later request retries
+        if (!slot->slide) {
+            slots = eina_list_remove(slots, slot);
+            _slot_free(slot);
+        }
+        _slots_trim();
+    }
+
+    _job_free(job);
+}
+
+// Find a slot for path at the given target size, decoded with the current
+// settings, and mark it most recently used. Stale slots age out of the list.
+static Decode_Slot* _slot_find(const char* path, int target_w, int target_h)
+{
+    Eina_List* l;
+    Decode_Slot* slot;
+    EINA_LIST_FOREACH(slots, l, slot)
+    {
+        if (slot->target_w == target_w && slot->target_h == target_h
+            && slot->gen == settings_gen && strcmp(slot->path, path) == 0) {
+            slots = eina_list_promote_list(slots, l);
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+const Decoded_Slide* decode_cache_get(const char* path, int target_w, int target_h)
+{
+    if (!path)
+        return NULL;
+    Decode_Slot* slot = _slot_find(path, target_w, target_h);
+    return slot && slot->lut_tag == lut_tag ? slot->slide : NULL;
+}
+
+void decode_request(
+    const char* path, int target_w, int target_h, Decode_Done_Cb cb, const void* data)
+{
+    if (!path)
+        return;
+
+    Decode_Slot* slot = _slot_find(path, target_w, target_h);
+    if (slot && slot->slide && slot->lut_tag == lut_tag) {
+        if (cb)
+            cb((void*) data, path, slot->slide);
+        return;
+    }
+
+    Decode_Job* job = NULL;
+    if (!slot) {
+        slot = calloc(1, sizeof(Decode_Slot));
+        if (slot) {
+            slot->path = strdup(path);
+            slot->target_w = target_w;
+            slot->target_h = target_h;
+            slot->gen = settings_gen;
+            job = _job_new(slot);
+        }
+        if (!job) {
+            if (slot)
+                free(slot->path);
+            free(slot);
+            if (cb)
+                cb((void*) data, path, NULL);
+            return;
+        }
+        slots = eina_list_prepend(slots, slot);
+    } else if (!slot->job) {
+        // Processed with an older colour LUT
+        job = _job_new(slot);
+    }
+
+    if (cb) {
+        Decode_Waiter* w = calloc(1, sizeof(Decode_Waiter));
+        if (w) {
+            w->cb = cb;
+            w->data = data;
+            slot->waiters = eina_list_append(slot->waiters, w);
+        }
+    }
+
+    if (job) {
+        _slots_trim();
+        // Waiters are registered first, so a failed start still reaches them
+        _job_launch(job);
+    }
+}
+
+void decode_prefetch(const char* path, int target_w, int target_h)
+{
+    decode_request(path, target_w, target_h, NULL, NULL);
+}
+
+void decode_init(void)
+{
+    emile_init();
+    memset(&stats, 0, sizeof(stats));
+    if (!crop_lock_ready)
+        crop_lock_ready = eina_lock_new(&crop_lock);
+    if (!lut_lock_ready)
+        lut_lock_ready = eina_lock_new(&lut_lock);
+    eina_lock_take(&crop_lock);
+    if (!crop_cache)
+        crop_cache = eina_hash_string_superfast_new(free);
+    eina_lock_release(&crop_lock);
+}
+
+void decode_shutdown(void)
+{
+    Decode_Slot* slot;
+    EINA_LIST_FREE(slots, slot)
+    {
+        _slot_free(slot);
+    }
+    if (stats.decoded > 0)
+        INF("Decode stats: %u slides, %.1f ms average; %u resampled (%s, %s), %.1f ms average",
+            stats.decoded, stats.decode_time * 1000.0 / stats.decoded, stats.resampled,
+            pixels_kernel_name(resample_kernel), pixels_simd_name(),
+            stats.resampled ? stats.resample_time * 1000.0 / stats.resampled : 0.0);
+    if (stats.filled > 0)
+        INF("Blurred fill: %u slides, %.1f ms average", stats.filled,
+            stats.fill_time * 1000.0 / stats.filled);
+    eina_lock_take(&crop_lock);
+    if (crop_cache) {
+        eina_hash_free(crop_cache);
+        crop_cache = NULL;
+    }
+    eina_lock_release(&crop_lock);
+    emile_shutdown();
+}
+
+Eina_Bool decode_set_resample(const char* kernel, double sharpen)
+{
+    int k = pixels_kernel_parse(kernel);
+    if (k < 0)
+        return EINA_FALSE;
+    if (sharpen < 0.0)
+        sharpen = 0.0;
+    if (sharpen > DECODE_SHARPEN_MAX)
+        sharpen = DECODE_SHARPEN_MAX;
+    if ((Pixels_Kernel) k != resample_kernel || sharpen != resample_sharpen)
+        settings_gen++;
+    resample_kernel = (Pixels_Kernel) k;
+    resample_sharpen = sharpen;
+    INF("Resampling decoded slides with the %s kernel (%s), sharpen %.2f",
+        pixels_kernel_name(resample_kernel), pixels_simd_name(), resample_sharpen);
+    return EINA_TRUE;
+}
+
+const char* decode_get_resample(void)
+{
+    return pixels_kernel_name(resample_kernel);
+}
+
+void decode_set_blur_fill(Eina_Bool enabled)
+{
+    if (!enabled != !blur_fill)
+        settings_gen++;
+    blur_fill = enabled;
+}
+
+Eina_Bool decode_get_blur_fill(void)
+{
+    return blur_fill;
+}
+
+void decode_set_fill_screen(Eina_Bool enabled)
+{
+    if (!enabled != !fill_screen)
+        settings_gen++;
+    fill_screen = enabled;
+}
+
+Eina_Bool decode_get_fill_screen(void)
+{
+    return fill_screen;
+}
+
+void decode_set_cache_slots(int slots)
+{
+    slot_limit = slots > 1 ? slots : 1;
+    _slots_trim();
+}
+
+void decode_set_wall(int cols, int rows, int col, int row)
+{
+    if (cols < 1 || rows < 1 || col < 0 || row < 0 || col >= cols || row >= rows) {
+        cols = rows = 1;
+        col = row = 0;
+    }
+    if (cols != wall_cols || rows != wall_rows || col != wall_col || row != wall_row)
+        settings_gen++;
+    wall_cols = cols;
+    wall_rows = rows;
+    wall_col = col;
+    wall_row = row;
+}
+
+void decode_set_tone_regions(const Analysis_Rect* regions, int count)
+{
+    if (!regions || count < 0)
+        count = 0;
+    if (count > DECODE_TONE_REGIONS_MAX)
+        count = DECODE_TONE_REGIONS_MAX;
+    if (count > 0)
+        memcpy(tone_regions, regions, (size_t) count * sizeof(Analysis_Rect));
+    tone_region_count = count;
+}
+
+void decode_set_lut(const Pixels_Lut* lut)
+{
+    if (!lut_lock_ready)
+        lut_lock_ready = eina_lock_new(&lut_lock);
+    eina_lock_take(&lut_lock);
+    if (lut) {
+        colour_lut = *lut;
+        lut_tag = lut_tag_next++;
+    } else {
+        lut_tag = 0;
+    }
+    eina_lock_release(&lut_lock);
+
+    // Only the resident slides are processed again. A worker that cannot
+    // start drops its slot, so take the list apart from the iteration.
+    Eina_List* stale = NULL;
+    Eina_List* l;
+    Decode_Slot* slot;
+    EINA_LIST_FOREACH(slots, l, slot)
+    {
+        if (slot->slide && !slot->job && slot->lut_tag != lut_tag)
+            stale = eina_list_append(stale, slot);
+    }
+    EINA_LIST_FREE(stale, slot)
+    {
+        if (!eina_list_data_find(slots, slot) || slot->job)
+            continue;
+        Decode_Job* job = _job_new(slot);
+        if (job)
+            _job_launch(job);
+    }
+}
+
+void decode_stats_get(Decode_Stats* out)
+{
+    if (out)
+        *out = stats;
+}
@@ -0,0 +1,124 @@
+#ifndef DECODE_H
+#define DECODE_H
+
+#include "common.h"
+#include "analysis.h"
+#include "pixels.h"
+#include <stdint.h>
+
+// Background decode pipeline: JPEGs (and RAW previews) are decoded on
+// Ecore_Thread workers into upright ARGB8888 buffers resampled to the exact
+// letterbox fit rectangle, then handed to Evas on the main loop so every
+// frame is a 1:1 copy.
+
+// Overlay regions whose tone is measured for each slide
+#define DECODE_TONE_REGIONS_MAX 4
+
+// A decoded slide ready to be displayed. With the blurred fill enabled the
+// buffer covers the whole letterbox: the photo sits centred on a blurred,
+// dimmed copy of itself instead of black bars.
+//
+// tones describe what is under each overlay region set with
+// decode_set_tone_regions() when the decode started, as shown on screen.
+typedef struct _Decoded_Slide {
+    uint32_t* pixels; // ARGB8888, already upright
+    int w;
+    int h;
+    int orientation; // EXIF orientation that was applied (1-8)
+    Analysis_Tone tones[DECODE_TONE_REGIONS_MAX];
+    int tone_count; // 0 when no regions were set
+} Decoded_Slide;
+
+// Completion callback, run on the main loop. slide is NULL when decoding
+// failed; it is owned by the decode cache and only valid during the call.
+typedef void (*Decode_Done_Cb)(void* data, const char* path, const Decoded_Slide* slide);
+
+// Pipeline initialization and cleanup
+void decode_init(void);
+void decode_shutdown(void);
+
+// Whether a file can go through the background decoder (JPEG, RAW, pack
+// frames, and PDF pages and SVGs when poppler is installed)
+Eina_Bool decode_is_supported(const char* path);
+
+// Return a ready slide from the prefetch cache, or NULL if not decoded yet
+const Decoded_Slide* decode_cache_get(const char* path, int target_w, int target_h);
+
+// Start (or join) a background decode for the given letterbox size. cb may
+// run synchronously when the slide is already cached. Videos (when
+// poster_is_supported()) may also be requested: their slide is a poster
+// frame, cached like any other.
+void decode_request(
+    const char* path, int target_w, int target_h, Decode_Done_Cb cb, const void* data);
+
+// Warm the cache for an upcoming slide without waiting for it
+void decode_prefetch(const char* path, int target_w, int target_h);
+
+// Check synchronously that a file decodes, at the smallest DCT scale. Safe to
+// call on any thread; used to re-probe quarantined files.
+Eina_Bool decode_probe(const char* path);
+
+// Decode a JPEG held in memory and apply an EXIF orientation. Safe to call on
+// any thread; used directly on the main loop only for small embedded previews.
+Decoded_Slide* decode_jpeg_memory(
+    const unsigned char* data, size_t size, int orientation, int target_w, int target_h);
+
+// Decode a file as the background decoder would, without blurred fill, and
+// resample it to its fit rectangle. The colour LUT current when the decode
+// finishes is applied. Safe to call on any thread and bypasses the cache;
+// used for streams of frames.
+Decoded_Slide* decode_file(const char* path, int target_w, int target_h);
+
+void decoded_slide_free(Decoded_Slide* slide);
+
+// Worker timings, accumulated on the main loop as slides complete
+typedef struct {
+    unsigned int decoded;   // slides decoded by workers
+    unsigned int resampled; // slides resampled to their fit rectangle
+    double decode_time;     // seconds spent decoding (including resampling)
+    double resample_time;   // seconds spent resampling and sharpening
+    unsigned int filled;    // slides composed onto a blurred fill
+    double fill_time;       // seconds spent building blurred fills
+} Decode_Stats;
+
+// Select the resampling kernel ("area" or "lanczos") and unsharp amount
+// (0 = off, up to 1). Takes effect for decodes started afterwards; returns
+// EINA_FALSE for an unknown kernel name.
+Eina_Bool decode_set_resample(const char* kernel, double sharpen);
+const char* decode_get_resample(void);
+
+// Compose slides that do not fill the letterbox onto a blurred, dimmed copy
+// of themselves. Takes effect for decodes started afterwards.
+void decode_set_blur_fill(Eina_Bool enabled);
+Eina_Bool decode_get_blur_fill(void);
+
+// Crop slides to the letterbox aspect around their most detailed region
+// instead of fitting them inside it. The crop is chosen from an edge-energy
+// map of a 1/8-scale decode, cached per file, and only that region is then
+// decoded at full scale. Takes effect for decodes started afterwards.
+void decode_set_fill_screen(Eina_Bool enabled);
+Eina_Bool decode_get_fill_screen(void);
+
+// Number of decoded slides kept resident, for callers that are not windows
+// (export and pack builds keep their lookahead). The slideshow keeps the
+// default of three: current, next and one spare.
+void decode_set_cache_slots(int slots);
+
+// Decode only tile col,row of slides spread over a cols x rows video wall of
+// screens the size of the target. Slides come out at the full target size,
+// with black where the slide does not reach this tile. 1x1 turns this off;
+// takes effect for decodes started afterwards.
+void decode_set_wall(int cols, int rows, int col, int row);
+
+// Regions of the letterbox (fractions) covered by overlays. Workers measure
+// the tone of each for slides decoded afterwards; count 0 turns this off.
+void decode_set_tone_regions(const Analysis_Rect* regions, int count);
+
+// Map the colour channels of slides through lut (NULL for none). Cached
+// slides remember the LUT they were processed with; the resident ones are
+// decoded again in the background, and requests wait for the new version.
+void decode_set_lut(const Pixels_Lut* lut);
+
+void decode_stats_get(Decode_Stats* out);
+
+#endif /* DECODE_H */
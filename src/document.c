@@ -0,0 +1,321 @@
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "document.h"
+#include "media.h"
+
+// Largest pdfinfo or rsvg-convert output read back
+#define DOCUMENT_INFO_MAX_BYTES (16 * 1024 * 1024)
+// PPM header allowance on top of the RGB pixels
+#define DOCUMENT_PPM_HEADER 64
+
+// Page count for one version of a PDF
+typedef struct {
+    long long size;
+    long long mtime;
+    int pages;          // -1 until first counted
+    Eina_Bool counting; // pdfinfo running on a worker
+} Page_Count;
+
+// pdfinfo run for one version of a PDF
+typedef struct {
+    char* file;
+    long long size;
+    long long mtime;
+    int pages;
+} Page_Job;
+
+static int poppler_found = -1; // unknown until first asked
+static int rsvg_found = -1;
+// path -> Page_Count*, main loop only
+static Eina_Hash* page_counts = NULL;
+static Eina_List* count_jobs = NULL; // in-flight Ecore_Thread*
+static Eina_Bool count_sync = EINA_FALSE;
+
+Eina_Bool document_is_supported(const char* path)
+{
+    if (!path || !is_document_file(path))
+        return EINA_FALSE;
+    if (poppler_found < 0) {
+        poppler_found = common_in_path("pdftoppm") && common_in_path("pdfinfo");
+        if (!poppler_found)
+            INF("pdftoppm/pdfinfo not found: PDF documents are not shown");
+    }
+    if (!poppler_found || !eina_str_has_extension(path, ".svg"))
+        return poppler_found;
+    if (rsvg_found < 0) {
+        rsvg_found = common_in_path("rsvg-convert");
+        if (!rsvg_found)
+            INF("rsvg-convert not found: SVG documents are left to the Evas loader");
+    }
+    return rsvg_found;
+}
+
+char* document_source(const char* path, int* page)
+{
+    if (!path || !is_document_file(path))
+        return NULL;
+    const char* hash = strrchr(path, '#');
+    if (eina_str_has_extension(path, ".pdf") || eina_str_has_extension(path, ".svg") || !hash) {
+        *page = eina_str_has_extension(path, ".svg") ? 0 : 1;
+        return strdup(path);
+    }
+    *page = atoi(hash + 1);
+    char* file = malloc((size_t) (hash - path) + 1);
+    if (file) {
+        memcpy(file, path, (size_t) (hash - path));
+        file[hash - path] = '\0';
+    }
+    return file;
+}
+
+// Value of the first pdfinfo line starting with key, or NULL
+static const char* _info_field(const char* info, const char* key)
+{
+    size_t len = strlen(key);
+    for (const char* line = info; line && *line; line = strchr(line, '\n')) {
+        if (*line == '\n')
+            line++;
+        if (strncmp(line, key, len) == 0)
+            return line + len;
+    }
+    return NULL;
+}
+
+static int _pdf_page_count(const char* file)
+{
+    char* const argv[] = { "pdfinfo", (char*) file, NULL };
+    unsigned char* out = NULL;
+    size_t size = 0;
+    if (!common_run_capture(argv, DOCUMENT_INFO_MAX_BYTES, &out, &size))
+        return 0;
+    const char* pages = _info_field((const char*) out, "Pages:");
+    int count = pages ? atoi(pages) : 0;
+    free(out);
+    return count > 0 ? count : 0;
+}
+
+static void _count_run(void* data, Ecore_Thread* thread)
+{
+    Page_Job* job = data;
+    if (!ecore_thread_check(thread))
+        job->pages = _pdf_page_count(job->file);
+}
+
+static void _page_job_free(Page_Job* job)
+{
+    free(job->file);
+    free(job);
+}
+
+static void _count_end(void* data, Ecore_Thread* thread)
+{
+    Page_Job* job = data;
+    count_jobs = eina_list_remove(count_jobs, thread);
+    Page_Count* pc = page_counts ? eina_hash_find(page_counts, job->file) : NULL;
+    if (pc) {
+        pc->counting = EINA_FALSE;
+        pc->size = job->size;
+        pc->mtime = job->mtime;
+        pc->pages = job->pages;
+        DBG("%s: %d pages", job->file, pc->pages);
+        // List the pages on the next refresh
+        media_cache_invalidate();
+    }
+    _page_job_free(job);
+}
+
+static void _count_cancel(void* data, Ecore_Thread* thread)
+{
+    Page_Job* job = data;
+    count_jobs = eina_list_remove(count_jobs, thread);
+    Page_Count* pc = page_counts ? eina_hash_find(page_counts, job->file) : NULL;
+    if (pc)
+        pc->counting = EINA_FALSE;
+    _page_job_free(job);
+}
+
+int document_page_count(const char* file)
+{
+    struct stat st;
+    if (!file || stat(file, &st) != 0)
+        return 0;
+    if (!page_counts)
+        page_counts = eina_hash_string_superfast_new(free);
+    Page_Count* pc = eina_hash_find(page_counts, file);
+    if (pc && pc->size == (long long) st.st_size && pc->mtime == (long long) st.st_mtime)
+        return pc->pages;
+    if (!pc) {
+        pc = calloc(1, sizeof(Page_Count));
+        if (!pc)
+            return 0;
+        pc->pages = -1;
+        eina_hash_add(page_counts, file, pc);
+    }
+    if (count_sync) {
+        pc->size = (long long) st.st_size;
+        pc->mtime = (long long) st.st_mtime;
+        pc->pages = _pdf_page_count(file);
+        DBG("%s: %d pages", file, pc->pages);
+        return pc->pages;
+    }
+    // Until pdfinfo answers, a changed file keeps its previous count
+    if (pc->counting)
+        return pc->pages;
+    Page_Job* job = calloc(1, sizeof(Page_Job));
+    if (!job)
+        return pc->pages;
+    job->file = strdup(file);
+    job->size = (long long) st.st_size;
+    job->mtime = (long long) st.st_mtime;
+    pc->counting = EINA_TRUE;
+    Ecore_Thread* thread = ecore_thread_run(_count_run, _count_end, _count_cancel, job);
+    if (thread)
+        count_jobs = eina_list_append(count_jobs, thread);
+    return pc->pages;
+}
+
+// Size in points of a page as displayed (crop box, after its /Rotate)
+static Eina_Bool _page_size(const char* file, int page, double* w, double* h)
+{
+    char num[16];
+    snprintf(num, sizeof(num), "%d", page);
+    char* const argv[] = { "pdfinfo", "-f", num, "-l", num, (char*) file, NULL };
+    unsigned char* out = NULL;
+    size_t size = 0;
+    if (!common_run_capture(argv, DOCUMENT_INFO_MAX_BYTES, &out, &size))
+        return EINA_FALSE;
+    char key[32];
+    snprintf(key, sizeof(key), "Page %4d size:", page);
+    const char* dims = _info_field((const char*) out, key);
+    snprintf(key, sizeof(key), "Page %4d rot:", page);
+    const char* rot = _info_field((const char*) out, key);
+    Eina_Bool ok = dims && sscanf(dims, "%lf x %lf", w, h) == 2 && *w > 0.0 && *h > 0.0;
+    if (ok && rot && (abs(atoi(rot)) % 180) == 90) {
+        double t = *w;
+        *w = *h;
+        *h = t;
+    }
+    free(out);
+    return ok;
+}
+
+// Binary PPM (as written by pdftoppm) to an upright ARGB8888 slide
+static Decoded_Slide* _ppm_to_slide(const unsigned char* data, size_t size)
+{
+    int w = 0, h = 0, maxval = 0, n = 0;
+    if (sscanf((const char*) data, "P6 %d %d %d%n", &w, &h, &maxval, &n) != 3 || w <= 0
+        || h <= 0 || maxval != 255)
+        return NULL;
+    // A single whitespace byte separates the header from the samples
+    const unsigned char* rgb = data + n + 1;
+    size_t count = (size_t) w * h;
+    if ((size_t) n + 1 + count * 3 > size)
+        return NULL;
+    Decoded_Slide* slide = calloc(1, sizeof(Decoded_Slide));
+    if (!slide)
+        return NULL;
+    slide->pixels = malloc(count * sizeof(uint32_t));
+    if (!slide->pixels) {
+        free(slide);
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++, rgb += 3)
+        slide->pixels[i] = 0xff000000u | (uint32_t) rgb[0] << 16 | (uint32_t) rgb[1] << 8 | rgb[2];
+    slide->w = w;
+    slide->h = h;
+    slide->orientation = 1;
+    return slide;
+}
+
+static Decoded_Slide* _render_pdf(const char* file, int page, int target_w, int target_h)
+{
+    double pw, ph;
+    if (!_page_size(file, page, &pw, &ph))
+        return NULL;
+    double fit = 1.0;
+    if (target_w > 0 && target_h > 0)
+        fit = fmin((double) target_w / pw, (double) target_h / ph);
+    int w = (int) (pw * fit + 0.5), h = (int) (ph * fit + 0.5);
+    if (w < 1)
+        w = 1;
+    if (h < 1)
+        h = 1;
+
+    char num[16], sx[16], sy[16];
+    snprintf(num, sizeof(num), "%d", page);
+    snprintf(sx, sizeof(sx), "%d", w);
+    snprintf(sy, sizeof(sy), "%d", h);
+    // No output root: the page is written to stdout
+    char* const argv[] = { "pdftoppm", "-f", num, "-l", num, "-singlefile", "-cropbox",
+        "-scale-to-x", sx, "-scale-to-y", sy, (char*) file, NULL };
+    unsigned char* ppm = NULL;
+    size_t size = 0;
+    // pdftoppm rounds the resolution, so leave room for a pixel either way
+    size_t max = (size_t) (w + 2) * (h + 2) * 3 + DOCUMENT_PPM_HEADER;
+    if (!common_run_capture(argv, max, &ppm, &size))
+        return NULL;
+    Decoded_Slide* slide = _ppm_to_slide(ppm, size);
+    free(ppm);
+    return slide;
+}
+
+// Convert an SVG to a one-page PDF in a temporary file, rendered as above
+static Decoded_Slide* _render_svg(const char* file, int target_w, int target_h)
+{
+    char* const argv[] = { "rsvg-convert", "-f", "pdf", (char*) file, NULL };
+    unsigned char* pdf = NULL;
+    size_t size = 0;
+    if (!common_run_capture(argv, DOCUMENT_INFO_MAX_BYTES, &pdf, &size))
+        return NULL;
+    Eina_Tmpstr* tmp = NULL;
+    int fd = eina_file_mkstemp("eslide-svg-XXXXXX.pdf", &tmp);
+    Decoded_Slide* slide = NULL;
+    if (fd >= 0) {
+        Eina_Bool written = write(fd, pdf, size) == (ssize_t) size;
+        close(fd);
+        if (written)
+            slide = _render_pdf(tmp, 1, target_w, target_h);
+        unlink(tmp);
+        eina_tmpstr_del(tmp);
+    }
+    free(pdf);
+    return slide;
+}
+
+Decoded_Slide* document_render(const char* path, int target_w, int target_h)
+{
+    int page = 0;
+    char* file = document_source(path, &page);
+    if (!file)
+        return NULL;
+    double start = ecore_time_get();
+    Decoded_Slide* slide = page > 0 ? _render_pdf(file, page, target_w, target_h)
+                                    : _render_svg(file, target_w, target_h);
+    if (slide)
+        DBG("Rasterized %s to %dx%d in %.1f ms", path, slide->w, slide->h,
+            (ecore_time_get() - start) * 1000.0);
+    else
+        WRN("Could not rasterize %s", path);
+    free(file);
+    return slide;
+}
+
+void document_set_sync_count(Eina_Bool sync)
+{
+    count_sync = sync;
+}
+
+void document_shutdown(void)
+{
+    // Cancelled counts finish on their own and find no cache to fill
+    Ecore_Thread* thread;
+    EINA_LIST_FREE(count_jobs, thread)
+    {
+        ecore_thread_cancel(thread);
+    }
+    if (page_counts) {
+        eina_hash_free(page_counts);
+        page_counts = NULL;
+    }
+}
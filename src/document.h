@@ -0,0 +1,38 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include "decode.h"
+
+// PDF and SVG slides. Every page of a PDF is a slide of its own, listed in
+// the catalog as "<file>.pdf#<page>"; an SVG is one slide. Pages are
+// rasterized by poppler (pdftoppm, with pdfinfo for the page geometry) at
+// exactly the letterbox fit size, on the background decoder's workers, so
+// they land in the decode cache like photos and the vector rendering is paid
+// for once, before the transition. SVGs are converted to a one-page PDF by
+// rsvg-convert first, so both are rendered by the same code.
+
+// Whether path is a document and the tools to rasterize it are on PATH
+Eina_Bool document_is_supported(const char* path);
+
+// Number of pages in a PDF file, 0 when it cannot be read and -1 while it is
+// first being counted. pdfinfo runs on a worker once per version of the file;
+// when it answers, the media cache is invalidated so the next refresh lists
+// the pages. Until then a changed file keeps its previous count. Call it on
+// the main loop.
+int document_page_count(const char* file);
+
+// Count pages on the calling thread instead, for headless runs that scan the
+// catalog once before the main loop runs
+void document_set_sync_count(Eina_Bool sync);
+
+// Split a catalog path into its file (malloc'd) and 1-based page, 0 for a
+// whole SVG. NULL when path is not a document.
+char* document_source(const char* path, int* page);
+
+// Rasterize a page fitted inside target_w x target_h (its size at 72 dpi for
+// 0x0). Blocks on poppler, so run it on a worker.
+Decoded_Slide* document_render(const char* path, int target_w, int target_h);
+
+void document_shutdown(void);
+
+#endif /* DOCUMENT_H */
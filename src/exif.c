@@ -0,0 +1,471 @@
+#include "exif.h"
+
+// JPEG markers we care about while walking the header segments
+#define JPEG_SOI 0xD8
+#define JPEG_EOI 0xD9
+#define JPEG_SOS 0xDA
+#define JPEG_APP1 0xE1
+#define JPEG_APP2 0xE2
+// Start-of-frame markers are 0xC0-0xCF except DHT, JPG and DAC
+#define JPEG_IS_SOF(m) ((m) >= 0xC0 && (m) <= 0xCF && (m) != 0xC4 && (m) != 0xC8 && (m) != 0xCC)
+
+// TIFF tags used to locate embedded previews
+#define TAG_JPEG_OFFSET 0x0201 // JPEGInterchangeFormat
+#define TAG_JPEG_LENGTH 0x0202 // JPEGInterchangeFormatLength
+#define TAG_MP_ENTRY 0xB002    // MPF image list
+#define TAG_COMPRESSION 0x0103
+#define TAG_STRIP_OFFSETS 0x0111
+#define TAG_STRIP_BYTE_COUNTS 0x0117
+#define TAG_SUB_IFDS 0x014A
+#define TAG_ORIENTATION 0x0112
+
+// TIFF compression codes that wrap a JPEG stream (old-style and new-style)
+#define TIFF_COMPRESSION_OJPEG 6
+#define TIFF_COMPRESSION_JPEG 7
+
+// Upper bound on IFDs visited in a RAW file, guards against offset loops
+#define RAW_MAX_IFDS 32
+
+// Fujifilm RAF: big-endian JPEG offset/length at fixed header positions
+#define RAF_MAGIC "FUJIFILMCCD-RAW "
+#define RAF_JPEG_OFFSET_POS 84
+#define RAF_JPEG_LENGTH_POS 88
+
+// MPF image type codes for preview images (CIPA DC-007)
+#define MP_TYPE_LARGE_THUMB_VGA 0x010001
+#define MP_TYPE_LARGE_THUMB_FHD 0x010002
+
+// Bounds-checked view over a TIFF structure (EXIF APP1, MPF APP2 or a RAW file)
+typedef struct {
+    const unsigned char* base; // start of the TIFF header
+    size_t size;               // bytes available from base
+    Eina_Bool big_endian;
+} Tiff_View;
+
+static unsigned int _rd16(const Tiff_View* t, size_t off)
+{
+    if (off + 2 > t->size)
+        return 0;
+    const unsigned char* p = t->base + off;
+    return t->big_endian ? (unsigned int) ((p[0] << 8) | p[1])
+                         : (unsigned int) ((p[1] << 8) | p[0]);
+}
+
+static unsigned int _rd32(const Tiff_View* t, size_t off)
+{
+    if (off + 4 > t->size)
+        return 0;
+    const unsigned char* p = t->base + off;
+    if (t->big_endian)
+        return ((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16)
+            | ((unsigned int) p[2] << 8) | p[3];
+    return ((unsigned int) p[3] << 24) | ((unsigned int) p[2] << 16) | ((unsigned int) p[1] << 8)
+        | p[0];
+}
+
+// Validate the "II*\0" / "MM\0*" header and set byte order
+static Eina_Bool _tiff_view_init(Tiff_View* t, const unsigned char* base, size_t size)
+{
+    if (!base || size < 8)
+        return EINA_FALSE;
+    t->base = base;
+    t->size = size;
+    if (base[0] == 'I' && base[1] == 'I')
+        t->big_endian = EINA_FALSE;
+    else if (base[0] == 'M' && base[1] == 'M')
+        t->big_endian = EINA_TRUE;
+    else
+        return EINA_FALSE;
+    return _rd16(t, 2) == 42;
+}
+
+// Look up a single SHORT/LONG tag value in the IFD at offset ifd
+static Eina_Bool _tiff_ifd_find(const Tiff_View* t, size_t ifd, unsigned int tag,
+    unsigned int* value, unsigned int* count)
+{
+    unsigned int n = _rd16(t, ifd);
+    if (n == 0 || ifd + 2 + (size_t) n * 12 > t->size)
+        return EINA_FALSE;
+    for (unsigned int i = 0; i < n; i++) {
+        size_t e = ifd + 2 + (size_t) i * 12;
+        if (_rd16(t, e) != tag)
+            continue;
+        unsigned int type = _rd16(t, e + 2);
+        if (count)
+            *count = _rd32(t, e + 4);
+        // SHORT values are left-justified in the 4-byte value field
+        *value = (type == 3) ? _rd16(t, e + 8) : _rd32(t, e + 8);
+        return EINA_TRUE;
+    }
+    return EINA_FALSE;
+}
+
+// Offset of the IFD following the one at ifd (0 when there is none)
+static size_t _tiff_next_ifd(const Tiff_View* t, size_t ifd)
+{
+    unsigned int n = _rd16(t, ifd);
+    return _rd32(t, ifd + 2 + (size_t) n * 12);
+}
+
+// Check that [off, off+len) lies inside the file and starts with a JPEG SOI
+static Eina_Bool _is_jpeg_at(const unsigned char* file, size_t file_size, size_t off, size_t len)
+{
+    if (len < 4 || off >= file_size || len > file_size - off)
+        return EINA_FALSE;
+    return file[off] == 0xFF && file[off + 1] == JPEG_SOI;
+}
+
+// EXIF IFD1 thumbnail: offsets are relative to the TIFF header inside APP1
+static void _scan_exif_thumbnail(const unsigned char* file, size_t file_size, size_t tiff_off,
+    size_t tiff_len, size_t* best_off, size_t* best_len)
+{
+    Tiff_View t;
+    if (!_tiff_view_init(&t, file + tiff_off, tiff_len))
+        return;
+    size_t ifd0 = _rd32(&t, 4);
+    size_t ifd1 = ifd0 ? _tiff_next_ifd(&t, ifd0) : 0;
+    if (!ifd1)
+        return;
+    unsigned int off = 0, len = 0;
+    if (!_tiff_ifd_find(&t, ifd1, TAG_JPEG_OFFSET, &off, NULL)
+        || !_tiff_ifd_find(&t, ifd1, TAG_JPEG_LENGTH, &len, NULL))
+        return;
+    if (len > *best_len && _is_jpeg_at(file, file_size, tiff_off + off, len)) {
+        *best_off = tiff_off + off;
+        *best_len = len;
+    }
+}
+
+// MPF (APP2) large thumbnails: offsets are relative to the MP header and
+// usually point past the primary image, so the whole file must be mapped
+static void _scan_mpf_previews(const unsigned char* file, size_t file_size, size_t mp_off,
+    size_t* best_off, size_t* best_len)
+{
+    Tiff_View t;
+    if (!_tiff_view_init(&t, file + mp_off, file_size - mp_off))
+        return;
+    size_t ifd0 = _rd32(&t, 4);
+    unsigned int entries_off = 0, entries_len = 0;
+    if (!ifd0 || !_tiff_ifd_find(&t, ifd0, TAG_MP_ENTRY, &entries_off, &entries_len))
+        return;
+    for (unsigned int i = 1; i < entries_len / 16; i++) {
+        size_t e = entries_off + (size_t) i * 16;
+        unsigned int type = _rd32(&t, e) & 0x00FFFFFF;
+        unsigned int len = _rd32(&t, e + 4);
+        unsigned int off = _rd32(&t, e + 8);
+        if (type != MP_TYPE_LARGE_THUMB_VGA && type != MP_TYPE_LARGE_THUMB_FHD)
+            continue;
+        if (len > *best_len && _is_jpeg_at(file, file_size, mp_off + off, len)) {
+            *best_off = mp_off + off;
+            *best_len = len;
+        }
+    }
+}
+
+// Only Huffman-coded (baseline/extended/progressive) JPEGs are displayable.
+// RAW sensor data is often stored as lossless JPEG (SOF3) and must be skipped.
+static Eina_Bool _is_lossy_jpeg(const unsigned char* p, size_t len)
+{
+    size_t pos = 2;
+    while (pos + 4 <= len) {
+        if (p[pos] != 0xFF)
+            return EINA_FALSE;
+        unsigned char marker = p[pos + 1];
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+        if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2)
+            return EINA_TRUE;
+        if ((marker >= 0xC3 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8
+                && marker != 0xCC)
+            || marker == JPEG_SOS || marker == JPEG_EOI)
+            return EINA_FALSE;
+        pos += 2 + (((size_t) p[pos + 2] << 8) | p[pos + 3]);
+    }
+    return EINA_FALSE;
+}
+
+// Keep the candidate if it is the largest displayable JPEG seen so far
+static void _raw_consider(const unsigned char* file, size_t file_size, size_t off, size_t len,
+    size_t* best_off, size_t* best_len)
+{
+    if (len <= *best_len || !_is_jpeg_at(file, file_size, off, len))
+        return;
+    if (!_is_lossy_jpeg(file + off, len))
+        return;
+    *best_off = off;
+    *best_len = len;
+}
+
+// Walk an IFD chain (and SubIFDs one level down) collecting JPEG previews,
+// either as JPEGInterchangeFormat pairs (NEF/ARW) or single JPEG strips (CR2/DNG)
+static void _scan_raw_ifds(const Tiff_View* t, size_t ifd, int depth, int* budget,
+    size_t* best_off, size_t* best_len)
+{
+    while (ifd && *budget > 0) {
+        (*budget)--;
+        unsigned int off = 0, len = 0, count = 0, comp = 0;
+
+        if (_tiff_ifd_find(t, ifd, TAG_JPEG_OFFSET, &off, NULL)
+            && _tiff_ifd_find(t, ifd, TAG_JPEG_LENGTH, &len, NULL))
+            _raw_consider(t->base, t->size, off, len, best_off, best_len);
+
+        if (_tiff_ifd_find(t, ifd, TAG_COMPRESSION, &comp, NULL)
+            && (comp == TIFF_COMPRESSION_OJPEG || comp == TIFF_COMPRESSION_JPEG)
+            && _tiff_ifd_find(t, ifd, TAG_STRIP_OFFSETS, &off, &count) && count == 1
+            && _tiff_ifd_find(t, ifd, TAG_STRIP_BYTE_COUNTS, &len, NULL))
+            _raw_consider(t->base, t->size, off, len, best_off, best_len);
+
+        unsigned int sub = 0;
+        if (depth == 0 && _tiff_ifd_find(t, ifd, TAG_SUB_IFDS, &sub, &count)) {
+            if (count == 1) {
+                _scan_raw_ifds(t, sub, depth + 1, budget, best_off, best_len);
+            } else {
+                // Multiple SubIFDs: the value field points at an array of offsets
+                for (unsigned int i = 0; i < count && i < 8; i++)
+                    _scan_raw_ifds(
+                        t, _rd32(t, sub + (size_t) i * 4), depth + 1, budget, best_off, best_len);
+            }
+        }
+        ifd = _tiff_next_ifd(t, ifd);
+    }
+}
+
+// Map a whole file read-only; returns NULL (and closes nothing) on failure
+static const unsigned char* _map_file(const char* path, Eina_File** out_f, size_t* out_size)
+{
+    Eina_File* f = eina_file_open(path, EINA_FALSE);
+    if (!f)
+        return NULL;
+    const unsigned char* file = eina_file_map_all(f, EINA_FILE_RANDOM);
+    if (!file) {
+        eina_file_close(f);
+        return NULL;
+    }
+    *out_f = f;
+    *out_size = eina_file_size_get(f);
+    return file;
+}
+
+// Copy [off, off+len) out of the mapping so it can be released immediately
+static Eina_Bool _copy_out(const unsigned char* file, size_t off, size_t len,
+    unsigned char** out_data, size_t* out_size)
+{
+    if (len == 0)
+        return EINA_FALSE;
+    *out_data = malloc(len);
+    if (!*out_data)
+        return EINA_FALSE;
+    memcpy(*out_data, file + off, len);
+    *out_size = len;
+    return EINA_TRUE;
+}
+
+Eina_Bool exif_raw_preview_get(const char* path, unsigned char** out_data, size_t* out_size)
+{
+    if (!path || !out_data || !out_size)
+        return EINA_FALSE;
+    *out_data = NULL;
+    *out_size = 0;
+
+    Eina_File* f = NULL;
+    size_t file_size = 0;
+    const unsigned char* file = _map_file(path, &f, &file_size);
+    if (!file)
+        return EINA_FALSE;
+
+    size_t best_off = 0, best_len = 0;
+    Tiff_View t;
+    if (file_size > RAF_JPEG_LENGTH_POS + 4 && memcmp(file, RAF_MAGIC, 16) == 0) {
+        Tiff_View be = { file, file_size, EINA_TRUE };
+        _raw_consider(file, file_size, _rd32(&be, RAF_JPEG_OFFSET_POS),
+            _rd32(&be, RAF_JPEG_LENGTH_POS), &best_off, &best_len);
+    } else if (_tiff_view_init(&t, file, file_size)) {
+        int budget = RAW_MAX_IFDS;
+        _scan_raw_ifds(&t, _rd32(&t, 4), 0, &budget, &best_off, &best_len);
+    }
+
+    Eina_Bool ok = _copy_out(file, best_off, best_len, out_data, out_size);
+    eina_file_map_free(f, (void*) file);
+    eina_file_close(f);
+    if (ok)
+        DBG("RAW preview: %s (%zu bytes at %zu)", path, *out_size, best_off);
+    else
+        WRN("No displayable JPEG preview in RAW file: %s", path);
+    return ok;
+}
+
+Eina_Bool exif_preview_get(const char* path, unsigned char** out_data, size_t* out_size)
+{
+    if (!path || !out_data || !out_size)
+        return EINA_FALSE;
+    *out_data = NULL;
+    *out_size = 0;
+
+    Eina_File* f = NULL;
+    size_t file_size = 0;
+    const unsigned char* file = _map_file(path, &f, &file_size);
+    if (!file)
+        return EINA_FALSE;
+    if (file_size < 4 || file[0] != 0xFF || file[1] != JPEG_SOI) {
+        eina_file_map_free(f, (void*) file);
+        eina_file_close(f);
+        return EINA_FALSE;
+    }
+
+    size_t best_off = 0, best_len = 0;
+    size_t pos = 2;
+    // Walk header segments up to the start of scan data
+    while (pos + 4 <= file_size) {
+        if (file[pos] != 0xFF)
+            break;
+        unsigned char marker = file[pos + 1];
+        if (marker == 0xFF) {
+            pos++; // fill byte
+            continue;
+        }
+        if (marker == JPEG_SOS || marker == JPEG_EOI)
+            break;
+        size_t seg_len = ((size_t) file[pos + 2] << 8) | file[pos + 3];
+        if (seg_len < 2 || pos + 2 + seg_len > file_size)
+            break;
+        const unsigned char* payload = file + pos + 4;
+        size_t payload_len = seg_len - 2;
+
+        if (marker == JPEG_APP1 && payload_len > 14 && memcmp(payload, "Exif\0\0", 6) == 0)
+            _scan_exif_thumbnail(
+                file, file_size, pos + 4 + 6, payload_len - 6, &best_off, &best_len);
+        else if (marker == JPEG_APP2 && payload_len > 12 && memcmp(payload, "MPF\0", 4) == 0)
+            _scan_mpf_previews(file, file_size, pos + 4 + 4, &best_off, &best_len);
+
+        pos += 2 + seg_len;
+    }
+
+    Eina_Bool ok = _copy_out(file, best_off, best_len, out_data, out_size);
+    eina_file_map_free(f, (void*) file);
+    eina_file_close(f);
+    if (ok)
+        DBG("Embedded preview: %s (%zu bytes)", path, *out_size);
+    return ok;
+}
+
+// Orientation from IFD0 of a TIFF structure; 0 when absent or invalid
+static int _tiff_orientation(const Tiff_View* t)
+{
+    unsigned int value = 0;
+    size_t ifd0 = _rd32(t, 4);
+    if (!ifd0 || !_tiff_ifd_find(t, ifd0, TAG_ORIENTATION, &value, NULL))
+        return 0;
+    return (value >= 1 && value <= 8) ? (int) value : 0;
+}
+
+int exif_orientation_from_jpeg(const unsigned char* data, size_t size)
+{
+    if (!data || size < 4 || data[0] != 0xFF || data[1] != JPEG_SOI)
+        return 1;
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF)
+            break;
+        unsigned char marker = data[pos + 1];
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+        if (marker == JPEG_SOS || marker == JPEG_EOI)
+            break;
+        size_t seg_len = ((size_t) data[pos + 2] << 8) | data[pos + 3];
+        if (seg_len < 2 || pos + 2 + seg_len > size)
+            break;
+        const unsigned char* payload = data + pos + 4;
+        if (marker == JPEG_APP1 && seg_len - 2 > 14 && memcmp(payload, "Exif\0\0", 6) == 0) {
+            Tiff_View t;
+            if (_tiff_view_init(&t, payload + 6, seg_len - 2 - 6)) {
+                int o = _tiff_orientation(&t);
+                return o ? o : 1;
+            }
+        }
+        pos += 2 + seg_len;
+    }
+    return 1;
+}
+
+int exif_orientation_get(const char* path)
+{
+    if (!path)
+        return 1;
+    Eina_File* f = NULL;
+    size_t file_size = 0;
+    const unsigned char* file = _map_file(path, &f, &file_size);
+    if (!file)
+        return 1;
+
+    int orientation = 1;
+    Tiff_View t;
+    if (file_size >= 4 && file[0] == 0xFF && file[1] == JPEG_SOI) {
+        orientation = exif_orientation_from_jpeg(file, file_size);
+    } else if (file_size > RAF_JPEG_LENGTH_POS + 4 && memcmp(file, RAF_MAGIC, 16) == 0) {
+        // RAF keeps its EXIF inside the embedded JPEG
+        Tiff_View be = { file, file_size, EINA_TRUE };
+        size_t off = _rd32(&be, RAF_JPEG_OFFSET_POS);
+        size_t len = _rd32(&be, RAF_JPEG_LENGTH_POS);
+        if (_is_jpeg_at(file, file_size, off, len))
+            orientation = exif_orientation_from_jpeg(file + off, len);
+    } else if (_tiff_view_init(&t, file, file_size)) {
+        int o = _tiff_orientation(&t);
+        orientation = o ? o : 1;
+    }
+
+    eina_file_map_free(f, (void*) file);
+    eina_file_close(f);
+    return orientation;
+}
+
+Eina_Bool exif_jpeg_info(const char* path, int* w, int* h, int* orientation)
+{
+    if (!path || !w || !h || !orientation)
+        return EINA_FALSE;
+    Eina_File* f = NULL;
+    size_t size = 0;
+    // Mapped lazily: only the header pages are read
+    const unsigned char* data = _map_file(path, &f, &size);
+    if (!data)
+        return EINA_FALSE;
+
+    Eina_Bool found = EINA_FALSE;
+    *orientation = 1;
+    size_t pos = 2;
+    Eina_Bool jpeg = size >= 4 && data[0] == 0xFF && data[1] == JPEG_SOI;
+    while (jpeg && !found && pos + 4 <= size) {
+        if (data[pos] != 0xFF)
+            break;
+        unsigned char marker = data[pos + 1];
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+        if (marker == JPEG_SOS || marker == JPEG_EOI)
+            break;
+        size_t seg_len = ((size_t) data[pos + 2] << 8) | data[pos + 3];
+        if (seg_len < 2 || pos + 2 + seg_len > size)
+            break;
+        const unsigned char* payload = data + pos + 4;
+        if (marker == JPEG_APP1 && seg_len - 2 > 14 && memcmp(payload, "Exif\0\0", 6) == 0) {
+            Tiff_View t;
+            if (_tiff_view_init(&t, payload + 6, seg_len - 2 - 6)) {
+                int o = _tiff_orientation(&t);
+                *orientation = o ? o : 1;
+            }
+        } else if (JPEG_IS_SOF(marker) && seg_len >= 8) {
+            // Precision, then height and width; EXIF comes before the frame
+            *h = (payload[1] << 8) | payload[2];
+            *w = (payload[3] << 8) | payload[4];
+            found = *w > 0 && *h > 0;
+        }
+        pos += 2 + seg_len;
+    }
+    eina_file_map_free(f, (void*) data);
+    eina_file_close(f);
+    return found;
+}
@@ -0,0 +1,28 @@
+#ifndef EXIF_H
+#define EXIF_H
+
+#include "common.h"
+
+// Function declarations for EXIF/TIFF metadata parsing
+
+// Extract the largest embedded JPEG preview from a JPEG file: an MPF large
+// thumbnail (APP2) when present, otherwise the EXIF IFD1 thumbnail (APP1).
+// On success *out_data is malloc'd and must be freed by the caller.
+Eina_Bool exif_preview_get(const char* path, unsigned char** out_data, size_t* out_size);
+
+// Extract the largest lossy JPEG preview embedded in a RAW camera file
+// (TIFF-based CR2/NEF/ARW/DNG, or Fujifilm RAF) without touching sensor data.
+// On success *out_data is malloc'd and must be freed by the caller.
+Eina_Bool exif_raw_preview_get(const char* path, unsigned char** out_data, size_t* out_size);
+
+// EXIF orientation (1-8) of a JPEG, TIFF-based RAW or RAF file; 1 when absent
+int exif_orientation_get(const char* path);
+
+// EXIF orientation (1-8) from a JPEG held in memory; 1 when absent
+int exif_orientation_from_jpeg(const unsigned char* data, size_t size);
+
+// Stored size and EXIF orientation of a JPEG, from its header segments alone.
+// Safe to call on any thread; EINA_FALSE when no frame header is found.
+Eina_Bool exif_jpeg_info(const char* path, int* w, int* h, int* orientation);
+
+#endif /* EXIF_H */
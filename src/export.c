@@ -0,0 +1,489 @@
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <Ecore_Evas.h>
+#include "export.h"
+#include "decode.h"
+#include "media.h"
+#include "poster.h"
+#include "quarantine.h"
+#include "transition.h"
+
+// Largest export frame side
+#define EXPORT_SIDE_MAX 8192
+// Slides decoded ahead of the one being rendered
+#define EXPORT_LOOKAHEAD 4
+
+typedef enum {
+    EXPORT_SINK_PNG,
+    EXPORT_SINK_STDOUT,
+    EXPORT_SINK_FFMPEG,
+} Export_Sink;
+
+typedef enum {
+    EXPORT_LOAD,       // waiting for the next slide
+    EXPORT_TRANSITION, // blending it in
+    EXPORT_DWELL,      // holding it
+} Export_Phase;
+
+static Ecore_Evas* ee = NULL;
+static Evas* evas = NULL;
+static Evas_Object* layers[2]; // front and back slide
+static int front = 0;
+static Evas_Object* png_img = NULL; // hands rendered frames to the PNG saver
+static Export_Sink sink_kind;
+static FILE* sink = NULL;
+static pid_t sink_pid = -1;          // ffmpeg reading the sink
+static char last_png[PATH_MAX] = ""; // frame file repeated frames link to
+static char* dest = NULL;
+static int out_w = EXPORT_DEFAULT_W, out_h = EXPORT_DEFAULT_H;
+static int fps = EXPORT_DEFAULT_FPS;
+static int transition_frames = 0;
+static int dwell_frames = 0;
+static char* transition_name = NULL;
+
+// Paths in playing order, copied at the start: a rescan during the export
+// may insert entries into the catalog and shift its indices
+static char** order = NULL;
+static int order_count = 0;
+static int pos = -1; // entry of order on screen
+static Export_Phase phase = EXPORT_LOAD;
+static int phase_frame = 0;
+static unsigned int frames_written = 0;
+static unsigned int slides_shown = 0;
+static char* failed_path = NULL; // last slide the decoder gave up on
+static Ecore_Idler* idler = NULL;
+static Eina_Bool waiting = EINA_FALSE;
+static Eina_Bool finished = EINA_FALSE;
+static Eina_Bool succeeded = EINA_FALSE;
+static double start_time = 0.0;
+
+static Eina_Bool _idler_cb(void* data);
+
+static Eina_Bool _decodable(const char* path)
+{
+    return decode_is_supported(path) || (is_video_file(path) && poster_is_supported(path));
+}
+
+static Eina_Bool _sink_open(void)
+{
+    struct stat st;
+    size_t len = strlen(dest);
+    if (strcmp(dest, "-") == 0) {
+        sink_kind = EXPORT_SINK_STDOUT;
+        sink = stdout;
+        return EINA_TRUE;
+    }
+    if ((stat(dest, &st) == 0 && S_ISDIR(st.st_mode)) || (len > 0 && dest[len - 1] == '/')) {
+        if (mkdir(dest, 0755) != 0 && errno != EEXIST) {
+            ERR("Cannot create export directory %s: %s", dest, strerror(errno));
+            return EINA_FALSE;
+        }
+        sink_kind = EXPORT_SINK_PNG;
+        png_img = evas_object_image_filled_add(evas);
+        evas_object_image_alpha_set(png_img, EINA_FALSE);
+        evas_object_image_size_set(png_img, out_w, out_h);
+        return EINA_TRUE;
+    }
+
+    // Buffer pixels are ARGB8888 words, which is BGRA byte order
+    char size[32], rate[16];
+    snprintf(size, sizeof(size), "%dx%d", out_w, out_h);
+    snprintf(rate, sizeof(rate), "%d", fps);
+    char* const argv[] = { "ffmpeg", "-v", "error", "-y", "-f", "rawvideo", "-pix_fmt", "bgra",
+        "-s", size, "-r", rate, "-i", "-", "-c:v", "libx264", "-preset", "medium", "-crf", "20",
+        "-pix_fmt", "yuv420p", "-movflags", "+faststart", dest, NULL };
+    int fd = -1;
+    sink_pid = common_spawn(argv, 0, &fd);
+    if (sink_pid < 0) {
+        ERR("Cannot start ffmpeg for %s: %s", dest, strerror(errno));
+        return EINA_FALSE;
+    }
+    sink = fdopen(fd, "w");
+    if (!sink) {
+        ERR("Cannot write to ffmpeg: %s", strerror(errno));
+        close(fd);
+        waitpid(sink_pid, NULL, 0);
+        sink_pid = -1;
+        return EINA_FALSE;
+    }
+    sink_kind = EXPORT_SINK_FFMPEG;
+    return EINA_TRUE;
+}
+
+// Returns EINA_FALSE when the sink (or encoder) failed
+static Eina_Bool _sink_close(void)
+{
+    if (!sink)
+        return EINA_TRUE;
+    Eina_Bool ok = EINA_TRUE;
+    if (sink_kind == EXPORT_SINK_FFMPEG) {
+        // End of input lets ffmpeg finish the file; the main loop is not
+        // running here, so the exit status is ours to collect
+        int status = 0;
+        ok = fclose(sink) == 0;
+        ok = waitpid(sink_pid, &status, 0) == sink_pid && WIFEXITED(status)
+            && WEXITSTATUS(status) == 0 && ok;
+        sink_pid = -1;
+        if (!ok)
+            ERR("ffmpeg failed encoding %s", dest);
+    } else if (fflush(sink) != 0) {
+        ok = EINA_FALSE;
+    }
+    sink = NULL;
+    return ok;
+}
+
+// Byte copy of a frame file, for file systems without hard links
+static Eina_Bool _file_copy(const char* from, const char* to)
+{
+    FILE* in = fopen(from, "rb");
+    FILE* out = in ? fopen(to, "wb") : NULL;
+    Eina_Bool ok = out != NULL;
+    char buf[65536];
+    size_t n;
+    while (ok && in && (n = fread(buf, 1, sizeof(buf), in)) > 0)
+        ok = fwrite(buf, 1, n, out) == n;
+    ok = ok && !ferror(in);
+    if (out && fclose(out) != 0)
+        ok = EINA_FALSE;
+    if (in)
+        fclose(in);
+    return ok;
+}
+
+// repeat: pixels are those of the previous frame
+static Eina_Bool _frame_write(const void* pixels, Eina_Bool repeat)
+{
+    frames_written++;
+    if (sink_kind == EXPORT_SINK_PNG) {
+        char file[PATH_MAX];
+        size_t len = strlen(dest);
+        snprintf(file, sizeof(file), "%s%sframe-%06u.png", dest,
+            len > 0 && dest[len - 1] == '/' ? "" : "/", frames_written);
+        // A held slide is encoded once; its other frames share that file
+        if (repeat && last_png[0]) {
+            unlink(file);
+            if (link(last_png, file) == 0 || _file_copy(last_png, file))
+                return EINA_TRUE;
+            ERR("Cannot write %s: %s", file, strerror(errno));
+            return EINA_FALSE;
+        }
+        evas_object_image_data_copy_set(png_img, (void*) pixels);
+        if (!evas_object_image_save(png_img, file, NULL, "compress=3")) {
+            ERR("Cannot write %s", file);
+            last_png[0] = '\0';
+            return EINA_FALSE;
+        }
+        snprintf(last_png, sizeof(last_png), "%s", file);
+        return EINA_TRUE;
+    }
+    size_t size = (size_t) out_w * out_h * 4;
+    if (fwrite(pixels, 1, size, sink) != size) {
+        ERR("Export stream closed after %u frames", frames_written - 1);
+        return EINA_FALSE;
+    }
+    return EINA_TRUE;
+}
+
+// Render the canvas and write the frame out
+static Eina_Bool _render(void)
+{
+    ecore_evas_manual_render(ee);
+    const void* pixels = ecore_evas_buffer_pixels_get(ee);
+    return pixels && _frame_write(pixels, EINA_FALSE);
+}
+
+// A held slide does not change: write the last rendered frame again
+static Eina_Bool _repeat(void)
+{
+    const void* pixels = ecore_evas_buffer_pixels_get(ee);
+    return pixels && _frame_write(pixels, EINA_TRUE);
+}
+
+static void _finish(Eina_Bool ok)
+{
+    if (finished)
+        return;
+    finished = EINA_TRUE;
+    transition_end();
+    ok = _sink_close() && ok;
+    succeeded = ok && frames_written > 0;
+    double elapsed = ecore_time_get() - start_time;
+    double length = (double) frames_written / fps;
+    if (succeeded)
+        INF("Exported %u slides, %u frames (%.1f s) to %s in %.1f s (%.1fx real time)",
+            slides_shown, frames_written, length, dest, elapsed,
+            elapsed > 0.0 ? length / elapsed : 0.0);
+    else
+        ERR("Export to %s failed after %u frames", dest, frames_written);
+    idler = NULL;
+    elm_exit();
+}
+
+static void _on_decoded(void* data EINA_UNUSED, const char* path, const Decoded_Slide* slide)
+{
+    if (!slide) {
+        free(failed_path);
+        failed_path = strdup(path);
+    }
+    // The renderer waits for the slide it needs; resume it (unless this ran
+    // synchronously from within the renderer)
+    if (waiting && !finished) {
+        waiting = EINA_FALSE;
+        if (!idler)
+            idler = ecore_idler_add(_idler_cb, NULL);
+    }
+}
+
+static void _fit(Evas_Object* obj, int iw, int ih)
+{
+    double scale = (double) out_w / iw;
+    if ((double) out_h / ih < scale)
+        scale = (double) out_h / ih;
+    Evas_Coord pw = (Evas_Coord) (iw * scale + 0.5);
+    Evas_Coord ph = (Evas_Coord) (ih * scale + 0.5);
+    evas_object_move(obj, (out_w - pw) / 2, (out_h - ph) / 2);
+    evas_object_resize(obj, pw, ph);
+}
+
+// Put path into the back layer. Returns 1 when it is there, 0 while its
+// decode is pending and -1 when it cannot be shown.
+static int _load(const char* path)
+{
+    Evas_Object* back = layers[!front];
+    if (_decodable(path)) {
+        const Decoded_Slide* slide = decode_cache_get(path, out_w, out_h);
+        if (!slide) {
+            if (failed_path && strcmp(failed_path, path) == 0)
+                return -1;
+            waiting = EINA_TRUE;
+            decode_request(path, out_w, out_h, _on_decoded, NULL);
+            // The request may have completed synchronously
+            return waiting ? 0 : _load(path);
+        }
+        evas_object_image_file_set(back, NULL, NULL);
+        evas_object_image_size_set(back, slide->w, slide->h);
+        evas_object_image_data_copy_set(back, slide->pixels);
+        evas_object_image_data_update_add(back, 0, 0, slide->w, slide->h);
+        _fit(back, slide->w, slide->h);
+        return 1;
+    }
+    if (!is_image_file(path))
+        return -1;
+    // Formats the decoder does not handle load synchronously through Evas
+    int iw = 0, ih = 0;
+    evas_object_image_load_size_set(back, out_w, out_h);
+    evas_object_image_file_set(back, path, NULL);
+    evas_object_image_size_get(back, &iw, &ih);
+    if (evas_object_image_load_error_get(back) != EVAS_LOAD_ERROR_NONE || iw <= 0 || ih <= 0)
+        return -1;
+    _fit(back, iw, ih);
+    return 1;
+}
+
+// Keep the next few slides decoding while this one renders
+static void _prefetch_ahead(void)
+{
+    for (int i = 1; i <= EXPORT_LOOKAHEAD && pos + i < order_count; i++) {
+        if (_decodable(order[pos + i]))
+            decode_prefetch(order[pos + i], out_w, out_h);
+    }
+}
+
+static void _transition_done(void)
+{
+    transition_end();
+    evas_object_hide(layers[front]);
+    front = !front;
+    phase = EXPORT_DWELL;
+    phase_frame = 0;
+}
+
+// One step of the timeline per call: a frame, or loading the next slide
+static Eina_Bool _idler_cb(void* data EINA_UNUSED)
+{
+    if (finished)
+        return ECORE_CALLBACK_CANCEL;
+
+    if (phase == EXPORT_LOAD) {
+        if (pos >= order_count) {
+            _finish(EINA_TRUE);
+            return ECORE_CALLBACK_CANCEL;
+        }
+        const char* path = order[pos];
+        int loaded = _load(path);
+        if (loaded == 0) {
+            // Resumed by _on_decoded()
+            idler = NULL;
+            return ECORE_CALLBACK_CANCEL;
+        }
+        if (loaded < 0) {
+            WRN("Export skips %s", path);
+            pos++;
+            return ECORE_CALLBACK_RENEW;
+        }
+        DBG("Exporting slide %d/%d: %s", pos + 1, order_count, path);
+        slides_shown++;
+        _prefetch_ahead();
+
+        Evas_Object* from = slides_shown > 1 ? layers[front] : NULL;
+        Evas_Object* to = layers[!front];
+        if (from)
+            evas_object_stack_above(to, from);
+        const Transition* tr = transition_pick(transition_name);
+        transition_begin(tr, from, to, 0, 0, out_w, out_h);
+        evas_object_show(to);
+        phase = EXPORT_TRANSITION;
+        phase_frame = 0;
+        if (transition_frames <= 0)
+            _transition_done();
+        return ECORE_CALLBACK_RENEW;
+    }
+
+    Eina_Bool ok;
+    if (phase == EXPORT_TRANSITION) {
+        phase_frame++;
+        double t = (double) phase_frame / transition_frames;
+        // Same easing as the slideshow's transitions
+        transition_step(t * t * (3.0 - 2.0 * t));
+        if (phase_frame >= transition_frames)
+            _transition_done();
+        ok = _render();
+    } else {
+        ok = phase_frame == 0 ? _render() : _repeat();
+        if (++phase_frame >= dwell_frames) {
+            phase = EXPORT_LOAD;
+            pos++;
+        }
+    }
+    if (!ok) {
+        _finish(EINA_FALSE);
+        return ECORE_CALLBACK_CANCEL;
+    }
+    return ECORE_CALLBACK_RENEW;
+}
+
+Eina_Bool export_start(const Export_Options* opts)
+{
+    if (!opts || !opts->dest || !*opts->dest)
+        return EINA_FALSE;
+    if (opts->size && *opts->size
+        && !common_parse_size(opts->size, EXPORT_SIDE_MAX, &out_w, &out_h)) {
+        ERR("Invalid export size '%s' (expected WxH)", opts->size);
+        return EINA_FALSE;
+    }
+    // Even sizes keep yuv420p encoders happy
+    out_w &= ~1;
+    out_h &= ~1;
+    fps = opts->fps > 0 ? opts->fps : EXPORT_DEFAULT_FPS;
+    double fade = opts->fade > 0.0 ? opts->fade : 0.0;
+    double interval = opts->interval > fade ? opts->interval : fade;
+    transition_frames = (int) (fade * fps + 0.5);
+    dwell_frames = (int) ((interval - fade) * fps + 0.5);
+    if (dwell_frames < 1)
+        dwell_frames = 1;
+    transition_name = strdup(transition_name_valid(opts->transition) ? opts->transition
+                                                                     : TRANSITION_DEFAULT);
+
+    order_count = get_media_file_count();
+    if (order_count <= 0) {
+        ERR("Nothing to export: no media found");
+        return EINA_FALSE;
+    }
+    order = calloc(order_count, sizeof(char*));
+    if (!order)
+        return EINA_FALSE;
+    int n = 0;
+    for (int i = 0; i < order_count; i++) {
+        char* path = get_media_path_at_index(i);
+        if (path && !quarantine_contains(path))
+            order[n++] = path;
+        else
+            free(path);
+    }
+    order_count = n;
+    if (opts->shuffle) {
+        srand((unsigned int) ecore_time_unix_get());
+        for (int i = order_count - 1; i > 0; i--) {
+            int j = rand() % (i + 1);
+            char* t = order[i];
+            order[i] = order[j];
+            order[j] = t;
+        }
+    }
+
+    ee = ecore_evas_buffer_new(out_w, out_h);
+    if (!ee) {
+        ERR("Cannot create a %dx%d offscreen canvas", out_w, out_h);
+        return EINA_FALSE;
+    }
+    ecore_evas_manual_render_set(ee, EINA_TRUE);
+    evas = ecore_evas_get(ee);
+    Evas_Object* bg = evas_object_rectangle_add(evas);
+    evas_object_color_set(bg, 0, 0, 0, 255);
+    evas_object_resize(bg, out_w, out_h);
+    evas_object_show(bg);
+    for (int i = 0; i < 2; i++) {
+        layers[i] = evas_object_image_filled_add(evas);
+        evas_object_image_smooth_scale_set(layers[i], EINA_TRUE);
+    }
+    dest = strdup(opts->dest);
+    if (!_sink_open())
+        return EINA_FALSE;
+
+    decode_init();
+    // Slides decoded ahead stay resident until rendered, with the one on screen
+    decode_set_cache_slots(EXPORT_LOOKAHEAD + 1);
+    transition_init(evas);
+    transition_set_offline(EINA_TRUE);
+
+    INF("Exporting %d slides at %dx%d, %d fps (%d + %d frames each) to %s", order_count, out_w,
+        out_h, fps, transition_frames, dwell_frames, dest);
+    start_time = ecore_time_get();
+    pos = 0;
+    phase = EXPORT_LOAD;
+    idler = ecore_idler_add(_idler_cb, NULL);
+    return EINA_TRUE;
+}
+
+Eina_Bool export_succeeded(void)
+{
+    return succeeded;
+}
+
+void export_shutdown(void)
+{
+    if (idler) {
+        ecore_idler_del(idler);
+        idler = NULL;
+    }
+    if (!finished && sink)
+        _sink_close();
+    transition_shutdown();
+    decode_shutdown();
+    if (ee) {
+        // Deletes the canvas objects with it
+        ecore_evas_free(ee);
+        ee = NULL;
+        evas = NULL;
+        png_img = NULL;
+        layers[0] = layers[1] = NULL;
+    }
+    if (order) {
+        for (int i = 0; i < order_count; i++)
+            free(order[i]);
+        free(order);
+        order = NULL;
+    }
+    order_count = 0;
+    free(dest);
+    dest = NULL;
+    last_png[0] = '\0';
+    free(transition_name);
+    transition_name = NULL;
+    free(failed_path);
+    failed_path = NULL;
+}
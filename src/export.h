@@ -0,0 +1,41 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "common.h"
+
+// Headless export: renders the catalog as a slideshow on an offscreen
+// Ecore_Evas buffer canvas, through the same transition code as the screen,
+// and writes every frame out. Time is virtual: each frame advances the clock
+// by 1/fps however long it took to render, so export runs as fast as the
+// frames can be drawn and written. Slides are decoded by the background
+// decoder a few ahead of the renderer, in parallel.
+//
+// dest selects the sink:
+//   a directory (existing, or ending in '/')  frame-000001.png, ...
+//   "-"                                      raw BGRA frames on stdout
+//   anything else                            a video file encoded by ffmpeg
+
+#define EXPORT_DEFAULT_W 1920
+#define EXPORT_DEFAULT_H 1080
+#define EXPORT_DEFAULT_FPS 30
+
+typedef struct {
+    const char* dest;
+    const char* size;       // "WxH", NULL for the default
+    int fps;                // 0 for the default
+    double interval;        // seconds from one slide to the next
+    double fade;            // transition seconds
+    const char* transition; // registered name or "random"
+    Eina_Bool shuffle;
+} Export_Options;
+
+// Start rendering the scanned catalog; the main loop is quit when the last
+// frame is written. Returns EINA_FALSE if the export could not start.
+Eina_Bool export_start(const Export_Options* opts);
+
+// Whether every frame was rendered and written
+Eina_Bool export_succeeded(void);
+
+void export_shutdown(void);
+
+#endif /* EXPORT_H */
@@ -0,0 +1,241 @@
+#include <Ecore_Evas.h>
+#include "governor.h"
+
+// Frame rates tried, fastest first
+static const double governor_rates[] = { 60.0, 30.0, 24.0, 20.0, 15.0 };
+#define GOVERNOR_RUNGS (int) (sizeof(governor_rates) / sizeof(governor_rates[0]))
+// Slowest rate at which filtered scaling is kept if dropping it would be faster
+#define GOVERNOR_SMOOTH_MIN_RATE 24.0
+// Share of the frame period a render may take and still count as sustained
+#define GOVERNOR_HEADROOM 0.8
+// Calibration frames per configuration, after the warmup ones
+#define GOVERNOR_CALIBRATION_FRAMES 6
+#define GOVERNOR_WARMUP_FRAMES 2
+// Runs with room for the next faster rate needed before moving up
+#define GOVERNOR_RETRY_RUNS 10
+
+static Evas* governed_evas = NULL;
+static int rung = 0;
+static Eina_Bool smooth = EINA_TRUE;
+static int good_runs = 0;
+
+// Render sampling for the run in progress
+static Eina_Bool running = EINA_FALSE;
+static double render_start = 0.0;
+static double render_sum = 0.0;
+static int render_count = 0;
+
+static double _period(int r)
+{
+    return 1.0 / governor_rates[r];
+}
+
+static void _rate_apply(void)
+{
+    ecore_animator_frametime_set(_period(rung));
+}
+
+// Time crossfade frames of two scaled full-screen images on the software
+// buffer engine. Sources are smaller than the output, as for letterboxed
+// slides, so the scaling filter is part of what is measured.
+static double _calibrate_blend(int w, int h, Eina_Bool filtered)
+{
+    Ecore_Evas* ee = ecore_evas_buffer_new(w, h);
+    if (!ee)
+        return -1.0;
+    ecore_evas_manual_render_set(ee, EINA_TRUE);
+    Evas* evas = ecore_evas_get(ee);
+
+    int sw = w * 3 / 4, sh = h * 3 / 4;
+    unsigned int* pixels = malloc((size_t) sw * sh * sizeof(unsigned int));
+    if (!pixels) {
+        ecore_evas_free(ee);
+        return -1.0;
+    }
+    for (int y = 0; y < sh; y++) {
+        for (int x = 0; x < sw; x++)
+            pixels[(size_t) y * sw + x] = 0xff000000 | ((x & 0xff) << 16) | ((y & 0xff) << 8);
+    }
+
+    Evas_Object* layers[2];
+    for (int i = 0; i < 2; i++) {
+        layers[i] = evas_object_image_add(evas);
+        evas_object_image_size_set(layers[i], sw, sh);
+        evas_object_image_data_copy_set(layers[i], pixels);
+        evas_object_image_filled_set(layers[i], EINA_TRUE);
+        evas_object_image_smooth_scale_set(layers[i], filtered);
+        evas_object_move(layers[i], 0, 0);
+        evas_object_resize(layers[i], w, h);
+        evas_object_show(layers[i]);
+    }
+    free(pixels);
+    ecore_evas_show(ee);
+
+    double sum = 0.0;
+    int total = GOVERNOR_WARMUP_FRAMES + GOVERNOR_CALIBRATION_FRAMES;
+    for (int i = 0; i < total; i++) {
+        int a = 255 * (i + 1) / (total + 1);
+        evas_object_color_set(layers[1], a, a, a, a);
+        double t0 = ecore_time_get();
+        ecore_evas_manual_render(ee);
+        if (i >= GOVERNOR_WARMUP_FRAMES)
+            sum += ecore_time_get() - t0;
+    }
+    ecore_evas_free(ee);
+    return sum / GOVERNOR_CALIBRATION_FRAMES;
+}
+
+// Fastest rung a render of cost seconds sustains, or the slowest one
+static int _rung_for(double cost)
+{
+    for (int r = 0; r < GOVERNOR_RUNGS; r++) {
+        if (cost <= _period(r) * GOVERNOR_HEADROOM)
+            return r;
+    }
+    return GOVERNOR_RUNGS - 1;
+}
+
+static void _calibrate(Evas_Object* win)
+{
+    Ecore_Evas* ee = ecore_evas_ecore_evas_get(evas_object_evas_get(win));
+    const char* engine = ee ? ecore_evas_engine_name_get(ee) : NULL;
+    // The buffer engine only predicts software rendering
+    if (engine && strstr(engine, "gl")) {
+        INF("Governor: %s engine, keeping %.0f fps without calibration", engine,
+            governor_rates[rung]);
+        return;
+    }
+
+    int w = 0, h = 0;
+    if (ee)
+        ecore_evas_screen_geometry_get(ee, NULL, NULL, &w, &h);
+    if (w <= 0 || h <= 0) {
+        w = DEFAULT_WINDOW_WIDTH;
+        h = DEFAULT_WINDOW_HEIGHT;
+    }
+
+    double filtered = _calibrate_blend(w, h, EINA_TRUE);
+    if (filtered < 0.0) {
+        WRN("Governor: calibration failed, keeping %.0f fps", governor_rates[rung]);
+        return;
+    }
+    rung = _rung_for(filtered);
+    smooth = EINA_TRUE;
+    // Nearest sampling only pays off when filtering cannot reach a fluid rate
+    if (governor_rates[rung] < GOVERNOR_SMOOTH_MIN_RATE) {
+        double nearest = _calibrate_blend(w, h, EINA_FALSE);
+        if (nearest >= 0.0 && _rung_for(nearest) < rung) {
+            rung = _rung_for(nearest);
+            smooth = EINA_FALSE;
+        }
+        INF("Governor: %dx%d blend %.1f ms filtered, %.1f ms nearest", w, h,
+            filtered * 1000.0, nearest * 1000.0);
+    } else {
+        INF("Governor: %dx%d blend %.1f ms", w, h, filtered * 1000.0);
+    }
+    INF("Governor: animating at %.0f fps with %s scaling", governor_rates[rung],
+        smooth ? "smooth" : "nearest");
+}
+
+static void _on_render_pre(
+    void* data EINA_UNUSED, Evas* e EINA_UNUSED, void* event_info EINA_UNUSED)
+{
+    if (running)
+        render_start = ecore_time_get();
+}
+
+static void _on_render_post(
+    void* data EINA_UNUSED, Evas* e EINA_UNUSED, void* event_info EINA_UNUSED)
+{
+    if (!running || render_start <= 0.0)
+        return;
+    render_sum += ecore_time_get() - render_start;
+    render_count++;
+    render_start = 0.0;
+}
+
+void governor_init(Evas_Object* win)
+{
+    if (governed_evas || !win)
+        return;
+    rung = 0;
+    smooth = EINA_TRUE;
+    _calibrate(win);
+    _rate_apply();
+
+    governed_evas = evas_object_evas_get(win);
+    evas_event_callback_add(governed_evas, EVAS_CALLBACK_RENDER_PRE, _on_render_pre, NULL);
+    evas_event_callback_add(governed_evas, EVAS_CALLBACK_RENDER_POST, _on_render_post, NULL);
+}
+
+void governor_shutdown(void)
+{
+    if (!governed_evas)
+        return;
+    evas_event_callback_del_full(governed_evas, EVAS_CALLBACK_RENDER_PRE, _on_render_pre, NULL);
+    evas_event_callback_del_full(governed_evas, EVAS_CALLBACK_RENDER_POST, _on_render_post, NULL);
+    governed_evas = NULL;
+    running = EINA_FALSE;
+}
+
+void governor_run_begin(void)
+{
+    running = EINA_TRUE;
+    render_start = 0.0;
+    render_sum = 0.0;
+    render_count = 0;
+}
+
+Eina_Bool governor_run_end(void)
+{
+    if (!running)
+        return EINA_FALSE;
+    running = EINA_FALSE;
+    // Skip the first (upload) frame and runs too short to judge
+    if (render_count < 4)
+        return EINA_FALSE;
+    double cost = render_sum / render_count;
+
+    if (cost > _period(rung)) {
+        good_runs = 0;
+        if (rung < GOVERNOR_RUNGS - 1) {
+            rung++;
+            _rate_apply();
+            WRN("Governor: renders take %.1f ms; animating at %.0f fps", cost * 1000.0,
+                governor_rates[rung]);
+            return EINA_TRUE;
+        }
+        if (smooth) {
+            smooth = EINA_FALSE;
+            WRN("Governor: renders take %.1f ms at %.0f fps; using nearest scaling",
+                cost * 1000.0, governor_rates[rung]);
+            return EINA_TRUE;
+        }
+        return EINA_FALSE;
+    }
+
+    // Undo the cheapest concession first: filtering, then frame rate
+    double target = smooth && rung > 0 ? _period(rung - 1) : _period(rung) / 2.0;
+    if ((!smooth || rung > 0) && cost <= target * GOVERNOR_HEADROOM) {
+        if (++good_runs >= GOVERNOR_RETRY_RUNS) {
+            good_runs = 0;
+            if (!smooth) {
+                smooth = EINA_TRUE;
+                INF("Governor: retrying smooth scaling");
+            } else {
+                rung--;
+                _rate_apply();
+                INF("Governor: retrying %.0f fps", governor_rates[rung]);
+            }
+            return EINA_TRUE;
+        }
+    } else {
+        good_runs = 0;
+    }
+    return EINA_FALSE;
+}
+
+Eina_Bool governor_smooth_get(void)
+{
+    return smooth;
+}
@@ -0,0 +1,23 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "common.h"
+
+// Frame-rate governor: calibrates the cost of a full-screen blend offscreen at
+// startup, then sets the animator frame rate and transition sampling quality
+// the renderer can sustain. Render times measured during transitions move the
+// rate up or down a rung at runtime.
+
+// Calibrate for the screen win is on and apply the chosen frame rate
+void governor_init(Evas_Object* win);
+void governor_shutdown(void);
+
+// Bracket an animated transition. Render times are sampled in between; end()
+// returns EINA_TRUE when it changed the frame rate or quality in response.
+void governor_run_begin(void);
+Eina_Bool governor_run_end(void);
+
+// Whether transitions may use smooth (filtered) scaling
+Eina_Bool governor_smooth_get(void);
+
+#endif /* GOVERNOR_H */
@@ -6,7 +6,72 @@
 #include "clock.h"
 #include "weather.h"
 #include "news.h"
+#include "quarantine.h"
+#include "decode.h"
+#include "document.h"
+#include "export.h"
+#include "night.h"
+#include "pack.h"
+#include "proxy.h"
+#include "timelapse.h"
+#include "wall.h"
 
+// Decoder settings shared by the slideshow and headless export
+static void _apply_decode_config(App_Config* cfg)
+{
+    if (!decode_set_resample(cfg->resample_kernel, cfg->sharpen)) {
+        WRN("Unknown resample kernel '%s'; using %s",
+            cfg->resample_kernel ? cfg->resample_kernel : "(null)", decode_get_resample());
+        cfg->resample_kernel = decode_get_resample();
+    }
+    decode_set_blur_fill(cfg->blur_fill);
+    decode_set_fill_screen(cfg->fill_screen);
+}
+
+// Render the catalog to frames without a window; returns the exit status
+static int _run_export(App_Config* cfg)
+{
+    // One scan has to list every PDF page
+    document_set_sync_count(EINA_TRUE);
+    media_set_images_dir(cfg->images_dir);
+    scan_media_files();
+    _apply_decode_config(cfg);
+    Export_Options opts = { .dest = cfg->export_dest,
+        .size = cfg->export_size,
+        .fps = cfg->export_fps,
+        .interval = cfg->slideshow_interval,
+        .fade = cfg->fade_duration,
+        .transition = cfg->transition,
+        .shuffle = cfg->shuffle };
+    int status = -1;
+    if (export_start(&opts)) {
+        elm_run();
+        status = export_succeeded() ? 0 : -1;
+    }
+    // Re-probes decode with Emile; stop them before export shuts it down
+    quarantine_shutdown();
+    export_shutdown();
+    media_cleanup();
+    return status;
+}
+
+// Decode the catalog into a slideshow pack; returns the exit status
+static int _run_pack(App_Config* cfg)
+{
+    document_set_sync_count(EINA_TRUE);
+    media_set_images_dir(cfg->images_dir);
+    scan_media_files();
+    decode_init();
+    _apply_decode_config(cfg);
+    int status = -1;
+    if (pack_build_start(cfg->pack_dest, cfg->pack_size, cfg->pack_lz4)) {
+        elm_run();
+        status = pack_build_succeeded() ? 0 : -1;
+    }
+    decode_shutdown();
+    media_cleanup();
+    return status;
+}
 
 EAPI_MAIN int elm_main(int argc, char** argv)
 {
@@ -42,10 +107,25 @@ EAPI_MAIN int elm_main(int argc, char** argv)
         INF("Loaded persisted configuration");
     }
 
+    // Load the persisted list of media that previously failed to display
+    quarantine_init();
+
     // Apply command line arguments over loaded/default config
     config_merge_cli(&cfg, argc, argv);
     config_log(&cfg);
 
+    // Headless export renders the slideshow to frames, and a pack build
+    // decodes it into a pack, instead of showing it; their settings are not
+    // saved
+    if (cfg.export_dest || cfg.pack_dest) {
+        int status = cfg.pack_dest ? _run_pack(&cfg) : _run_export(&cfg);
+        quarantine_shutdown();
+        config_eet_shutdown();
+        common_cleanup_logging();
+        free(cfg_path);
+        return status;
+    }
+
     // Apply initial UI state from parsed config before creating controls
     // Ensure clock toggle reflects --clock/--no-clock at startup
     clock_visible = cfg.clock_visible;
@@ -96,6 +176,21 @@ EAPI_MAIN int elm_main(int argc, char** argv)
     // Scan for media files
     scan_media_files();
 
+    // Join the video wall before anything is decoded for the screen
+    if (!wall_configure(cfg.wall, cfg.wall_port, cfg.wall_leader, slideshow_wall_slide)) {
+        WRN("Invalid video wall '%s' (expected COLSxROWS:COL,ROW), port %d or leader '%s'; "
+            "wall mode off",
+            cfg.wall, cfg.wall_port, cfg.wall_leader ? cfg.wall_leader : "");
+        cfg.wall = NULL;
+    }
+    int wall_cols, wall_rows, wall_col, wall_row;
+    wall_tile_get(&wall_cols, &wall_rows, &wall_col, &wall_row);
+    decode_set_wall(wall_cols, wall_rows, wall_col, wall_row);
+    // The first slide is decoded with the configured resampler and fill
+    _apply_decode_config(&cfg);
+    ui_set_fill_screen(cfg.fill_screen);
+    timelapse_set_enabled(cfg.timelapse);
+
     // Show first media file if available
     if (get_media_file_count() > 0) {
         char* first_media = get_media_path_at_index(0);
@@ -107,6 +202,13 @@ EAPI_MAIN int elm_main(int argc, char** argv)
     // Apply runtime slideshow tuning from config, then start
     slideshow_set_interval(cfg.slideshow_interval);
     slideshow_set_fade_duration(cfg.fade_duration);
+    slideshow_set_transition(cfg.transition);
+    slideshow_set_ken_burns(cfg.ken_burns);
+    if (!night_set_schedule(cfg.night, cfg.night_level)) {
+        WRN("Invalid night schedule '%s' (expected HH:MM-HH:MM); night mode off", cfg.night);
+        cfg.night = NULL;
+    }
+    proxy_set_cache_size(cfg.proxy_cache);
     // Start slideshow and clock
     slideshow_start();
     clock_start();
@@ -136,6 +238,8 @@ EAPI_MAIN int elm_main(int argc, char** argv)
     // Capture latest runtime values from modules
     cfg.slideshow_interval = slideshow_get_interval();
     cfg.fade_duration = slideshow_get_fade_duration();
+    cfg.transition = slideshow_get_transition();
+    cfg.ken_burns = slideshow_get_ken_burns();
     cfg.fullscreen = ui_is_fullscreen();
     cfg.shuffle = is_shuffle_mode;
     cfg.clock_visible = clock_visible;
@@ -146,7 +250,12 @@ EAPI_MAIN int elm_main(int argc, char** argv)
     config_save_to_eet(&cfg, cfg_path);
 
     // Cleanup
+    night_shutdown();
+    // Before slideshow_cleanup() shuts the decoder down under its re-probes
+    quarantine_shutdown();
     slideshow_cleanup();
+    proxy_shutdown();
+    wall_shutdown();
     clock_cleanup();
     weather_cleanup();
     news_cleanup();
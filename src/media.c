@@ -1,4 +1,8 @@
+#include <strings.h>
 #include "media.h"
+#include "document.h"
+#include "exif.h"
+#include "pack.h"
 
 // Global media file list and current index
 Eina_List* media_files = NULL;
@@ -7,6 +11,15 @@ int current_media_index = 0;
 // Runtime-configurable images directory
 static const char* images_dir_runtime = IMAGES_DIR;
 
+// Recently extracted RAW previews, most recent first
+typedef struct {
+    char* path;
+    Eina_File* file;
+} Raw_Preview;
+
+#define RAW_PREVIEW_CACHE_SIZE 3
+static Eina_List* raw_previews = NULL;
+
 // Cache management variables
 static time_t cache_timestamp = 0;
 static char* cache_dir_path = NULL;
@@ -33,7 +46,101 @@ Eina_Bool is_image_file(const char* filename)
 {
     return (eina_str_has_suffix(filename, ".png") || eina_str_has_suffix(filename, ".jpg")
         || eina_str_has_suffix(filename, ".jpeg") || eina_str_has_suffix(filename, ".gif")
-        || eina_str_has_suffix(filename, ".bmp"));
+        || eina_str_has_suffix(filename, ".bmp") || is_raw_file(filename)
+        || is_document_file(filename) || is_pack_file(filename));
+}
+
+// Function to check if a file is a RAW camera file (extensions are often upper case)
+Eina_Bool is_raw_file(const char* filename)
+{
+    return (eina_str_has_extension(filename, ".cr2") || eina_str_has_extension(filename, ".nef")
+        || eina_str_has_extension(filename, ".arw") || eina_str_has_extension(filename, ".dng")
+        || eina_str_has_extension(filename, ".raf"));
+}
+
+// Whether filename is "<name><ext>#<number>", listed for one part of a file
+static Eina_Bool _is_part_of(const char* filename, const char* ext)
+{
+    const char* hash = strrchr(filename, '#');
+    size_t len = strlen(ext);
+    if (!hash || hash[1] == '\0' || strspn(hash + 1, "0123456789") != strlen(hash + 1))
+        return EINA_FALSE;
+    return (size_t) (hash - filename) > len && strncasecmp(hash - len, ext, len) == 0;
+}
+
+// Function to check if a file is a PDF or SVG document, or one page of a PDF
+Eina_Bool is_document_file(const char* filename)
+{
+    return eina_str_has_extension(filename, ".pdf") || eina_str_has_extension(filename, ".svg")
+        || _is_part_of(filename, ".pdf");
+}
+
+// Function to check if a file is a slideshow pack, or one frame of a pack
+Eina_Bool is_pack_file(const char* filename)
+{
+    return eina_str_has_extension(filename, ".eslpack") || _is_part_of(filename, ".eslpack");
+}
+
+const char* media_source_file(const char* path, char* buf, size_t size)
+{
+    if (!path || !(_is_part_of(path, ".pdf") || _is_part_of(path, ".eslpack")))
+        return path;
+    const char* hash = strrchr(path, '#');
+    snprintf(buf, size, "%.*s", (int) (hash - path), path);
+    return buf;
+}
+
+static void _raw_preview_free(Raw_Preview* rp)
+{
+    if (!rp)
+        return;
+    if (rp->file)
+        eina_file_close(rp->file);
+    free(rp->path);
+    free(rp);
+}
+
+Eina_File* media_raw_preview_open(const char* path)
+{
+    if (!path)
+        return NULL;
+
+    Eina_List* l;
+    Raw_Preview* rp;
+    EINA_LIST_FOREACH(raw_previews, l, rp)
+    {
+        if (strcmp(rp->path, path) == 0) {
+            raw_previews = eina_list_promote_list(raw_previews, l);
+            return eina_file_dup(rp->file);
+        }
+    }
+
+    unsigned char* data = NULL;
+    size_t size = 0;
+    if (!exif_raw_preview_get(path, &data, &size))
+        return NULL;
+
+    // Name the virtual file *.jpg so Evas picks the JPEG loader, not a RAW one
+    Eina_Strbuf* name = eina_strbuf_new();
+    eina_strbuf_append_printf(name, "%s#preview.jpg", path);
+    Eina_File* file = eina_file_virtualize(eina_strbuf_string_get(name), data, size, EINA_TRUE);
+    eina_strbuf_free(name);
+    free(data);
+    if (!file)
+        return NULL;
+
+    rp = calloc(1, sizeof(Raw_Preview));
+    if (!rp)
+        return file;
+    rp->path = strdup(path);
+    rp->file = file;
+    raw_previews = eina_list_prepend(raw_previews, rp);
+    if (eina_list_count(raw_previews) > RAW_PREVIEW_CACHE_SIZE) {
+        Eina_List* last = eina_list_last(raw_previews);
+        _raw_preview_free(eina_list_data_get(last));
+        raw_previews = eina_list_remove_list(raw_previews, last);
+    }
+    return eina_file_dup(file);
 }
 
 // Function to check if a file has a video extension
@@ -63,6 +170,38 @@ void free_media_file(MediaFile* media_file)
     free(media_file);
 }
 
+// Add every page of a PDF, or every frame of a pack, to the media list as
+// "<file>#<n>"
+static void _append_parts(const char* file)
+{
+    Eina_Bool pack = eina_str_has_extension(file, ".eslpack");
+    if (!pack && !document_is_supported(file))
+        return;
+    int count = pack ? pack_frame_count(file) : document_page_count(file);
+    if (count < 0) {
+        DBG("Counting the pages of %s", file);
+        return;
+    }
+    if (count == 0) {
+        WRN("No readable %s in %s", pack ? "frames" : "pages", file);
+        return;
+    }
+    Eina_Strbuf* buf = eina_strbuf_new();
+    for (int n = 1; n <= count; n++) {
+        MediaFile* new_media = malloc(sizeof(MediaFile));
+        if (!new_media)
+            break;
+        eina_strbuf_reset(buf);
+        eina_strbuf_append_printf(buf, "%s#%d", file, n);
+        new_media->path = strdup(eina_strbuf_string_get(buf));
+        new_media->is_image = EINA_TRUE;
+        media_files = eina_list_append(media_files, new_media);
+    }
+    eina_strbuf_free(buf);
+    INF("Added %s: %s (%d %s)", pack ? "pack" : "document", file, count,
+        pack ? "frames" : "pages");
+}
+
 // Check if directory has been modified since last cache
 static Eina_Bool _directory_has_changed(void)
 {
@@ -94,6 +233,11 @@ void scan_media_files(void)
         return;
     }
 
+    // Entries can be inserted before the slide on screen (pages of a PDF
+    // counted since the last scan), so it is found again by path
+    MediaFile* current = eina_list_nth(media_files, current_media_index);
+    char* current_path = current && current->path ? strdup(current->path) : NULL;
+
     // Free any existing media file list before scanning
     MediaFile* media_file;
     EINA_LIST_FREE(media_files, media_file)
@@ -105,6 +249,7 @@ void scan_media_files(void)
     dir = opendir(images_dir_runtime);
     if (!dir) {
         ERR("Could not open images directory: %s", images_dir_runtime);
+        free(current_path);
         return;
     }
 
@@ -122,7 +267,13 @@ void scan_media_files(void)
             filepath = strdup(eina_strbuf_string_get(filepath_buf));
 
             // Check if it's a regular file
-            if (stat(filepath, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+            if (stat(filepath, &file_stat) == 0 && S_ISREG(file_stat.st_mode)
+                && (eina_str_has_extension(filepath, ".pdf")
+                    || eina_str_has_extension(filepath, ".eslpack"))) {
+                // Every page of a PDF and every frame of a pack is a slide of its own
+                _append_parts(filepath);
+                free(filepath);
+            } else if (stat(filepath, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
                 // Create media file structure
                 MediaFile* new_media = malloc(sizeof(MediaFile));
                 if (new_media) {
@@ -152,6 +303,20 @@ void scan_media_files(void)
         INF("Loaded %d media files", eina_list_count(media_files));
     }
 
+    if (current_path) {
+        int index = 0;
+        Eina_List* l;
+        EINA_LIST_FOREACH(media_files, l, media_file)
+        {
+            if (strcmp(media_file->path, current_path) == 0) {
+                current_media_index = index;
+                break;
+            }
+            index++;
+        }
+        free(current_path);
+    }
+
     // Update cache metadata
     struct stat dir_stat;
     if (stat(images_dir_runtime, &dir_stat) == 0) {
@@ -232,6 +397,14 @@ void media_cleanup(void)
     }
     media_files = NULL;
 
+    Raw_Preview* rp;
+    EINA_LIST_FREE(raw_previews, rp)
+    {
+        _raw_preview_free(rp);
+    }
+    document_shutdown();
+    pack_shutdown();
+
     // Clean up cache metadata
     free(cache_dir_path);
     cache_dir_path = NULL;
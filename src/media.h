@@ -9,15 +9,29 @@
 
 // File type detection functions
 Eina_Bool is_image_file(const char* filename);
+Eina_Bool is_raw_file(const char* filename);
 Eina_Bool is_video_file(const char* filename);
+// PDF and SVG documents, and the "<file>.pdf#<page>" entries listed for PDFs
+Eina_Bool is_document_file(const char* filename);
+// Slideshow packs, and the "<file>.eslpack#<frame>" entries listed for them
+Eina_Bool is_pack_file(const char* filename);
 Eina_Bool is_media_file(const char* filename);
 
+// File on disk behind a catalog path: path itself, or for a PDF page or a
+// pack frame ("<file>#<n>") the file, written into buf. Safe on any thread.
+const char* media_source_file(const char* path, char* buf, size_t size);
+
 // Media file management functions
 void free_media_file(MediaFile* media_file);
 void scan_media_files(void);
 int get_media_file_count(void);
 char* get_media_path_at_index(int index);
 
+// RAW camera files: map the embedded full-size JPEG preview as a virtual file.
+// Repeated calls for the same path return the same mapping (so Evas' image cache
+// is shared between preload and display); caller closes the returned reference.
+Eina_File* media_raw_preview_open(const char* path);
+
 // Media file list cleanup
 void media_cleanup(void);
 
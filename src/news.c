@@ -1,5 +1,6 @@
 #include "news.h"
 #include "common.h"
+#include "contrast.h"
 #include <Elementary.h>
 #include <Ecore.h>
 #include <Ecore_Con.h>
@@ -99,8 +100,8 @@ static void _news_update_label(const char* text)
         return;
     char formatted_text[1024];
     snprintf(formatted_text, sizeof(formatted_text),
-        "<font=Open Sans:style=Light><color=#FFFFFF><font_size=24>%s</font_size></color></font>",
-        text);
+        "<font=Open Sans:style=Light>%s<font_size=24>%s</font_size></color></font>",
+        contrast_color_tag(CONTRAST_NEWS), text);
     elm_object_text_set(news_label, formatted_text);
     if (news_visible)
         evas_object_show(news_label);
@@ -276,6 +277,12 @@ void on_letterbox_resize_news(
     int py = y + (h / 10); // position higher on screen for better visibility
     evas_object_move(news_label, px, py);
     evas_object_raise(news_label);
+    contrast_region_set(CONTRAST_NEWS, obj, news_label);
+}
+
+void news_refresh(void)
+{
+    _news_show_current();
 }
 
 void news_init(Evas_Object* parent_window)
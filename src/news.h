@@ -19,6 +19,9 @@ void news_toggle(void);
 // Explicitly set visibility
 void news_set_visible(Eina_Bool visible);
 
+// Re-render the current title, e.g. after its contrast style changed
+void news_refresh(void);
+
 // Cleanup resources
 void news_cleanup(void);
 
@@ -0,0 +1,125 @@
+#include "night.h"
+#include "decode.h"
+#include "slideshow.h"
+#include <math.h>
+
+// How often the schedule is checked
+#define NIGHT_CHECK_INTERVAL 60.0
+// Strongest dimming and warming, at level 1
+#define NIGHT_DIM_MAX 0.5
+#define NIGHT_GREEN_CUT_MAX 0.25
+#define NIGHT_BLUE_CUT_MAX 0.6
+
+static Ecore_Timer* night_timer = NULL;
+static int start_minute = 0;
+static int end_minute = 0;
+static double night_level = 0.0;
+static Eina_Bool active = EINA_FALSE;
+
+static Eina_Bool _parse_time(const char* s, int* minute)
+{
+    int h, m, n = 0;
+    if (sscanf(s, "%d:%d%n", &h, &m, &n) != 2 || h < 0 || h > 23 || m < 0 || m > 59)
+        return EINA_FALSE;
+    *minute = h * 60 + m;
+    return s[n] == '\0';
+}
+
+static Eina_Bool _parse_schedule(const char* schedule, int* start, int* end)
+{
+    const char* dash = strchr(schedule, '-');
+    if (!dash)
+        return EINA_FALSE;
+    char first[8];
+    size_t len = (size_t) (dash - schedule);
+    if (len == 0 || len >= sizeof(first))
+        return EINA_FALSE;
+    memcpy(first, schedule, len);
+    first[len] = '\0';
+    return _parse_time(first, start) && _parse_time(dash + 1, end) && *start != *end;
+}
+
+static Eina_Bool _in_window(void)
+{
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    int minute = tm.tm_hour * 60 + tm.tm_min;
+    if (start_minute < end_minute)
+        return minute >= start_minute && minute < end_minute;
+    return minute >= start_minute || minute < end_minute;
+}
+
+// Dim everything and cut blue, and to a lesser degree green, for a warmer
+// white point
+static void _lut_build(double level, Pixels_Lut* lut)
+{
+    double dim = 1.0 - NIGHT_DIM_MAX * level;
+    double gr = dim, gg = dim * (1.0 - NIGHT_GREEN_CUT_MAX * level);
+    double gb = dim * (1.0 - NIGHT_BLUE_CUT_MAX * level);
+    for (int i = 0; i < 256; i++) {
+        lut->r[i] = (uint8_t) lround(i * gr);
+        lut->g[i] = (uint8_t) lround(i * gg);
+        lut->b[i] = (uint8_t) lround(i * gb);
+    }
+}
+
+static void _apply(Eina_Bool on)
+{
+    active = on;
+    if (on) {
+        Pixels_Lut lut;
+        _lut_build(night_level, &lut);
+        decode_set_lut(&lut);
+    } else {
+        decode_set_lut(NULL);
+    }
+    INF("Night mode %s", on ? "on" : "off");
+    slideshow_redecode();
+}
+
+static Eina_Bool _night_timer_cb(void* data EINA_UNUSED)
+{
+    Eina_Bool want = _in_window();
+    if (want != active)
+        _apply(want);
+    return ECORE_CALLBACK_RENEW;
+}
+
+Eina_Bool night_set_schedule(const char* schedule, double level)
+{
+    if (night_timer) {
+        ecore_timer_del(night_timer);
+        night_timer = NULL;
+    }
+    Eina_Bool valid = EINA_TRUE;
+    Eina_Bool want = EINA_FALSE;
+    if (schedule && schedule[0]) {
+        valid = _parse_schedule(schedule, &start_minute, &end_minute);
+        if (valid) {
+            night_level = level < 0.0 ? 0.0 : (level > 1.0 ? 1.0 : level);
+            night_timer = ecore_timer_add(NIGHT_CHECK_INTERVAL, _night_timer_cb, NULL);
+            want = _in_window();
+            INF("Night mode from %02d:%02d to %02d:%02d at level %.2f", start_minute / 60,
+                start_minute % 60, end_minute / 60, end_minute % 60, night_level);
+        }
+    }
+    // A new level needs a new LUT even when night mode stays on
+    if (want || active)
+        _apply(want);
+    return valid;
+}
+
+Eina_Bool night_is_active(void)
+{
+    return active;
+}
+
+void night_shutdown(void)
+{
+    if (night_timer) {
+        ecore_timer_del(night_timer);
+        night_timer = NULL;
+    }
+    active = EINA_FALSE;
+}
@@ -0,0 +1,21 @@
+#ifndef NIGHT_H
+#define NIGHT_H
+
+#include "common.h"
+
+// Night mode: between a scheduled start and end time of day, decoded slides
+// are dimmed and warmed through a per-channel colour LUT that the decode
+// workers apply once per slide, so rendering costs nothing extra. Images
+// loaded by Evas itself and videos are shown unchanged.
+
+// Set the schedule as "HH:MM-HH:MM" (local time, may wrap past midnight)
+// and the strength 0..1. NULL or "" turns night mode off. Returns
+// EINA_FALSE, leaving night mode off, when the schedule does not parse.
+Eina_Bool night_set_schedule(const char* schedule, double level);
+
+// Whether the night LUT is in effect now
+Eina_Bool night_is_active(void);
+
+void night_shutdown(void);
+
+#endif /* NIGHT_H */
@@ -0,0 +1,459 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "pack.h"
+#include "media.h"
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#define PACK_MAGIC "ESLPACK" // with its NUL, fills Pack_Header.magic
+#define PACK_VERSION 1
+#define PACK_BYTE_ORDER 0x01020304u
+// Frames start on cache-line boundaries
+#define PACK_ALIGN 64
+// Largest frame side accepted from a pack or for building one
+#define PACK_SIDE_MAX 8192
+// Stills decoded ahead of the one being written
+#define PACK_LOOKAHEAD 4
+
+enum { PACK_CODEC_RAW = 0, PACK_CODEC_LZ4 = 1 };
+
+// File header, in the byte order of the device that built the pack (packs
+// are built for the devices that play them; byte_order rejects the others)
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t count; // index entries in use
+    uint32_t w;     // size the frames were fitted inside
+    uint32_t h;
+    uint32_t reserved;
+} Pack_Header;
+
+// Index entry for one frame; the index directly follows the header
+typedef struct {
+    uint64_t offset; // from the start of the file
+    uint32_t size;   // bytes stored
+    uint32_t w;
+    uint32_t h;
+    uint32_t codec;
+} Pack_Entry;
+
+// A pack kept open by the catalog
+typedef struct {
+    Eina_File* file;
+    void* map;
+} Pack_Open;
+
+// path -> Pack_Open*, main loop only
+static Eina_Hash* packs = NULL;
+
+static const Pack_Header* _header(const unsigned char* map, size_t size)
+{
+    if (!map || size < sizeof(Pack_Header))
+        return NULL;
+    const Pack_Header* hdr = (const Pack_Header*) map;
+    if (memcmp(hdr->magic, PACK_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != PACK_VERSION
+        || hdr->byte_order != PACK_BYTE_ORDER
+        || hdr->count > (size - sizeof(Pack_Header)) / sizeof(Pack_Entry))
+        return NULL;
+    return hdr;
+}
+
+static void _pack_open_free(void* data)
+{
+    Pack_Open* po = data;
+    if (!po)
+        return;
+    if (po->map)
+        eina_file_map_free(po->file, po->map);
+    eina_file_close(po->file);
+    free(po);
+}
+
+int pack_frame_count(const char* file)
+{
+    Eina_File* f = file ? eina_file_open(file, EINA_FALSE) : NULL;
+    if (!f)
+        return 0;
+    void* map = eina_file_map_all(f, EINA_FILE_RANDOM);
+    const Pack_Header* hdr = _header(map, eina_file_size_get(f));
+    int count = hdr ? (int) hdr->count : 0;
+    Pack_Open* po = count > 0 ? calloc(1, sizeof(Pack_Open)) : NULL;
+    if (!po) {
+        if (map)
+            eina_file_map_free(f, map);
+        eina_file_close(f);
+        return count;
+    }
+    // Held mapped: workers opening the same file share this mapping, and a
+    // rebuilt pack replaces it on the next scan
+    po->file = f;
+    po->map = map;
+    if (!packs)
+        packs = eina_hash_string_superfast_new(_pack_open_free);
+    _pack_open_free(eina_hash_set(packs, file, po));
+    return count;
+}
+
+static Decoded_Slide* _frame_copy(const unsigned char* map, size_t size, const Pack_Entry* e)
+{
+    if (e->w == 0 || e->h == 0 || e->w > PACK_SIDE_MAX || e->h > PACK_SIDE_MAX
+        || e->offset > size || e->size > size - e->offset)
+        return NULL;
+    size_t bytes = (size_t) e->w * e->h * sizeof(uint32_t);
+    Decoded_Slide* slide = calloc(1, sizeof(Decoded_Slide));
+    if (!slide)
+        return NULL;
+    slide->pixels = malloc(bytes);
+    const unsigned char* src = map + e->offset;
+    Eina_Bool ok = EINA_FALSE;
+    if (slide->pixels && e->codec == PACK_CODEC_RAW && e->size == bytes) {
+        memcpy(slide->pixels, src, bytes);
+        ok = EINA_TRUE;
+    }
+#ifdef HAVE_LZ4
+    else if (slide->pixels && e->codec == PACK_CODEC_LZ4)
+        ok = LZ4_decompress_safe((const char*) src, (char*) slide->pixels, (int) e->size,
+                 (int) bytes)
+            == (int) bytes;
+#endif
+    if (!ok) {
+        decoded_slide_free(slide);
+        return NULL;
+    }
+    slide->w = (int) e->w;
+    slide->h = (int) e->h;
+    slide->orientation = 1;
+    return slide;
+}
+
+Decoded_Slide* pack_frame_get(const char* path)
+{
+    const char* hash = path ? strrchr(path, '#') : NULL;
+    if (!hash)
+        return NULL;
+    long frame = strtol(hash + 1, NULL, 10);
+    char file[PATH_MAX];
+    snprintf(file, sizeof(file), "%.*s", (int) (hash - path), path);
+    Eina_File* f = eina_file_open(file, EINA_FALSE);
+    if (!f)
+        return NULL;
+    size_t size = eina_file_size_get(f);
+    const unsigned char* map = eina_file_map_all(f, EINA_FILE_RANDOM);
+    const Pack_Header* hdr = _header(map, size);
+    Decoded_Slide* slide = NULL;
+    if (hdr && frame >= 1 && frame <= (long) hdr->count) {
+        const Pack_Entry* index = (const Pack_Entry*) (map + sizeof(Pack_Header));
+        slide = _frame_copy(map, size, &index[frame - 1]);
+    }
+    if (!slide)
+        WRN("Invalid pack frame %s", path);
+    if (map)
+        eina_file_map_free(f, (void*) map);
+    eina_file_close(f);
+    return slide;
+}
+
+// Pack build: stills are decoded by the background decoder, a bounded
+// number ahead, and written out in catalog order from the main loop
+typedef enum {
+    PACK_FRAME_PENDING,
+    PACK_FRAME_READY, // decoded and held by the decode cache
+    PACK_FRAME_FAILED,
+} Pack_Frame_State;
+
+static char** build_paths = NULL;          // stills in catalog order
+static unsigned char* build_states = NULL; // Pack_Frame_State per still
+static unsigned int build_count = 0;
+static unsigned int build_requested = 0; // frames handed to the decoder
+static unsigned int build_written = 0;   // frames past the writer, packed or skipped
+static Pack_Entry* build_index = NULL;
+static unsigned int build_packed = 0;
+static FILE* build_fp = NULL;
+static Eina_Strbuf* build_part = NULL;
+static char* build_dest = NULL;
+static int build_w = PACK_DEFAULT_W, build_h = PACK_DEFAULT_H;
+static Eina_Bool build_lz4 = EINA_FALSE;
+static uint64_t build_offset = 0;
+static double raw_mb = 0.0, stored_mb = 0.0;
+static double build_start = 0.0;
+static Ecore_Idler* build_idler = NULL;
+static Eina_Bool build_finished = EINA_TRUE;
+static Eina_Bool build_succeeded = EINA_FALSE;
+#ifdef HAVE_LZ4
+static char* scratch = NULL;
+static int scratch_size = 0;
+#endif
+
+static Eina_Bool _build_idler_cb(void* data);
+
+static void _build_free(void)
+{
+    for (unsigned int i = 0; i < build_count; i++)
+        free(build_paths[i]);
+    free(build_paths);
+    build_paths = NULL;
+    free(build_states);
+    build_states = NULL;
+    build_count = build_requested = build_written = 0;
+    free(build_index);
+    build_index = NULL;
+    if (build_fp)
+        fclose(build_fp);
+    build_fp = NULL;
+    if (build_part)
+        eina_strbuf_free(build_part);
+    build_part = NULL;
+    free(build_dest);
+    build_dest = NULL;
+#ifdef HAVE_LZ4
+    free(scratch);
+    scratch = NULL;
+    scratch_size = 0;
+#endif
+}
+
+static Eina_Bool _frame_write(const char* path, const Decoded_Slide* slide)
+{
+    static const unsigned char zeros[PACK_ALIGN];
+    size_t bytes = (size_t) slide->w * slide->h * sizeof(uint32_t);
+    const void* data = slide->pixels;
+    size_t stored = bytes;
+    uint32_t codec = PACK_CODEC_RAW;
+#ifdef HAVE_LZ4
+    if (build_lz4) {
+        int bound = LZ4_compressBound((int) bytes);
+        if (bound > scratch_size) {
+            free(scratch);
+            scratch = malloc((size_t) bound);
+            scratch_size = scratch ? bound : 0;
+        }
+        int n = scratch
+            ? LZ4_compress_default((const char*) slide->pixels, scratch, (int) bytes, bound)
+            : 0;
+        // Frames that do not shrink are stored raw and copied straight out
+        if (n > 0 && (size_t) n < bytes) {
+            data = scratch;
+            stored = (size_t) n;
+            codec = PACK_CODEC_LZ4;
+        }
+    }
+#endif
+    size_t pad = (PACK_ALIGN - stored % PACK_ALIGN) % PACK_ALIGN;
+    if (fwrite(data, 1, stored, build_fp) != stored || fwrite(zeros, 1, pad, build_fp) != pad)
+        return EINA_FALSE;
+    Pack_Entry* e = &build_index[build_packed++];
+    e->offset = build_offset;
+    e->size = (uint32_t) stored;
+    e->w = (uint32_t) slide->w;
+    e->h = (uint32_t) slide->h;
+    e->codec = codec;
+    build_offset += stored + pad;
+    raw_mb += bytes / 1048576.0;
+    stored_mb += stored / 1048576.0;
+    INF("Packed %u/%u: %s (%dx%d%s)", build_packed, build_count, path, slide->w, slide->h,
+        codec == PACK_CODEC_LZ4 ? ", lz4" : "");
+    return EINA_TRUE;
+}
+
+// Write the header and index over the gap left for them, and put the pack in
+// place; quits the main loop
+static void _build_finish(Eina_Bool ok)
+{
+    if (build_finished)
+        return;
+    build_finished = EINA_TRUE;
+    const char* part = eina_strbuf_string_get(build_part);
+    Pack_Header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, PACK_MAGIC, sizeof(hdr.magic));
+    hdr.version = PACK_VERSION;
+    hdr.byte_order = PACK_BYTE_ORDER;
+    hdr.count = build_packed;
+    hdr.w = (uint32_t) build_w;
+    hdr.h = (uint32_t) build_h;
+    if (ok && build_packed == 0) {
+        ERR("None of the stills in %s could be decoded", media_get_images_dir());
+        ok = EINA_FALSE;
+    } else if (!ok) {
+        ERR("Writing %s failed: %s", part, strerror(errno));
+    }
+    ok = ok && fseeko(build_fp, 0, SEEK_SET) == 0 && fwrite(&hdr, sizeof(hdr), 1, build_fp) == 1
+        && fwrite(build_index, sizeof(Pack_Entry), build_count, build_fp) == build_count;
+    if (fclose(build_fp) != 0)
+        ok = EINA_FALSE;
+    build_fp = NULL;
+    if (ok && rename(part, build_dest) != 0) {
+        ERR("Cannot replace %s: %s", build_dest, strerror(errno));
+        ok = EINA_FALSE;
+    }
+    if (ok)
+        INF("Wrote %s: %u frames inside %dx%d, %.1f MB (%.1f MB uncompressed) in %.1f s",
+            build_dest, build_packed, build_w, build_h, stored_mb, raw_mb,
+            ecore_time_get() - build_start);
+    else
+        unlink(part);
+    build_succeeded = ok;
+    build_idler = NULL;
+    _build_free();
+    elm_exit();
+}
+
+static void _on_frame_decoded(void* data, const char* path EINA_UNUSED, const Decoded_Slide* slide)
+{
+    unsigned int i = (unsigned int) (uintptr_t) data;
+    if (build_finished || i >= build_count)
+        return;
+    build_states[i] = slide ? PACK_FRAME_READY : PACK_FRAME_FAILED;
+    // Resume the writer (unless this ran synchronously from within it)
+    if (!build_idler)
+        build_idler = ecore_idler_add(_build_idler_cb, NULL);
+}
+
+// Keep up to PACK_LOOKAHEAD frames decoding past the one to write next
+static void _request_ahead(void)
+{
+    while (build_requested < build_count && build_requested < build_written + PACK_LOOKAHEAD) {
+        unsigned int i = build_requested++;
+        decode_request(build_paths[i], build_w, build_h, _on_frame_decoded, (void*) (uintptr_t) i);
+    }
+}
+
+// Write every frame that is ready, in order, then request more
+static Eina_Bool _build_idler_cb(void* data EINA_UNUSED)
+{
+    if (build_finished)
+        return ECORE_CALLBACK_CANCEL;
+    while (build_written < build_requested) {
+        unsigned int i = build_written;
+        if (build_states[i] == PACK_FRAME_PENDING)
+            break;
+        if (build_states[i] == PACK_FRAME_FAILED) {
+            WRN("Not packing %s: it does not decode", build_paths[i]);
+        } else {
+            const Decoded_Slide* slide = decode_cache_get(build_paths[i], build_w, build_h);
+            if (!slide) {
+                // Dropped from the cache before its turn: decode it again
+                build_states[i] = PACK_FRAME_PENDING;
+                decode_request(build_paths[i], build_w, build_h, _on_frame_decoded,
+                    (void*) (uintptr_t) i);
+                break;
+            }
+            if (!_frame_write(build_paths[i], slide)) {
+                _build_finish(EINA_FALSE);
+                return ECORE_CALLBACK_CANCEL;
+            }
+        }
+        build_written++;
+    }
+    if (build_written == build_count) {
+        _build_finish(EINA_TRUE);
+        return ECORE_CALLBACK_CANCEL;
+    }
+    _request_ahead();
+    // Requests answered from the cache have already marked their frames
+    if (build_written < build_requested && build_states[build_written] != PACK_FRAME_PENDING)
+        return ECORE_CALLBACK_RENEW;
+    build_idler = NULL;
+    return ECORE_CALLBACK_CANCEL;
+}
+
+Eina_Bool pack_build_start(const char* dest, const char* size, Eina_Bool lz4)
+{
+    if (!dest || !*dest)
+        return EINA_FALSE;
+    build_w = PACK_DEFAULT_W;
+    build_h = PACK_DEFAULT_H;
+    if (size && *size && !common_parse_size(size, PACK_SIDE_MAX, &build_w, &build_h)) {
+        ERR("Invalid pack size '%s' (expected WxH)", size);
+        return EINA_FALSE;
+    }
+#ifndef HAVE_LZ4
+    if (lz4) {
+        WRN("Built without LZ4: pack frames are stored uncompressed");
+        lz4 = EINA_FALSE;
+    }
+#endif
+    build_lz4 = lz4;
+
+    // Stills only; frames of an existing pack are not packed again
+    unsigned int count = eina_list_count(media_files);
+    build_paths = calloc(count ? count : 1, sizeof(char*));
+    if (!build_paths)
+        return EINA_FALSE;
+    Eina_List* l;
+    MediaFile* mf;
+    EINA_LIST_FOREACH(media_files, l, mf)
+    {
+        if (mf->is_image && !is_pack_file(mf->path) && decode_is_supported(mf->path))
+            build_paths[build_count++] = strdup(mf->path);
+    }
+    if (build_count == 0) {
+        ERR("No stills to pack in %s", media_get_images_dir());
+        _build_free();
+        return EINA_FALSE;
+    }
+
+    build_dest = strdup(dest);
+    build_part = eina_strbuf_new();
+    eina_strbuf_append_printf(build_part, "%s.part", dest);
+    build_fp = fopen(eina_strbuf_string_get(build_part), "wb");
+    build_index = calloc(build_count, sizeof(Pack_Entry));
+    build_states = calloc(build_count, 1);
+    if (!build_fp || !build_index || !build_states) {
+        ERR("Cannot write %s: %s", eina_strbuf_string_get(build_part), strerror(errno));
+        if (build_fp)
+            unlink(eina_strbuf_string_get(build_part));
+        _build_free();
+        return EINA_FALSE;
+    }
+
+    // Frames first; the header and index are written over the gap at the end
+    build_offset = sizeof(Pack_Header) + (uint64_t) build_count * sizeof(Pack_Entry);
+    build_offset = (build_offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+    if (fseeko(build_fp, (off_t) build_offset, SEEK_SET) != 0) {
+        ERR("Cannot write %s: %s", eina_strbuf_string_get(build_part), strerror(errno));
+        unlink(eina_strbuf_string_get(build_part));
+        _build_free();
+        return EINA_FALSE;
+    }
+    build_packed = 0;
+    raw_mb = stored_mb = 0.0;
+    build_finished = EINA_FALSE;
+    build_succeeded = EINA_FALSE;
+    // Frames decoded ahead stay resident until written
+    decode_set_cache_slots(PACK_LOOKAHEAD + 1);
+    build_start = ecore_time_get();
+    build_idler = ecore_idler_add(_build_idler_cb, NULL);
+    return EINA_TRUE;
+}
+
+Eina_Bool pack_build_succeeded(void)
+{
+    return build_succeeded;
+}
+
+void pack_shutdown(void)
+{
+    if (build_idler) {
+        ecore_idler_del(build_idler);
+        build_idler = NULL;
+    }
+    if (!build_finished) {
+        unlink(eina_strbuf_string_get(build_part));
+        build_finished = EINA_TRUE;
+        _build_free();
+    }
+    if (packs) {
+        eina_hash_free(packs);
+        packs = NULL;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include "decode.h"
+
+// Slideshow packs: a catalog decoded ahead of time into one file of
+// display-sized, upright ARGB8888 frames, each stored raw or LZ4-compressed,
+// behind an index of offsets. A pack in the images directory is listed as one
+// slide per frame, "<file>.eslpack#<frame>". Showing a frame is an index
+// lookup in the mapped file and a copy (or an LZ4 decompression) on a decode
+// worker, so weak devices spend next to nothing on JPEG decoding. Frames go
+// through the decode cache like any other slide, and are only resampled when
+// the screen is smaller than the pack.
+
+#define PACK_DEFAULT_W 1920
+#define PACK_DEFAULT_H 1080
+
+// Start decoding every still in the scanned catalog (JPEG, RAW, PDF pages,
+// SVG) fitted inside size ("WxH", NULL for the default) on the background
+// decoder, a few ahead, and writing the frames in catalog order to dest,
+// which is replaced once complete. Needs decode_init(); the main loop is quit
+// when the pack is written. Returns EINA_FALSE if the build could not start.
+Eina_Bool pack_build_start(const char* dest, const char* size, Eina_Bool lz4);
+
+// Whether the last build wrote its pack
+Eina_Bool pack_build_succeeded(void);
+
+// Number of frames in a pack file, 0 when it is not a valid pack. Keeps the
+// file mapped until pack_shutdown(); call it on the main loop.
+int pack_frame_count(const char* file);
+
+// Copy out the frame named by a "<file>#<frame>" path. Safe on any thread.
+Decoded_Slide* pack_frame_get(const char* path);
+
+// Also abandons a build still running
+void pack_shutdown(void);
+
+#endif /* PACK_H */
@@ -0,0 +1,465 @@
+#include "pano.h"
+#include "exif.h"
+
+// Strip objects kept: the (at most two) on screen and the next one loading
+#define PANO_TILES 4
+// Narrower panoramas would only be enlarged to fill the height
+#define PANO_MIN_WIDTH 4096
+// Largest JPEG scale-down Evas applies while decoding
+#define PANO_SCALE_DOWN_MAX 8
+// Header probe results remembered before the cache is cleared
+#define PANO_PROBE_CACHE_MAX 256
+
+typedef struct {
+    Evas_Object* obj;
+    int index; // strip shown, -1 when unused
+    Eina_Bool loaded;
+} Pano_Tile;
+
+typedef enum {
+    PANO_PROBING,
+    PANO_WIDE,
+    PANO_NOT_WIDE,
+} Pano_Kind;
+
+// What the header probe found for one file
+typedef struct {
+    Pano_Kind kind;
+    int w; // upright size
+    int h;
+    Pano_Probe_Cb cb; // waiting for the probe, if any
+    const void* data;
+} Pano_Info;
+
+// Header probe run on a worker
+typedef struct {
+    char* path;
+    int w;
+    int h;
+    int orientation;
+    Eina_Bool ok;
+} Pano_Probe;
+
+static Evas_Object* letterbox_obj = NULL;
+static Evas_Object* clip = NULL;
+static Pano_Tile tiles[PANO_TILES];
+static Eina_Hash* probe_cache = NULL; // path -> Pano_Info*
+static Eina_List* probes = NULL;      // in-flight Ecore_Thread*
+
+// Panorama on screen
+static char* pano_path = NULL;
+static int src_w = 0, src_h = 0;
+static Evas_Coord lx, ly, lw, lh; // letterbox area
+static double scale = 1.0;        // display pixels per source pixel
+static double span = 0.0;         // display pixels panned over the slide
+static int scale_down = 1;
+static int strip_count = 0;
+static double offset = 0.0;
+
+static Ecore_Animator* animator = NULL;
+static double duration = 0.0;
+static double elapsed = 0.0;
+static double last_tick = 0.0;
+static Eina_Bool paused = EINA_FALSE;
+static Eina_Bool ready_sent = EINA_FALSE;
+static Pano_Ready_Cb ready_cb = NULL;
+static const void* ready_data = NULL;
+
+static void _ready(Eina_Bool ok)
+{
+    if (ready_sent)
+        return;
+    ready_sent = EINA_TRUE;
+    last_tick = ecore_time_get();
+    if (ready_cb)
+        ready_cb((void*) ready_data, ok);
+}
+
+static void _tile_place(Pano_Tile* t)
+{
+    double x0 = (double) t->index * lw;
+    double w = span + lw - x0 < lw ? span + lw - x0 : lw;
+    evas_object_move(t->obj, lx + (Evas_Coord) (x0 - offset), ly);
+    evas_object_resize(t->obj, (Evas_Coord) (w + 0.5), lh);
+}
+
+// Strips on screen at the current offset
+static void _visible(int* first, int* last)
+{
+    *first = (int) (offset / lw);
+    *last = (int) ((offset + lw - 1) / lw);
+    if (*last >= strip_count)
+        *last = strip_count - 1;
+}
+
+// Decode strip index into a tile, reusing the one furthest behind the pan
+static void _tile_request(int index)
+{
+    Pano_Tile* victim = NULL;
+    for (int i = 0; i < PANO_TILES; i++) {
+        if (tiles[i].index == index)
+            return;
+        if (!victim || tiles[i].index < victim->index)
+            victim = &tiles[i];
+    }
+    int first, last;
+    _visible(&first, &last);
+    if (victim->index >= first && victim->index <= last)
+        return;
+
+    victim->index = index;
+    victim->loaded = EINA_FALSE;
+    evas_object_hide(victim->obj);
+    int sx = (int) (index * lw / scale);
+    int sw = (int) (lw / scale + 0.5);
+    if (sx + sw > src_w)
+        sw = src_w - sx;
+    // Load options apply from the next file_set. The region is in the
+    // coordinates of the scaled-down upright image, as in decode.c.
+    int rw = sw / scale_down > 0 ? sw / scale_down : 1;
+    evas_object_image_file_set(victim->obj, NULL, NULL);
+    evas_object_image_load_scale_down_set(victim->obj, scale_down);
+    evas_object_image_load_region_set(victim->obj, sx / scale_down, 0, rw, src_h / scale_down);
+    evas_object_image_file_set(victim->obj, pano_path, NULL);
+    if (evas_object_image_load_error_get(victim->obj) != EVAS_LOAD_ERROR_NONE) {
+        WRN("Panorama strip %d of %s failed to load", index, pano_path);
+        victim->index = -1;
+        _ready(EINA_FALSE);
+        return;
+    }
+    evas_object_image_preload(victim->obj, EINA_FALSE);
+    DBG("Panorama strip %d: region %d+%d at 1/%d", index, sx, sw, scale_down);
+}
+
+static void _update(void)
+{
+    int first, last;
+    _visible(&first, &last);
+    for (int i = first; i <= last; i++)
+        _tile_request(i);
+    if (last + 1 < strip_count)
+        _tile_request(last + 1);
+
+    Eina_Bool shown = EINA_TRUE;
+    for (int i = 0; i < PANO_TILES; i++) {
+        Pano_Tile* t = &tiles[i];
+        Eina_Bool on_screen = t->index >= first && t->index <= last;
+        if (on_screen && t->loaded) {
+            _tile_place(t);
+            evas_object_show(t->obj);
+        } else {
+            evas_object_hide(t->obj);
+        }
+    }
+    for (int s = first; s <= last; s++) {
+        Eina_Bool loaded = EINA_FALSE;
+        for (int i = 0; i < PANO_TILES; i++)
+            loaded |= tiles[i].index == s && tiles[i].loaded;
+        shown &= loaded;
+    }
+    if (shown)
+        _ready(EINA_TRUE);
+}
+
+static void _on_tile_preloaded(
+    void* data, Evas* e EINA_UNUSED, Evas_Object* obj EINA_UNUSED, void* event_info EINA_UNUSED)
+{
+    Pano_Tile* t = data;
+    if (t->index < 0 || !pano_path)
+        return;
+    t->loaded = EINA_TRUE;
+    _update();
+}
+
+// Fit the panorama to the letterbox height and forget strips of another size
+static void _layout(void)
+{
+    evas_object_geometry_get(letterbox_obj, &lx, &ly, &lw, &lh);
+    if (lw <= 0)
+        lw = 1;
+    if (lh <= 0)
+        lh = 1;
+    evas_object_move(clip, lx, ly);
+    evas_object_resize(clip, lw, lh);
+    scale = (double) lh / src_h;
+    double width = src_w * scale;
+    span = width > lw ? width - lw : 0.0;
+    strip_count = (int) ((width + lw - 1) / lw);
+    scale_down = 1;
+    while (scale_down < PANO_SCALE_DOWN_MAX && src_h / (scale_down * 2) >= lh)
+        scale_down *= 2;
+    for (int i = 0; i < PANO_TILES; i++) {
+        tiles[i].index = -1;
+        tiles[i].loaded = EINA_FALSE;
+        evas_object_hide(tiles[i].obj);
+    }
+}
+
+static Eina_Bool _animator_cb(void* data EINA_UNUSED)
+{
+    if (!pano_path) {
+        animator = NULL;
+        return ECORE_CALLBACK_CANCEL;
+    }
+    double now = ecore_time_get();
+    // The pan starts with the first screenful and holds while paused
+    if (ready_sent && !paused)
+        elapsed += now - last_tick;
+    last_tick = now;
+    double t = duration > 0.0 ? elapsed / duration : 1.0;
+    if (t > 1.0)
+        t = 1.0;
+    // Ease in and out so the start and end of the pan are not abrupt
+    offset = span * t * t * (3.0 - 2.0 * t);
+    _update();
+    return ECORE_CALLBACK_RENEW;
+}
+
+static void _on_letterbox_geometry(
+    void* data EINA_UNUSED, Evas* e EINA_UNUSED, Evas_Object* obj EINA_UNUSED,
+    void* event_info EINA_UNUSED)
+{
+    if (!pano_path)
+        return;
+    _layout();
+    _update();
+}
+
+void pano_init(Evas_Object* letterbox, Evas_Object_Event_Cb on_click)
+{
+    if (letterbox_obj || !letterbox)
+        return;
+    Evas* evas = evas_object_evas_get(letterbox);
+    Evas_Object* win = elm_object_top_widget_get(letterbox);
+    letterbox_obj = letterbox;
+    clip = evas_object_rectangle_add(evas);
+    evas_object_color_set(clip, 255, 255, 255, 255);
+    evas_object_pass_events_set(clip, EINA_TRUE);
+    for (int i = 0; i < PANO_TILES; i++) {
+        Evas_Object* obj = evas_object_image_filled_add(evas);
+        evas_object_image_smooth_scale_set(obj, EINA_TRUE);
+        // Strips are cut from the upright image, whatever its EXIF rotation
+        evas_object_image_load_orientation_set(obj, EINA_TRUE);
+        evas_object_repeat_events_set(obj, EINA_TRUE);
+        if (on_click)
+            evas_object_event_callback_add(obj, EVAS_CALLBACK_MOUSE_UP, on_click, NULL);
+        evas_object_event_callback_add(
+            obj, EVAS_CALLBACK_IMAGE_PRELOADED, _on_tile_preloaded, &tiles[i]);
+        evas_object_clip_set(obj, clip);
+        if (win)
+            evas_object_stack_above(obj, win);
+        evas_object_hide(obj);
+        tiles[i].obj = obj;
+        tiles[i].index = -1;
+    }
+    evas_object_event_callback_add(
+        letterbox, EVAS_CALLBACK_RESIZE, _on_letterbox_geometry, NULL);
+    evas_object_event_callback_add(letterbox, EVAS_CALLBACK_MOVE, _on_letterbox_geometry, NULL);
+}
+
+void pano_shutdown(void)
+{
+    pano_stop();
+    // Cancelled probes finish on their own and find no cache to fill
+    Ecore_Thread* thread;
+    EINA_LIST_FREE(probes, thread)
+    {
+        ecore_thread_cancel(thread);
+    }
+    if (letterbox_obj) {
+        evas_object_event_callback_del(
+            letterbox_obj, EVAS_CALLBACK_RESIZE, _on_letterbox_geometry);
+        evas_object_event_callback_del(letterbox_obj, EVAS_CALLBACK_MOVE, _on_letterbox_geometry);
+        letterbox_obj = NULL;
+    }
+    for (int i = 0; i < PANO_TILES; i++) {
+        if (tiles[i].obj)
+            evas_object_del(tiles[i].obj);
+        tiles[i].obj = NULL;
+    }
+    if (clip) {
+        evas_object_del(clip);
+        clip = NULL;
+    }
+    if (probe_cache) {
+        eina_hash_free(probe_cache);
+        probe_cache = NULL;
+    }
+}
+
+// Read the frame header and EXIF orientation, without decoding anything
+static void _probe_run(void* data, Ecore_Thread* thread EINA_UNUSED)
+{
+    Pano_Probe* p = data;
+    p->ok = exif_jpeg_info(p->path, &p->w, &p->h, &p->orientation);
+}
+
+static void _probe_free(Pano_Probe* p)
+{
+    free(p->path);
+    free(p);
+}
+
+static void _probe_end(void* data, Ecore_Thread* thread)
+{
+    Pano_Probe* p = data;
+    probes = eina_list_remove(probes, thread);
+    Pano_Info* info = probe_cache ? eina_hash_find(probe_cache, p->path) : NULL;
+    if (!info) {
+        _probe_free(p);
+        return;
+    }
+    // Rotated a quarter turn, the stored width is the upright height
+    info->w = p->orientation >= 5 ? p->h : p->w;
+    info->h = p->orientation >= 5 ? p->w : p->h;
+    Eina_Bool wide = p->ok && info->w >= PANO_MIN_WIDTH
+        && (double) info->w / info->h >= PANO_MIN_ASPECT;
+    info->kind = wide ? PANO_WIDE : PANO_NOT_WIDE;
+    if (wide)
+        INF("Panorama: %s (%dx%d)", p->path, info->w, info->h);
+    Pano_Probe_Cb cb = info->cb;
+    const void* cb_data = info->data;
+    info->cb = NULL;
+    info->data = NULL;
+    if (cb)
+        cb((void*) cb_data, p->path, wide);
+    _probe_free(p);
+}
+
+static void _probe_cancel(void* data, Ecore_Thread* thread)
+{
+    Pano_Probe* p = data;
+    probes = eina_list_remove(probes, thread);
+    // Forgotten, so the next question probes again
+    if (probe_cache)
+        eina_hash_del_by_key(probe_cache, p->path);
+    _probe_free(p);
+}
+
+// Collect the keys of finished probes, which may be dropped
+static Eina_Bool _collect_finished(
+    const Eina_Hash* hash EINA_UNUSED, const void* key, void* value, void* fdata)
+{
+    Pano_Info* info = value;
+    Eina_List** finished = fdata;
+    if (info->kind != PANO_PROBING)
+        *finished = eina_list_append(*finished, key);
+    return EINA_TRUE;
+}
+
+// Cached probe result for path, starting the probe the first time
+static Pano_Info* _info_get(const char* path)
+{
+    if (!letterbox_obj || !path
+        || !(eina_str_has_extension(path, ".jpg") || eina_str_has_extension(path, ".jpeg")))
+        return NULL;
+    if (!probe_cache)
+        probe_cache = eina_hash_string_superfast_new(free);
+    if (!probe_cache)
+        return NULL;
+    Pano_Info* info = eina_hash_find(probe_cache, path);
+    if (info)
+        return info;
+
+    // Probes still running keep their entry and the callback waiting on it
+    if (eina_hash_population(probe_cache) >= PANO_PROBE_CACHE_MAX) {
+        Eina_List* finished = NULL;
+        const char* key;
+        eina_hash_foreach(probe_cache, _collect_finished, &finished);
+        EINA_LIST_FREE(finished, key)
+        {
+            eina_hash_del_by_key(probe_cache, key);
+        }
+    }
+    info = calloc(1, sizeof(Pano_Info));
+    Pano_Probe* p = info ? calloc(1, sizeof(Pano_Probe)) : NULL;
+    if (!p) {
+        free(info);
+        return NULL;
+    }
+    p->path = strdup(path);
+    info->kind = PANO_PROBING;
+    eina_hash_add(probe_cache, path, info);
+    Ecore_Thread* thread = ecore_thread_run(_probe_run, _probe_end, _probe_cancel, p);
+    if (thread)
+        probes = eina_list_append(probes, thread);
+    // A failed start has run the cancel callback, which dropped info
+    return eina_hash_find(probe_cache, path);
+}
+
+Eina_Bool pano_is_panorama(const char* path)
+{
+    Pano_Info* info = _info_get(path);
+    return info && info->kind == PANO_WIDE;
+}
+
+void pano_probe(const char* path, Pano_Probe_Cb cb, const void* data)
+{
+    Pano_Info* info = _info_get(path);
+    if (info && info->kind == PANO_PROBING) {
+        info->cb = cb;
+        info->data = data;
+        return;
+    }
+    if (cb)
+        cb((void*) data, path, info && info->kind == PANO_WIDE);
+}
+
+Eina_Bool pano_start(const char* path, double duration_s, Pano_Ready_Cb cb, const void* data)
+{
+    pano_stop();
+    Pano_Info* info = probe_cache && path ? eina_hash_find(probe_cache, path) : NULL;
+    if (!letterbox_obj || !info || info->kind != PANO_WIDE)
+        return EINA_FALSE;
+    src_w = info->w;
+    src_h = info->h;
+    pano_path = strdup(path);
+    if (!pano_path)
+        return EINA_FALSE;
+    duration = duration_s;
+    elapsed = 0.0;
+    offset = 0.0;
+    ready_sent = EINA_FALSE;
+    ready_cb = cb;
+    ready_data = data;
+    _layout();
+    evas_object_show(clip);
+    _update();
+    animator = ecore_animator_add(_animator_cb, NULL);
+    DBG("Panorama %s: %d strips at 1/%d, panning %.0f px over %.1f s", path, strip_count,
+        scale_down, span, duration);
+    return EINA_TRUE;
+}
+
+void pano_pause(Eina_Bool pause)
+{
+    paused = pause;
+}
+
+Eina_Bool pano_active(void)
+{
+    return pano_path != NULL;
+}
+
+void pano_stop(void)
+{
+    if (animator) {
+        ecore_animator_del(animator);
+        animator = NULL;
+    }
+    if (!pano_path)
+        return;
+    free(pano_path);
+    pano_path = NULL;
+    ready_cb = NULL;
+    ready_data = NULL;
+    for (int i = 0; i < PANO_TILES; i++) {
+        tiles[i].index = -1;
+        tiles[i].loaded = EINA_FALSE;
+        evas_object_hide(tiles[i].obj);
+        // Drop the decoded strip so only the panorama on screen holds memory
+        evas_object_image_file_set(tiles[i].obj, NULL, NULL);
+    }
+    if (clip)
+        evas_object_hide(clip);
+}
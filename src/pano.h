@@ -0,0 +1,50 @@
+#ifndef PANO_H
+#define PANO_H
+
+#include "common.h"
+
+// Panorama viewer. Wide JPEGs (stitched panoramas of tens of thousands of
+// pixels) fill the letterbox height and pan slowly from left to right over
+// the slide's dwell. Only the part on screen is decoded, one screen-wide
+// strip at a time, using Evas load regions at the coarsest JPEG scale that
+// still covers the screen. A few strip objects are reused as a tile cache,
+// so memory stays within a few screen-sized tiles whatever the file size.
+
+// Width-to-height ratio from which a JPEG is panned instead of fitted
+#define PANO_MIN_ASPECT 2.5
+
+// Readiness of the first screenful; ok is EINA_FALSE when the file failed
+typedef void (*Pano_Ready_Cb)(void* data, Eina_Bool ok);
+
+// Answer of a header probe, on the main loop
+typedef void (*Pano_Probe_Cb)(void* data, const char* path, Eina_Bool panorama);
+
+// Create the tile objects on letterbox's canvas; on_click gets mouse-up events
+void pano_init(Evas_Object* letterbox, Evas_Object_Event_Cb on_click);
+void pano_shutdown(void);
+
+// Whether path is shown as a panorama (a JPEG at least PANO_MIN_ASPECT times
+// wider than tall once upright). Only the header is read, on a worker, and
+// results are cached; EINA_FALSE while the first probe of a file runs.
+Eina_Bool pano_is_panorama(const char* path);
+
+// Probe path ahead of time (e.g. while preloading it) and tell cb the
+// answer, at once when it is cached. A later call for the same file
+// replaces a waiting cb.
+void pano_probe(const char* path, Pano_Probe_Cb cb, const void* data);
+
+// Show path and pan across it over duration seconds, replacing any panorama
+// on screen. path must be known to be a panorama. cb runs once the first
+// screenful is decoded.
+Eina_Bool pano_start(const char* path, double duration, Pano_Ready_Cb cb, const void* data);
+
+// Hold the pan (e.g. while a fade runs) and resume again
+void pano_pause(Eina_Bool paused);
+
+// Whether a panorama is on screen
+Eina_Bool pano_active(void);
+
+// Take the panorama off screen and release its tiles
+void pano_stop(void);
+
+#endif /* PANO_H */
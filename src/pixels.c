@@ -0,0 +1,631 @@
+#include "pixels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Mirror every row left-to-right (orientation 2)
+static void _mirror_rows(uint32_t* px, int w, int h)
+{
+    for (int y = 0; y < h; y++) {
+        uint32_t* a = px + (size_t) y * w;
+        uint32_t* b = a + w - 1;
+        while (a < b) {
+            uint32_t t = *a;
+            *a++ = *b;
+            *b-- = t;
+        }
+    }
+}
+
+// Reverse the whole buffer: rotate 180 degrees (orientation 3)
+static void _rotate_180(uint32_t* px, int w, int h)
+{
+    uint32_t* a = px;
+    uint32_t* b = px + (size_t) w * h - 1;
+    while (a < b) {
+        uint32_t t = *a;
+        *a++ = *b;
+        *b-- = t;
+    }
+}
+
+// Swap rows top-to-bottom (orientation 4)
+static void _flip_rows(uint32_t* px, int w, int h)
+{
+    size_t row = (size_t) w * sizeof(uint32_t);
+    uint32_t* tmp = malloc(row);
+    if (!tmp) {
+        // Fall back to per-pixel swaps when a scratch row can't be allocated
+        for (int y = 0; y < h / 2; y++)
+            for (int x = 0; x < w; x++) {
+                uint32_t t = px[(size_t) y * w + x];
+                px[(size_t) y * w + x] = px[(size_t) (h - 1 - y) * w + x];
+                px[(size_t) (h - 1 - y) * w + x] = t;
+            }
+        return;
+    }
+    for (int y = 0; y < h / 2; y++) {
+        uint32_t* a = px + (size_t) y * w;
+        uint32_t* b = px + (size_t) (h - 1 - y) * w;
+        memcpy(tmp, a, row);
+        memcpy(a, b, row);
+        memcpy(b, tmp, row);
+    }
+    free(tmp);
+}
+
+// Transposing orientations (5-8). Source (x, y) lands at destination
+// (dx0 + sx * y, dy0 + sy * x) in a buffer of width h; walking the source in
+// PIXELS_TILE squares keeps both the reads and the strided writes in cache.
+static void _transpose_blocked(
+    const uint32_t* src, uint32_t* dst, int w, int h, Eina_Bool flip_x, Eina_Bool flip_y)
+{
+    const int dw = h;
+    for (int ty = 0; ty < h; ty += PIXELS_TILE) {
+        int ey = ty + PIXELS_TILE < h ? ty + PIXELS_TILE : h;
+        for (int tx = 0; tx < w; tx += PIXELS_TILE) {
+            int ex = tx + PIXELS_TILE < w ? tx + PIXELS_TILE : w;
+            for (int y = ty; y < ey; y++) {
+                const uint32_t* s = src + (size_t) y * w;
+                int dx = flip_x ? (h - 1 - y) : y;
+                for (int x = tx; x < ex; x++) {
+                    int dy = flip_y ? (w - 1 - x) : x;
+                    dst[(size_t) dy * dw + dx] = s[x];
+                }
+            }
+        }
+    }
+}
+
+uint32_t* pixels_orient(uint32_t* src, int w, int h, int orientation, int* out_w, int* out_h)
+{
+    if (out_w)
+        *out_w = w;
+    if (out_h)
+        *out_h = h;
+    if (!src || w <= 0 || h <= 0)
+        return src;
+
+    switch (orientation) {
+    case 2:
+        _mirror_rows(src, w, h);
+        return src;
+    case 3:
+        _rotate_180(src, w, h);
+        return src;
+    case 4:
+        _flip_rows(src, w, h);
+        return src;
+    case 5:
+    case 6:
+    case 7:
+    case 8:
+        break;
+    default:
+        return src;
+    }
+
+    uint32_t* dst = malloc((size_t) w * h * sizeof(uint32_t));
+    if (!dst) {
+        free(src);
+        return NULL;
+    }
+    // 5: transpose, 6: rotate 90 CW, 7: transverse, 8: rotate 90 CCW
+    Eina_Bool flip_x = (orientation == 6 || orientation == 7);
+    Eina_Bool flip_y = (orientation == 7 || orientation == 8);
+    _transpose_blocked(src, dst, w, h, flip_x, flip_y);
+    free(src);
+    if (out_w)
+        *out_w = h;
+    if (out_h)
+        *out_h = w;
+    return dst;
+}
+
+// Resampling weights are 2.14 fixed point: a full tap is 1 << 14
+#define PIXELS_WEIGHT_BITS 14
+#define PIXELS_LANCZOS_LOBES 3
+
+// Source span feeding one output pixel
+typedef struct {
+    int start;
+    int count;
+} Pixels_Span;
+
+// Per-axis filter: spans[i] and taps weights per output pixel (weights are
+// padded with zeros up to taps)
+typedef struct {
+    Pixels_Span* spans;
+    int16_t* weights;
+    int taps;
+} Pixels_Filter;
+
+const char* pixels_kernel_name(Pixels_Kernel kernel)
+{
+    return kernel == PIXELS_KERNEL_LANCZOS ? "lanczos" : "area";
+}
+
+int pixels_kernel_parse(const char* name)
+{
+    if (!name)
+        return -1;
+    if (strcmp(name, "area") == 0)
+        return PIXELS_KERNEL_AREA;
+    if (strcmp(name, "lanczos") == 0)
+        return PIXELS_KERNEL_LANCZOS;
+    return -1;
+}
+
+const char* pixels_simd_name(void)
+{
+#if defined(__SSE2__)
+    return "SSE2";
+#elif defined(__ARM_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+static double _sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+// Weight of source pixel j (covering [j, j + 1)) for the output pixel whose
+// footprint is centred on center, in source pixel units
+static double _kernel_weight(Pixels_Kernel kernel, double scale, double center, int j)
+{
+    if (kernel == PIXELS_KERNEL_LANCZOS) {
+        double fs = scale < 1.0 ? 1.0 / scale : 1.0;
+        double x = (j + 0.5 - center) / fs;
+        if (x <= -PIXELS_LANCZOS_LOBES || x >= PIXELS_LANCZOS_LOBES)
+            return 0.0;
+        return _sinc(x) * _sinc(x / PIXELS_LANCZOS_LOBES);
+    }
+    if (scale < 1.0) {
+        // Coverage of [j, j + 1) by the output pixel's footprint
+        double half = 0.5 / scale;
+        double lo = center - half > j ? center - half : j;
+        double hi = center + half < j + 1 ? center + half : j + 1;
+        return hi > lo ? hi - lo : 0.0;
+    }
+    double d = fabs(j + 0.5 - center);
+    return d < 1.0 ? 1.0 - d : 0.0;
+}
+
+static void _filter_free(Pixels_Filter* f)
+{
+    free(f->spans);
+    free(f->weights);
+}
+
+static Eina_Bool _filter_build(Pixels_Filter* f, int sn, int dn, Pixels_Kernel kernel)
+{
+    double scale = (double) dn / sn;
+    double support;
+    if (kernel == PIXELS_KERNEL_LANCZOS)
+        support = PIXELS_LANCZOS_LOBES * (scale < 1.0 ? 1.0 / scale : 1.0);
+    else
+        support = scale < 1.0 ? 0.5 / scale : 1.0;
+    f->taps = (int) ceil(support * 2.0) + 3;
+    f->spans = calloc(dn, sizeof(Pixels_Span));
+    f->weights = calloc((size_t) dn * f->taps, sizeof(int16_t));
+    double* w = malloc(f->taps * sizeof(double));
+    if (!f->spans || !f->weights || !w) {
+        free(w);
+        _filter_free(f);
+        return EINA_FALSE;
+    }
+
+    for (int i = 0; i < dn; i++) {
+        double center = (i + 0.5) / scale;
+        int lo = (int) floor(center - support);
+        int hi = (int) ceil(center + support);
+        int start = lo < 0 ? 0 : lo;
+        int end = hi > sn - 1 ? sn - 1 : hi;
+        int count = end - start + 1;
+        if (count > f->taps)
+            count = f->taps;
+        memset(w, 0, f->taps * sizeof(double));
+        double sum = 0.0;
+        // Taps past the edges are folded onto the edge pixels
+        for (int j = lo; j <= hi; j++) {
+            int k = (j < start ? start : (j > end ? end : j)) - start;
+            if (k >= count)
+                k = count - 1;
+            double v = _kernel_weight(kernel, scale, center, j);
+            w[k] += v;
+            sum += v;
+        }
+        if (sum == 0.0) {
+            // Degenerate footprint: nearest pixel
+            int j = (int) center;
+            start = j < sn ? j : sn - 1;
+            count = 1;
+            w[0] = sum = 1.0;
+        }
+
+        // Quantize so the weights sum to exactly one: flat areas stay flat
+        int16_t* q = f->weights + (size_t) i * f->taps;
+        int total = 0, peak = 0;
+        for (int k = 0; k < count; k++) {
+            q[k] = (int16_t) lrint(w[k] / sum * (1 << PIXELS_WEIGHT_BITS));
+            total += q[k];
+            if (q[k] > q[peak])
+                peak = k;
+        }
+        q[peak] += (1 << PIXELS_WEIGHT_BITS) - total;
+        f->spans[i].start = start;
+        f->spans[i].count = count;
+    }
+    free(w);
+    return EINA_TRUE;
+}
+
+// Filter one source row into column-major output: output pixel i goes to
+// dst[i * dst_stride]. Two such passes resample and transpose back.
+static void _filter_row(const uint32_t* row, uint32_t* dst, int dst_stride, int dn,
+    const Pixels_Filter* f)
+{
+    for (int i = 0; i < dn; i++) {
+        const uint32_t* s = row + f->spans[i].start;
+        const int16_t* w = f->weights + (size_t) i * f->taps;
+        int n = f->spans[i].count;
+        int k = 0;
+#if defined(__SSE2__)
+        // Two taps per step: interleave their channels as 16-bit pairs and
+        // let madd form a0*w0 + b0*w1 per channel
+        __m128i zero = _mm_setzero_si128();
+        __m128i acc = _mm_set1_epi32(1 << (PIXELS_WEIGHT_BITS - 1));
+        for (; k + 1 < n; k += 2) {
+            __m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) s[k]), zero);
+            __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) s[k + 1]), zero);
+            __m128i wt = _mm_set1_epi32((int) (((uint32_t) (uint16_t) w[k + 1] << 16)
+                | (uint16_t) w[k]));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), wt));
+        }
+        if (k < n) {
+            __m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) s[k]), zero);
+            __m128i wt = _mm_set1_epi32((uint16_t) w[k]);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), wt));
+        }
+        acc = _mm_srai_epi32(acc, PIXELS_WEIGHT_BITS);
+        // Saturating packs clamp Lanczos overshoot to 0..255
+        acc = _mm_packs_epi32(acc, acc);
+        dst[(size_t) i * dst_stride] = (uint32_t) _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+#elif defined(__ARM_NEON)
+        int32x4_t acc = vdupq_n_s32(1 << (PIXELS_WEIGHT_BITS - 1));
+        for (; k < n; k++) {
+            uint8x8_t p = vreinterpret_u8_u32(vdup_n_u32(s[k]));
+            int16x4_t c = vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(p)));
+            acc = vmlal_n_s16(acc, c, w[k]);
+        }
+        int16x4_t narrow = vqshrn_n_s32(acc, PIXELS_WEIGHT_BITS);
+        uint8x8_t out = vqmovun_s16(vcombine_s16(narrow, narrow));
+        dst[(size_t) i * dst_stride] = vget_lane_u32(vreinterpret_u32_u8(out), 0);
+#else
+        int32_t acc[4] = { 0, 0, 0, 0 };
+        for (; k < n; k++) {
+            for (int c = 0; c < 4; c++)
+                acc[c] += (int32_t) ((s[k] >> (c * 8)) & 0xff) * w[k];
+        }
+        uint32_t out = 0;
+        for (int c = 0; c < 4; c++) {
+            int32_t v = (acc[c] + (1 << (PIXELS_WEIGHT_BITS - 1))) >> PIXELS_WEIGHT_BITS;
+            v = v < 0 ? 0 : (v > 255 ? 255 : v);
+            out |= (uint32_t) v << (c * 8);
+        }
+        dst[(size_t) i * dst_stride] = out;
+#endif
+    }
+}
+
+uint32_t* pixels_resample(const uint32_t* src, int sw, int sh, int dw, int dh, Pixels_Kernel kernel)
+{
+    return pixels_resample_region(src, sw, 0, 0, sw, sh, dw, dh, kernel);
+}
+
+uint32_t* pixels_resample_region(const uint32_t* src, int stride, int sx, int sy, int sw, int sh,
+    int dw, int dh, Pixels_Kernel kernel)
+{
+    if (!src || sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0 || sx < 0 || sy < 0
+        || sx + sw > stride)
+        return NULL;
+
+    Pixels_Filter fx, fy;
+    if (!_filter_build(&fx, sw, dw, kernel))
+        return NULL;
+    if (!_filter_build(&fy, sh, dh, kernel)) {
+        _filter_free(&fx);
+        return NULL;
+    }
+    // Horizontal pass into a transposed dw x sh buffer, then the same row
+    // kernel over its rows transposes back while filtering vertically
+    uint32_t* tmp = malloc((size_t) dw * sh * sizeof(uint32_t));
+    uint32_t* dst = malloc((size_t) dw * dh * sizeof(uint32_t));
+    if (tmp && dst) {
+        for (int y = 0; y < sh; y++)
+            _filter_row(src + (size_t) (sy + y) * stride + sx, tmp + y, sh, dw, &fx);
+        for (int x = 0; x < dw; x++)
+            _filter_row(tmp + (size_t) x * sh, dst + x, dw, dh, &fy);
+    } else {
+        free(dst);
+        dst = NULL;
+    }
+    free(tmp);
+    _filter_free(&fx);
+    _filter_free(&fy);
+    return dst;
+}
+
+void pixels_sharpen(uint32_t* px, int w, int h, double amount)
+{
+    if (!px || w < 3 || h < 3 || amount <= 0.0)
+        return;
+    // 8.8 fixed point gain
+    int gain = (int) (amount * 256.0 + 0.5);
+    size_t row = (size_t) w * sizeof(uint32_t);
+    // Unmodified copies of the rows above, at and below the current one
+    uint32_t* ring = malloc(row * 3);
+    if (!ring)
+        return;
+    memcpy(ring, px, row);
+    memcpy(ring + w, px + w, row);
+
+    for (int y = 1; y < h - 1; y++) {
+        const uint32_t* up = ring + (size_t) ((y - 1) % 3) * w;
+        const uint32_t* mid = ring + (size_t) (y % 3) * w;
+        uint32_t* down = ring + (size_t) ((y + 1) % 3) * w;
+        memcpy(down, px + (size_t) (y + 1) * w, row);
+        uint32_t* out = px + (size_t) y * w;
+        for (int x = 1; x < w - 1; x++) {
+            uint32_t v = mid[x] & 0xff000000;
+            for (int c = 0; c < 24; c += 8) {
+                int sum = 0;
+                for (int dx = -1; dx <= 1; dx++)
+                    sum += (int) ((up[x + dx] >> c) & 0xff) + (int) ((mid[x + dx] >> c) & 0xff)
+                        + (int) ((down[x + dx] >> c) & 0xff);
+                int p = (int) ((mid[x] >> c) & 0xff);
+                int r = p + (((p * 9 - sum) * gain) / 9 >> 8);
+                r = r < 0 ? 0 : (r > 255 ? 255 : r);
+                v |= (uint32_t) r << c;
+            }
+            out[x] = v;
+        }
+    }
+    free(ring);
+}
+
+// Box-filter each row of src (w x h) into column-major dst (h x w), scaling
+// the window sums by mul / 65536. Clamped edges; window sums stay below 2^15.
+static void _box_rows(const uint32_t* src, int w, int h, uint32_t* dst, int radius, uint16_t mul)
+{
+    for (int y = 0; y < h; y++) {
+        const uint32_t* row = src + (size_t) y * w;
+        uint32_t* out = dst + y;
+#if defined(__SSE2__)
+        __m128i zero = _mm_setzero_si128();
+        __m128i m = _mm_set1_epi16((short) mul);
+#define BOX_LOAD(p) _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) (p)), zero)
+        __m128i sum = _mm_mullo_epi16(BOX_LOAD(row[0]), _mm_set1_epi16((short) (radius + 1)));
+        for (int i = 1; i <= radius; i++)
+            sum = _mm_add_epi16(sum, BOX_LOAD(row[i < w ? i : w - 1]));
+        for (int x = 0; x < w; x++) {
+            __m128i v = _mm_mulhi_epu16(sum, m);
+            out[(size_t) x * h] = (uint32_t) _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+            int add = x + radius + 1 < w ? x + radius + 1 : w - 1;
+            int sub = x - radius > 0 ? x - radius : 0;
+            sum = _mm_sub_epi16(_mm_add_epi16(sum, BOX_LOAD(row[add])), BOX_LOAD(row[sub]));
+        }
+#undef BOX_LOAD
+#elif defined(__ARM_NEON)
+#define BOX_LOAD(p) vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(p))))
+        uint16x4_t sum = vmul_n_u16(BOX_LOAD(row[0]), (uint16_t) (radius + 1));
+        for (int i = 1; i <= radius; i++)
+            sum = vadd_u16(sum, BOX_LOAD(row[i < w ? i : w - 1]));
+        for (int x = 0; x < w; x++) {
+            uint16x4_t v = vshrn_n_u32(vmull_n_u16(sum, mul), 16);
+            uint8x8_t b = vmovn_u16(vcombine_u16(v, v));
+            out[(size_t) x * h] = vget_lane_u32(vreinterpret_u32_u8(b), 0);
+            int add = x + radius + 1 < w ? x + radius + 1 : w - 1;
+            int sub = x - radius > 0 ? x - radius : 0;
+            sum = vsub_u16(vadd_u16(sum, BOX_LOAD(row[add])), BOX_LOAD(row[sub]));
+        }
+#undef BOX_LOAD
+#else
+        uint32_t sum[4];
+        for (int c = 0; c < 4; c++) {
+            sum[c] = ((row[0] >> (c * 8)) & 0xff) * (uint32_t) (radius + 1);
+            for (int i = 1; i <= radius; i++)
+                sum[c] += (row[i < w ? i : w - 1] >> (c * 8)) & 0xff;
+        }
+        for (int x = 0; x < w; x++) {
+            uint32_t v = 0;
+            int add = x + radius + 1 < w ? x + radius + 1 : w - 1;
+            int sub = x - radius > 0 ? x - radius : 0;
+            for (int c = 0; c < 4; c++) {
+                v |= ((sum[c] * mul) >> 16) << (c * 8);
+                sum[c] += ((row[add] >> (c * 8)) & 0xff) - ((row[sub] >> (c * 8)) & 0xff);
+            }
+            out[(size_t) x * h] = v;
+        }
+#endif
+    }
+}
+
+Eina_Bool pixels_blur(uint32_t* px, int w, int h, int radius, double dim)
+{
+    if (!px || w <= 0 || h <= 0)
+        return EINA_TRUE;
+    if (radius < 1)
+        radius = 1;
+    if (radius > PIXELS_BLUR_RADIUS_MAX)
+        radius = PIXELS_BLUR_RADIUS_MAX;
+    if (dim < 0.0)
+        dim = 0.0;
+    if (dim > 1.0)
+        dim = 1.0;
+    uint32_t* tmp = malloc((size_t) w * h * sizeof(uint32_t));
+    if (!tmp)
+        return EINA_FALSE;
+
+    int span = 2 * radius + 1;
+    // Rounded up so flat areas keep their value through truncating multiplies
+    uint16_t mul = (uint16_t) ((65536 + span - 1) / span);
+    uint16_t last = (uint16_t) (mul * dim);
+    // Each pair of passes blurs both axes and transposes back
+    for (int pass = 0; pass < 3; pass++) {
+        _box_rows(px, w, h, tmp, radius, mul);
+        _box_rows(tmp, h, w, px, radius, pass == 2 ? last : mul);
+    }
+    free(tmp);
+    // Dimming scaled alpha along with the colour; the buffer stays opaque
+    for (size_t i = 0; i < (size_t) w * h; i++)
+        px[i] |= 0xff000000;
+    return EINA_TRUE;
+}
+
+void pixels_luma(const uint32_t* px, size_t n, uint8_t* out)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    // 77 R + 150 G + 29 B in 16-bit lanes, four pixels per step
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i kr = _mm_set1_epi32(77), kg = _mm_set1_epi32(150), kb = _mm_set1_epi32(29);
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*) (px + i));
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(p, 8), mask);
+        __m128i b = _mm_and_si128(p, mask);
+        // Products fit in 16 bits, so the low-half multiply is exact
+        __m128i y = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi16(r, kr), _mm_mullo_epi16(g, kg)),
+            _mm_mullo_epi16(b, kb));
+        y = _mm_srli_epi32(y, 8);
+        y = _mm_packs_epi32(y, y);
+        y = _mm_packus_epi16(y, y);
+        uint32_t four = (uint32_t) _mm_cvtsi128_si32(y);
+        memcpy(out + i, &four, 4);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t p = vld4_u8((const uint8_t*) (px + i)); // B, G, R, A planes
+        uint16x8_t y = vmull_u8(p.val[2], vdup_n_u8(77));
+        y = vmlal_u8(y, p.val[1], vdup_n_u8(150));
+        y = vmlal_u8(y, p.val[0], vdup_n_u8(29));
+        vst1_u8(out + i, vshrn_n_u16(y, 8));
+    }
+#endif
+    for (; i < n; i++) {
+        uint32_t p = px[i];
+        out[i] = (uint8_t) ((((p >> 16) & 0xff) * 77 + ((p >> 8) & 0xff) * 150 + (p & 0xff) * 29)
+            >> 8);
+    }
+}
+
+void pixels_edge_energy(const uint8_t* luma, int w, int h, uint8_t* out)
+{
+    if (!luma || !out || w <= 0 || h <= 0)
+        return;
+    for (int y = 0; y < h - 1; y++) {
+        const uint8_t* row = luma + (size_t) y * w;
+        const uint8_t* below = row + w;
+        uint8_t* o = out + (size_t) y * w;
+        int x = 0;
+#if defined(__SSE2__)
+        for (; x + 17 <= w; x += 16) {
+            __m128i c = _mm_loadu_si128((const __m128i*) (row + x));
+            __m128i r = _mm_loadu_si128((const __m128i*) (row + x + 1));
+            __m128i d = _mm_loadu_si128((const __m128i*) (below + x));
+            // |a - b| for unsigned bytes is (a -sat b) | (b -sat a)
+            __m128i dx = _mm_or_si128(_mm_subs_epu8(c, r), _mm_subs_epu8(r, c));
+            __m128i dy = _mm_or_si128(_mm_subs_epu8(c, d), _mm_subs_epu8(d, c));
+            _mm_storeu_si128((__m128i*) (o + x), _mm_adds_epu8(dx, dy));
+        }
+#elif defined(__ARM_NEON)
+        for (; x + 17 <= w; x += 16) {
+            uint8x16_t c = vld1q_u8(row + x);
+            uint8x16_t dx = vabdq_u8(c, vld1q_u8(row + x + 1));
+            uint8x16_t dy = vabdq_u8(c, vld1q_u8(below + x));
+            vst1q_u8(o + x, vqaddq_u8(dx, dy));
+        }
+#endif
+        for (; x < w - 1; x++) {
+            int e = abs(row[x] - row[x + 1]) + abs(row[x] - below[x]);
+            o[x] = (uint8_t) (e > 255 ? 255 : e);
+        }
+        o[w - 1] = 0;
+    }
+    memset(out + (size_t) (h - 1) * w, 0, (size_t) w);
+}
+
+void pixels_histogram(const uint8_t* v, size_t n, uint32_t hist[256])
+{
+    uint32_t sub[4][256];
+    memset(sub, 0, sizeof(sub));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        sub[0][v[i]]++;
+        sub[1][v[i + 1]]++;
+        sub[2][v[i + 2]]++;
+        sub[3][v[i + 3]]++;
+    }
+    for (; i < n; i++)
+        sub[0][v[i]]++;
+    for (int b = 0; b < 256; b++)
+        hist[b] += sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+}
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+// 256-entry lookup as four chained 64-byte table lookups. Indices outside a
+// table leave the lane as it was, and the offsets wrap the lower ones out.
+static inline uint8x16_t _lut_lookup(const uint8x16x4_t t[4], uint8x16_t idx)
+{
+    uint8x16_t r = vqtbl4q_u8(t[0], idx);
+    r = vqtbx4q_u8(r, t[1], vsubq_u8(idx, vdupq_n_u8(64)));
+    r = vqtbx4q_u8(r, t[2], vsubq_u8(idx, vdupq_n_u8(128)));
+    return vqtbx4q_u8(r, t[3], vsubq_u8(idx, vdupq_n_u8(192)));
+}
+
+static void _lut_load(const uint8_t* table, uint8x16x4_t t[4])
+{
+    for (int i = 0; i < 4; i++) {
+        t[i].val[0] = vld1q_u8(table + 64 * i);
+        t[i].val[1] = vld1q_u8(table + 64 * i + 16);
+        t[i].val[2] = vld1q_u8(table + 64 * i + 32);
+        t[i].val[3] = vld1q_u8(table + 64 * i + 48);
+    }
+}
+#endif
+
+void pixels_lut_apply(uint32_t* px, size_t n, const Pixels_Lut* lut)
+{
+    size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16x4_t tr[4], tg[4], tb[4];
+    _lut_load(lut->r, tr);
+    _lut_load(lut->g, tg);
+    _lut_load(lut->b, tb);
+    for (; i + 16 <= n; i += 16) {
+        // Little-endian ARGB words are B, G, R, A in memory
+        uint8x16x4_t v = vld4q_u8((const uint8_t*) (px + i));
+        v.val[0] = _lut_lookup(tb, v.val[0]);
+        v.val[1] = _lut_lookup(tg, v.val[1]);
+        v.val[2] = _lut_lookup(tr, v.val[2]);
+        vst4q_u8((uint8_t*) (px + i), v);
+    }
+#endif
+    for (; i < n; i++) {
+        uint32_t p = px[i];
+        px[i] = (p & 0xff000000) | (uint32_t) lut->r[(p >> 16) & 0xff] << 16
+            | (uint32_t) lut->g[(p >> 8) & 0xff] << 8 | lut->b[p & 0xff];
+    }
+}
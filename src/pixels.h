@@ -0,0 +1,77 @@
+#ifndef PIXELS_H
+#define PIXELS_H
+
+#include <stdint.h>
+#include <Eina.h>
+
+// Pixel kernels for ARGB8888 buffers, run on decode workers (never per frame)
+
+// Side length of the square tiles used by the transposing kernels. Two 32x32
+// ARGB tiles (source + destination) fit comfortably in a 32 KB L1 cache.
+#define PIXELS_TILE 32
+
+// Apply an EXIF orientation (1-8) so the buffer becomes upright. Orientations
+// 1-4 are handled in place and return src; 5-8 swap width and height, return
+// a new buffer and free src. Returns NULL (src freed) on allocation failure.
+uint32_t* pixels_orient(uint32_t* src, int w, int h, int orientation, int* out_w, int* out_h);
+
+// Resampling filters for pixels_resample()
+typedef enum {
+    PIXELS_KERNEL_AREA,    // box-average on downscale, bilinear on upscale
+    PIXELS_KERNEL_LANCZOS, // Lanczos-3, widened by the downscale factor
+} Pixels_Kernel;
+
+// Kernel name for logs and config ("area", "lanczos"), and the reverse.
+// Unknown names return -1.
+const char* pixels_kernel_name(Pixels_Kernel kernel);
+int pixels_kernel_parse(const char* name);
+
+// Instruction set the resampler was built for ("SSE2", "NEON" or "scalar")
+const char* pixels_simd_name(void);
+
+// Resample an opaque ARGB buffer to dw x dh with a separable filter. Returns
+// a new buffer (src is untouched) or NULL on allocation failure.
+uint32_t* pixels_resample(
+    const uint32_t* src, int sw, int sh, int dw, int dh, Pixels_Kernel kernel);
+
+// As pixels_resample() for the sw x sh region at (sx, sy) of a buffer whose
+// rows are stride pixels apart
+uint32_t* pixels_resample_region(const uint32_t* src, int stride, int sx, int sy, int sw, int sh,
+    int dw, int dh, Pixels_Kernel kernel);
+
+// Largest radius pixels_blur() accepts (keeps box sums in 16-bit lanes)
+#define PIXELS_BLUR_RADIUS_MAX 63
+
+// Approximate Gaussian blur of an opaque buffer in place: three box passes of
+// the given radius (1..PIXELS_BLUR_RADIUS_MAX) per axis. The colour is scaled
+// by dim (0..1) on the way. Returns EINA_FALSE on allocation failure.
+Eina_Bool pixels_blur(uint32_t* px, int w, int h, int radius, double dim);
+
+// Rec. 601 luma (0-255) of n ARGB pixels into out
+void pixels_luma(const uint32_t* px, size_t n, uint8_t* out);
+
+// Edge energy of a w x h luma plane: saturated sum of the absolute
+// differences to the right and lower neighbours. The last row and column,
+// which have no neighbours, are zero.
+void pixels_edge_energy(const uint8_t* luma, int w, int h, uint8_t* out);
+
+// Add the n values to a 256-bin histogram. Four interleaved sub-histograms
+// keep runs of equal values from serializing on one counter.
+void pixels_histogram(const uint8_t* v, size_t n, uint32_t hist[256]);
+
+// Per-channel colour lookup table
+typedef struct {
+    uint8_t r[256];
+    uint8_t g[256];
+    uint8_t b[256];
+} Pixels_Lut;
+
+// Map the colour channels of n ARGB pixels through lut in place; alpha is
+// kept. AArch64 uses 64-byte NEON table lookups, other targets a scalar loop.
+void pixels_lut_apply(uint32_t* px, size_t n, const Pixels_Lut* lut);
+
+// Unsharp mask against a 3x3 box blur; amount 0..1 is the share of detail
+// added back. Border pixels are left as they are.
+void pixels_sharpen(uint32_t* px, int w, int h, double amount);
+
+#endif /* PIXELS_H */
@@ -0,0 +1,64 @@
+#include "poster.h"
+#include "media.h"
+
+// Where in the video the poster is taken, as a share of its duration
+#define POSTER_POSITION 0.10
+// Largest ffmpeg output read back
+#define POSTER_MAX_BYTES (32 * 1024 * 1024)
+
+static int ffmpeg_found = -1; // unknown until first asked
+
+Eina_Bool poster_is_supported(const char* path)
+{
+    if (!path || !is_video_file(path))
+        return EINA_FALSE;
+    if (ffmpeg_found < 0) {
+        ffmpeg_found = common_in_path("ffmpeg") && common_in_path("ffprobe");
+        if (!ffmpeg_found)
+            INF("ffmpeg/ffprobe not found: videos have no poster frames");
+    }
+    return ffmpeg_found;
+}
+
+// Duration of path in seconds, or 0 when unknown
+static double _duration(const char* path)
+{
+    char* const argv[] = { "ffprobe", "-v", "error", "-show_entries", "format=duration", "-of",
+        "default=noprint_wrappers=1:nokey=1", (char*) path, NULL };
+    unsigned char* out = NULL;
+    size_t size = 0;
+    if (!common_run_capture(argv, POSTER_MAX_BYTES, &out, &size))
+        return 0.0;
+    double seconds = strtod((const char*) out, NULL);
+    free(out);
+    return seconds > 0.0 ? seconds : 0.0;
+}
+
+Eina_Bool poster_extract(
+    const char* path, int target_w, int target_h, unsigned char** out_data, size_t* out_size)
+{
+    if (!path || !out_data || !out_size)
+        return EINA_FALSE;
+    char seek[32];
+    snprintf(seek, sizeof(seek), "%.3f", _duration(path) * POSTER_POSITION);
+    // Scaled by ffmpeg so a 4K frame is not encoded only to be shrunk again
+    char scale[96];
+    if (target_w > 0 && target_h > 0)
+        snprintf(scale, sizeof(scale), "scale=w=%d:h=%d:force_original_aspect_ratio=decrease",
+            target_w, target_h);
+    else
+        snprintf(scale, sizeof(scale), "null");
+    // Seeking before -i jumps to the nearest keyframe instead of decoding up to it
+    char* const argv[] = { "ffmpeg", "-v", "error", "-nostdin", "-ss", seek, "-i", (char*) path,
+        "-an", "-sn", "-frames:v", "1", "-vf", scale, "-q:v", "3", "-f", "image2pipe", "-c:v",
+        "mjpeg", "-", NULL };
+
+    double start = ecore_time_get();
+    if (!common_run_capture(argv, POSTER_MAX_BYTES, out_data, out_size)) {
+        WRN("No poster frame for %s", path);
+        return EINA_FALSE;
+    }
+    DBG("Poster frame for %s at %ss: %zu bytes in %.1f ms", path, seek, *out_size,
+        (ecore_time_get() - start) * 1000.0);
+    return EINA_TRUE;
+}
@@ -0,0 +1,20 @@
+#ifndef POSTER_H
+#define POSTER_H
+
+#include "common.h"
+
+// Video poster frames. A frame about 10% into the video is extracted with a
+// local ffmpeg (ffprobe for the duration) as a JPEG, so posters go through the
+// same background decode and cache as slides and can be shown while the video
+// pipeline is still starting.
+
+// Whether path is a video and ffmpeg was found on PATH
+Eina_Bool poster_is_supported(const char* path);
+
+// Extract a poster frame of path fitted inside target_w x target_h (0x0 for
+// full size). Blocks on ffmpeg, so run it on a worker. On success *out_data
+// is malloc'd JPEG data and must be freed by the caller.
+Eina_Bool poster_extract(
+    const char* path, int target_w, int target_h, unsigned char** out_data, size_t* out_size);
+
+#endif /* POSTER_H */
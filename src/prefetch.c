@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <Ecore.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+#include "prefetch.h"
+#include "media.h"
+
+// Most of a file that is warmed (and checked at use); the start of a video
+// is enough for playback to begin without stalling
+#define PREFETCH_FILE_SPAN (PREFETCH_WINDOW_BYTES / PREFETCH_AHEAD)
+// Read granularity; cancellation is checked between chunks
+#define PREFETCH_CHUNK (1024 * 1024)
+#ifdef HAVE_LIBURING
+// Reads kept in flight per batch
+#define PREFETCH_QUEUE_DEPTH 8
+#endif
+
+typedef struct {
+    Eina_List* paths; // char*, owned
+    unsigned long long bytes_read;
+} Prefetch_Job;
+
+static Ecore_Thread* current_thread = NULL;
+static Prefetch_Job* current_job = NULL;
+static Prefetch_Stats stats;
+
+static void _job_free(Prefetch_Job* job)
+{
+    char* path;
+    EINA_LIST_FREE(job->paths, path)
+    {
+        free(path);
+    }
+    free(job);
+}
+
+// Whether the first len bytes of fd are all in the page cache
+static Eina_Bool _is_resident(int fd, off_t len)
+{
+    if (len <= 0)
+        return EINA_TRUE;
+    long page = sysconf(_SC_PAGESIZE);
+    size_t pages = ((size_t) len + page - 1) / page;
+    void* map = mmap(NULL, (size_t) len, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        return EINA_FALSE;
+    Eina_Bool resident = EINA_FALSE;
+    unsigned char* vec = malloc(pages);
+    if (vec && mincore(map, (size_t) len, vec) == 0) {
+        resident = EINA_TRUE;
+        for (size_t i = 0; i < pages; i++) {
+            if (!(vec[i] & 1)) {
+                resident = EINA_FALSE;
+                break;
+            }
+        }
+    }
+    free(vec);
+    munmap(map, (size_t) len);
+    return resident;
+}
+
+#ifdef HAVE_LIBURING
+// Batched reads into a throwaway buffer; the page cache keeps the data
+static unsigned long long _warm_uring(
+    struct io_uring* ring, unsigned char* scratch, int fd, off_t len, Ecore_Thread* thread)
+{
+    unsigned long long done = 0;
+    off_t next = 0;
+    unsigned int inflight = 0;
+
+    for (;;) {
+        while (inflight < PREFETCH_QUEUE_DEPTH && next < len && !ecore_thread_check(thread)) {
+            struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+            if (!sqe)
+                break;
+            unsigned int n = (len - next) < PREFETCH_CHUNK ? (unsigned int) (len - next)
+                                                           : PREFETCH_CHUNK;
+            // Every read shares one buffer: its contents are never looked at
+            io_uring_prep_read(sqe, fd, scratch, n, next);
+            next += n;
+            inflight++;
+        }
+        if (inflight == 0)
+            break;
+        io_uring_submit(ring);
+
+        struct io_uring_cqe* cqe;
+        if (io_uring_wait_cqe(ring, &cqe) < 0)
+            break;
+        if (cqe->res > 0)
+            done += (unsigned long long) cqe->res;
+        else if (cqe->res < 0)
+            next = len; // stop submitting, drain what is in flight
+        io_uring_cqe_seen(ring, cqe);
+        inflight--;
+    }
+    return done;
+}
+#endif
+
+// Kernel readahead in chunks so a navigation jump can stop the batch early
+static unsigned long long _warm_readahead(int fd, off_t len, Ecore_Thread* thread)
+{
+    unsigned long long done = 0;
+    for (off_t off = 0; off < len && !ecore_thread_check(thread); off += PREFETCH_CHUNK) {
+        size_t n = (len - off) < PREFETCH_CHUNK ? (size_t) (len - off) : PREFETCH_CHUNK;
+#ifdef __linux__
+        if (readahead(fd, off, n) != 0)
+            break;
+#else
+        if (posix_fadvise(fd, off, (off_t) n, POSIX_FADV_WILLNEED) != 0)
+            break;
+#endif
+        done += n;
+    }
+    return done;
+}
+
+static void _prefetch_run(void* data, Ecore_Thread* thread)
+{
+    Prefetch_Job* job = data;
+    long long window = PREFETCH_WINDOW_BYTES;
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+    unsigned char* scratch = malloc(PREFETCH_CHUNK);
+    Eina_Bool use_uring = scratch && io_uring_queue_init(PREFETCH_QUEUE_DEPTH, &ring, 0) == 0;
+#endif
+
+    Eina_List* l;
+    const char* path;
+    char file[PATH_MAX];
+    EINA_LIST_FOREACH(job->paths, l, path)
+    {
+        if (window <= 0 || ecore_thread_check(thread))
+            break;
+        // PDF pages and pack frames are warmed through their file
+        int fd = open(media_source_file(path, file, sizeof(file)), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            close(fd);
+            continue;
+        }
+        off_t len = st.st_size;
+        if (len > PREFETCH_FILE_SPAN)
+            len = PREFETCH_FILE_SPAN;
+        if (len > window)
+            len = (off_t) window;
+        window -= len;
+
+        // Already cached files cost a mincore() call, not device reads
+        if (!_is_resident(fd, len)) {
+#ifdef HAVE_LIBURING
+            if (use_uring)
+                job->bytes_read += _warm_uring(&ring, scratch, fd, len, thread);
+            else
+#endif
+                job->bytes_read += _warm_readahead(fd, len, thread);
+        }
+        close(fd);
+    }
+
+#ifdef HAVE_LIBURING
+    if (use_uring)
+        io_uring_queue_exit(&ring);
+    free(scratch);
+#endif
+}
+
+static void _prefetch_end(void* data, Ecore_Thread* thread)
+{
+    Prefetch_Job* job = data;
+    stats.bytes_read += job->bytes_read;
+    DBG("Prefetch batch done: %llu bytes read ahead", job->bytes_read);
+    if (current_thread == thread) {
+        current_thread = NULL;
+        current_job = NULL;
+    }
+    _job_free(job);
+}
+
+static void _prefetch_cancel(void* data, Ecore_Thread* thread)
+{
+    Prefetch_Job* job = data;
+    stats.bytes_read += job->bytes_read;
+    if (current_thread == thread) {
+        current_thread = NULL;
+        current_job = NULL;
+    }
+    _job_free(job);
+}
+
+void prefetch_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void prefetch_shutdown(void)
+{
+    if (current_thread) {
+        ecore_thread_cancel(current_thread);
+        current_thread = NULL;
+        current_job = NULL;
+    }
+    INF("Prefetch stats: %u hits, %u misses, %u batches (%u cancelled), %llu bytes read ahead",
+        stats.hits, stats.misses, stats.batches, stats.cancelled, stats.bytes_read);
+}
+
+static Eina_Bool _same_paths(const Eina_List* a, const Eina_List* b)
+{
+    while (a && b) {
+        if (strcmp(eina_list_data_get(a), eina_list_data_get(b)) != 0)
+            return EINA_FALSE;
+        a = eina_list_next(a);
+        b = eina_list_next(b);
+    }
+    return !a && !b;
+}
+
+void prefetch_schedule(const Eina_List* paths)
+{
+    if (!paths)
+        return;
+    // Repeated requests for the batch in flight are free
+    if (current_job && _same_paths(current_job->paths, paths))
+        return;
+
+    if (current_thread) {
+        ecore_thread_cancel(current_thread);
+        current_thread = NULL;
+        current_job = NULL;
+        stats.cancelled++;
+    }
+
+    Prefetch_Job* job = calloc(1, sizeof(Prefetch_Job));
+    if (!job)
+        return;
+    const Eina_List* l;
+    const char* path;
+    EINA_LIST_FOREACH(paths, l, path)
+    {
+        job->paths = eina_list_append(job->paths, strdup(path));
+    }
+
+    stats.batches++;
+    current_job = job;
+    current_thread = ecore_thread_run(_prefetch_run, _prefetch_end, _prefetch_cancel, job);
+    if (!current_thread)
+        current_job = NULL; // cancel callback already freed the job
+}
+
+void prefetch_note_use(const char* path)
+{
+    if (!path)
+        return;
+    char file[PATH_MAX];
+    int fd = open(media_source_file(path, file, sizeof(file)), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        off_t len = st.st_size < PREFETCH_FILE_SPAN ? st.st_size : PREFETCH_FILE_SPAN;
+        if (_is_resident(fd, len))
+            stats.hits++;
+        else
+            stats.misses++;
+    }
+    close(fd);
+}
+
+void prefetch_stats_get(Prefetch_Stats* out)
+{
+    if (out)
+        *out = stats;
+}
@@ -0,0 +1,35 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include "common.h"
+
+// I/O prefetch stage: warms the kernel page cache for upcoming media files on
+// a worker thread before any decode starts, so slow SD cards and USB disks
+// are read while the current slide is on screen.
+
+// Number of upcoming catalog entries to warm
+#define PREFETCH_AHEAD 4
+// Upper bound on bytes read ahead per batch
+#define PREFETCH_WINDOW_BYTES (64LL * 1024 * 1024)
+
+typedef struct {
+    unsigned int hits;             // shown files that were already resident
+    unsigned int misses;           // shown files that still needed device reads
+    unsigned int batches;          // batches started
+    unsigned int cancelled;        // batches dropped because navigation jumped
+    unsigned long long bytes_read; // bytes the prefetcher asked the device for
+} Prefetch_Stats;
+
+void prefetch_init(void);
+void prefetch_shutdown(void);
+
+// Warm the given paths (char*, in display order) within the byte window. A
+// different list cancels the batch in flight; the same list is a no-op.
+void prefetch_schedule(const Eina_List* paths);
+
+// Record whether path is resident now that it is about to be shown
+void prefetch_note_use(const char* path);
+
+void prefetch_stats_get(Prefetch_Stats* out);
+
+#endif /* PREFETCH_H */
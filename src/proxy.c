@@ -0,0 +1,447 @@
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include "proxy.h"
+
+// Proxy frame height (sources already this small are not worth one)
+#define PROXY_HEIGHT 720
+// Playback is judged on at least this many frame intervals
+#define PROXY_MIN_FRAMES 48
+#define PROXY_MAX_FRAMES 1024
+// Share of frames dropped that makes a source need a proxy
+#define PROXY_DROP_RATIO 0.05
+// Transcoders run niced to this
+#define PROXY_NICE 19
+// Longer intervals are pauses, not drops
+#define PROXY_PAUSE 1.0
+// Largest ffprobe output read back
+#define PROXY_PROBE_MAX_BYTES 4096
+
+typedef struct {
+    Evas_Object* obj;
+    char* path;
+    double last;
+    double intervals[PROXY_MAX_FRAMES];
+    int count;
+} Proxy_Watch;
+
+typedef struct {
+    pid_t pid; // 0 when no transcode runs
+    char* source;
+    char* part; // output while transcoding
+    char* done; // renamed to on success
+} Proxy_Job;
+
+static int cache_mb = 0;
+static char* cache_dir = NULL;
+static Proxy_Watch watch;
+static Proxy_Job job;
+static Eina_List* queue = NULL;     // source paths waiting for a transcode
+static Eina_Hash* attempted = NULL; // cache keys queued or transcoded this run
+static Ecore_Event_Handler* exe_del_handler = NULL;
+// path -> double* nominal frame rate (0 when unknown), main loop only
+static Eina_Hash* rates = NULL;
+static Eina_List* rate_probes = NULL; // in-flight Ecore_Thread*
+
+// Nominal frame rate probe of one video, run on a worker
+typedef struct {
+    char* path;
+    double fps;
+} Rate_Probe;
+
+// $XDG_CACHE_HOME/eslide/proxies (or ~/.cache/...), created if missing
+static char* _cache_dir_get(void)
+{
+    const char* base = getenv("XDG_CACHE_HOME");
+    char dir[PATH_MAX];
+    if (base && *base)
+        snprintf(dir, sizeof(dir), "%s/eslide/proxies", base);
+    else if (getenv("HOME") && *getenv("HOME"))
+        snprintf(dir, sizeof(dir), "%s/.cache/eslide/proxies", getenv("HOME"));
+    else
+        return NULL;
+    for (char* p = dir + 1; *p; p++) {
+        if (*p != '/')
+            continue;
+        *p = '\0';
+        mkdir(dir, 0700);
+        *p = '/';
+    }
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        WRN("Cannot create proxy cache %s: %s", dir, strerror(errno));
+        return NULL;
+    }
+    return strdup(dir);
+}
+
+// Cache key of the file at path (inode, size, mtime); EINA_FALSE if missing
+static Eina_Bool _key(const char* path, char* key, size_t size)
+{
+    struct stat st;
+    if (!path || stat(path, &st) != 0)
+        return EINA_FALSE;
+    snprintf(key, size, "%llx-%llx-%llx", (unsigned long long) st.st_ino,
+        (unsigned long long) st.st_size, (unsigned long long) st.st_mtime);
+    return EINA_TRUE;
+}
+
+static char* _proxy_path(const char* key, const char* suffix)
+{
+    char file[PATH_MAX];
+    snprintf(file, sizeof(file), "%s/%s%s", cache_dir, key, suffix);
+    return strdup(file);
+}
+
+typedef struct {
+    char* path;
+    off_t size;
+    time_t used;
+} Proxy_Entry;
+
+static int _entry_cmp(const void* a, const void* b)
+{
+    const Proxy_Entry* ea = a;
+    const Proxy_Entry* eb = b;
+    return ea->used < eb->used ? -1 : ea->used > eb->used;
+}
+
+// Remove least recently played proxies until the cache fits its budget.
+// Leftover partial files from an interrupted run are removed too.
+static void _cache_trim(void)
+{
+    if (!cache_dir)
+        return;
+    DIR* d = opendir(cache_dir);
+    if (!d)
+        return;
+    Proxy_Entry* entries = NULL;
+    int count = 0, cap = 0;
+    long long total = 0;
+    struct dirent* de;
+    while ((de = readdir(d))) {
+        if (de->d_name[0] == '.')
+            continue;
+        char file[PATH_MAX];
+        snprintf(file, sizeof(file), "%s/%s", cache_dir, de->d_name);
+        struct stat st;
+        if (stat(file, &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        if (eina_str_has_extension(de->d_name, ".part")) {
+            if (!job.part || strcmp(job.part, file) != 0)
+                unlink(file);
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? cap * 2 : 64;
+            Proxy_Entry* grown = realloc(entries, cap * sizeof(Proxy_Entry));
+            if (!grown)
+                break;
+            entries = grown;
+        }
+        entries[count].path = strdup(file);
+        entries[count].size = st.st_size;
+        entries[count].used = st.st_mtime;
+        count++;
+        total += st.st_size;
+    }
+    closedir(d);
+
+    qsort(entries, count, sizeof(Proxy_Entry), _entry_cmp);
+    long long budget = (long long) cache_mb * 1024 * 1024;
+    for (int i = 0; i < count; i++) {
+        if (total > budget && entries[i].path && unlink(entries[i].path) == 0) {
+            total -= entries[i].size;
+            DBG("Evicted proxy %s", entries[i].path);
+        }
+        free(entries[i].path);
+    }
+    free(entries);
+}
+
+static void _job_clear(void)
+{
+    free(job.source);
+    free(job.part);
+    free(job.done);
+    memset(&job, 0, sizeof(job));
+}
+
+// Start the next queued transcode when none is running
+static void _job_next(void)
+{
+    while (!job.pid && queue && cache_mb > 0) {
+        char* source = eina_list_data_get(queue);
+        queue = eina_list_remove_list(queue, queue);
+        char key[64];
+        if (!_key(source, key, sizeof(key))) {
+            free(source);
+            continue;
+        }
+        job.source = source;
+        job.part = _proxy_path(key, ".mp4.part");
+        job.done = _proxy_path(key, ".mp4");
+
+        // Streams are mapped so subtitles and data tracks cannot fail the job
+        char scale[64];
+        snprintf(scale, sizeof(scale), "scale=-2:min(%d\\,ih)", PROXY_HEIGHT);
+        char* const argv[] = { "ffmpeg", "-v", "error", "-nostdin", "-y", "-i", source, "-map",
+            "0:v:0", "-map", "0:a:0?", "-vf", scale, "-c:v", "libx264", "-preset", "veryfast",
+            "-profile:v", "main", "-pix_fmt", "yuv420p", "-crf", "23", "-c:a", "aac", "-b:a",
+            "128k", "-movflags", "+faststart", "-f", "mp4", job.part, NULL };
+        pid_t pid = common_spawn(argv, PROXY_NICE, NULL);
+        if (pid < 0) {
+            if (errno == ENOENT) {
+                WRN("ffmpeg not found: playback proxies disabled");
+                cache_mb = 0;
+            } else {
+                WRN("Could not start ffmpeg for %s: %s", source, strerror(errno));
+            }
+            _job_clear();
+            continue;
+        }
+        job.pid = pid;
+        INF("Transcoding playback proxy for %s", source);
+    }
+}
+
+static Eina_Bool _on_exe_del(void* data EINA_UNUSED, int type EINA_UNUSED, void* event)
+{
+    Ecore_Exe_Event_Del* ev = event;
+    if (!job.pid || ev->pid != job.pid)
+        return ECORE_CALLBACK_PASS_ON;
+
+    if (ev->exited && ev->exit_code == 0 && rename(job.part, job.done) == 0) {
+        INF("Playback proxy ready for %s", job.source);
+        _cache_trim();
+    } else {
+        unlink(job.part);
+        WRN("Proxy transcode failed for %s", job.source);
+    }
+    _job_clear();
+    _job_next();
+    return ECORE_CALLBACK_PASS_ON;
+}
+
+static void _queue(const char* path)
+{
+    char key[64];
+    if (cache_mb <= 0 || !cache_dir || !_key(path, key, sizeof(key)))
+        return;
+    if (!attempted)
+        attempted = eina_hash_string_superfast_new(NULL);
+    // One attempt per file version and run, whatever the outcome
+    if (eina_hash_find(attempted, key))
+        return;
+    eina_hash_add(attempted, key, (void*) 1);
+    queue = eina_list_append(queue, strdup(path));
+    if (!exe_del_handler)
+        exe_del_handler = ecore_event_handler_add(ECORE_EXE_EVENT_DEL, _on_exe_del, NULL);
+    _job_next();
+}
+
+void proxy_set_cache_size(int megabytes)
+{
+    cache_mb = megabytes > 0 ? megabytes : 0;
+    if (cache_mb > 0 && !cache_dir)
+        cache_dir = _cache_dir_get();
+    if (cache_mb == 0 && job.pid) {
+        // Reaped by the main loop; the exit event no longer matches a job
+        kill(job.pid, SIGTERM);
+        unlink(job.part);
+        _job_clear();
+    }
+    if (cache_dir && cache_mb > 0)
+        _cache_trim();
+}
+
+char* proxy_resolve(const char* path)
+{
+    char key[64];
+    if (!path)
+        return NULL;
+    if (cache_mb <= 0 || !cache_dir || !_key(path, key, sizeof(key)))
+        return strdup(path);
+    char* proxy = _proxy_path(key, ".mp4");
+    if (!proxy || access(proxy, R_OK) != 0) {
+        free(proxy);
+        return strdup(path);
+    }
+    // The cache is trimmed by last use
+    utime(proxy, NULL);
+    DBG("Playing proxy %s for %s", proxy, path);
+    return proxy;
+}
+
+// Frame rate the stream is meant to play at ("num/den" from ffprobe)
+static void _rate_probe_run(void* data, Ecore_Thread* thread EINA_UNUSED)
+{
+    Rate_Probe* probe = data;
+    char* const argv[] = { "ffprobe", "-v", "error", "-select_streams", "v:0", "-show_entries",
+        "stream=avg_frame_rate,r_frame_rate", "-of", "default=noprint_wrappers=1:nokey=1",
+        probe->path, NULL };
+    unsigned char* out = NULL;
+    size_t size = 0;
+    if (!common_run_capture(argv, PROXY_PROBE_MAX_BYTES, &out, &size))
+        return;
+    // The average rate first; r_frame_rate when it is unknown (0/0)
+    const char* line = (const char*) out;
+    while (line && *line && probe->fps <= 0.0) {
+        double num = 0.0, den = 0.0;
+        if (sscanf(line, "%lf/%lf", &num, &den) == 2 && num > 0.0 && den > 0.0)
+            probe->fps = num / den;
+        line = strchr(line, '\n');
+        if (line)
+            line++;
+    }
+    free(out);
+}
+
+static void _rate_probe_end(void* data, Ecore_Thread* thread)
+{
+    Rate_Probe* probe = data;
+    rate_probes = eina_list_remove(rate_probes, thread);
+    double* fps = rates ? eina_hash_find(rates, probe->path) : NULL;
+    if (fps) {
+        *fps = probe->fps;
+        DBG("Video %s: nominal %.3f fps", probe->path, probe->fps);
+    }
+    free(probe->path);
+    free(probe);
+}
+
+static void _rate_probe_cancel(void* data, Ecore_Thread* thread)
+{
+    Rate_Probe* probe = data;
+    rate_probes = eina_list_remove(rate_probes, thread);
+    // Forget the failed entry so a later play probes again
+    if (rates)
+        eina_hash_del_by_key(rates, probe->path);
+    free(probe->path);
+    free(probe);
+}
+
+// Look up the nominal frame rate of path in the background, once per run
+static void _rate_probe(const char* path)
+{
+    if (!rates)
+        rates = eina_hash_string_superfast_new(free);
+    if (eina_hash_find(rates, path))
+        return;
+    double* fps = calloc(1, sizeof(double));
+    Rate_Probe* probe = calloc(1, sizeof(Rate_Probe));
+    if (!fps || !probe) {
+        free(fps);
+        free(probe);
+        return;
+    }
+    eina_hash_add(rates, path, fps);
+    probe->path = strdup(path);
+    Ecore_Thread* thread
+        = ecore_thread_run(_rate_probe_run, _rate_probe_end, _rate_probe_cancel, probe);
+    if (thread)
+        rate_probes = eina_list_append(rate_probes, thread);
+}
+
+// Estimate dropped frames from gaps in the decode cadence against the
+// stream's nominal rate: an interval of n frame durations means n - 1 frames
+// never arrived. A decoder that keeps a steady but slow pace drops as much
+// as one that stalls now and then. Without a rate there is nothing to judge.
+static void _judge(void)
+{
+    if (watch.count < PROXY_MIN_FRAMES)
+        return;
+    double* fps = rates ? eina_hash_find(rates, watch.path) : NULL;
+    if (!fps || *fps <= 0.0) {
+        DBG("Video %s: nominal frame rate unknown, not judged", watch.path);
+        return;
+    }
+    double period = 1.0 / *fps;
+    int dropped = 0, frames = 0;
+    for (int i = 0; i < watch.count; i++) {
+        if (watch.intervals[i] > PROXY_PAUSE)
+            continue;
+        frames++;
+        int missing = (int) lround(watch.intervals[i] / period) - 1;
+        if (missing > 0)
+            dropped += missing;
+    }
+    if (frames < PROXY_MIN_FRAMES)
+        return;
+    double ratio = (double) dropped / (frames + dropped);
+    DBG("Video %s: %d frames, ~%d dropped (%.1f%%)", watch.path, frames, dropped,
+        ratio * 100.0);
+    if (ratio <= PROXY_DROP_RATIO)
+        return;
+    char* playing = proxy_resolve(watch.path);
+    // Already played from a proxy: nothing lighter to offer
+    if (playing && strcmp(playing, watch.path) == 0) {
+        INF("Video %s dropped %.0f%% of frames; queueing a proxy", watch.path, ratio * 100.0);
+        _queue(watch.path);
+    }
+    free(playing);
+}
+
+static void _on_frame_decode(
+    void* data EINA_UNUSED, Evas_Object* obj EINA_UNUSED, void* event_info EINA_UNUSED)
+{
+    double now = ecore_time_get();
+    if (watch.last > 0.0 && watch.count < PROXY_MAX_FRAMES)
+        watch.intervals[watch.count++] = now - watch.last;
+    watch.last = now;
+}
+
+void proxy_watch(Evas_Object* emotion, const char* path)
+{
+    if (watch.obj) {
+        evas_object_smart_callback_del(watch.obj, "frame_decode", _on_frame_decode);
+        _judge();
+        free(watch.path);
+        memset(&watch, 0, sizeof(watch));
+    }
+    if (!emotion || !path || cache_mb <= 0)
+        return;
+    watch.obj = emotion;
+    watch.path = strdup(path);
+    _rate_probe(path);
+    evas_object_smart_callback_add(emotion, "frame_decode", _on_frame_decode, NULL);
+}
+
+void proxy_shutdown(void)
+{
+    if (watch.obj) {
+        evas_object_smart_callback_del(watch.obj, "frame_decode", _on_frame_decode);
+        free(watch.path);
+        memset(&watch, 0, sizeof(watch));
+    }
+    proxy_set_cache_size(0);
+    // Cancelled probes finish on their own and find no table to update
+    Ecore_Thread* thread;
+    EINA_LIST_FREE(rate_probes, thread)
+    {
+        ecore_thread_cancel(thread);
+    }
+    char* source;
+    EINA_LIST_FREE(queue, source)
+    {
+        free(source);
+    }
+    if (exe_del_handler) {
+        ecore_event_handler_del(exe_del_handler);
+        exe_del_handler = NULL;
+    }
+    if (attempted) {
+        eina_hash_free(attempted);
+        attempted = NULL;
+    }
+    if (rates) {
+        eina_hash_free(rates);
+        rates = NULL;
+    }
+    free(cache_dir);
+    cache_dir = NULL;
+}
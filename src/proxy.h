@@ -0,0 +1,27 @@
+#ifndef PROXY_H
+#define PROXY_H
+
+#include "common.h"
+
+// Playback proxies for videos too heavy to decode smoothly. Dropped frames
+// are measured while a video plays, against its nominal frame rate (probed
+// with ffprobe); a source that drops too many is queued for transcoding to
+// 720p H.264 by a local ffmpeg, run at idle priority one file at a time.
+// Proxies live in a size-bounded cache under $XDG_CACHE_HOME/eslide/proxies,
+// keyed by the source's inode, size and mtime, and are played instead of
+// their source from then on.
+
+// Enable proxies with a cache of at most megabytes (0 turns them off, and
+// stops any transcode in progress). Trims the cache to the new size.
+void proxy_set_cache_size(int megabytes);
+void proxy_shutdown(void);
+
+// File to play for path: its proxy when one is cached, otherwise path itself.
+// The result is malloc'd.
+char* proxy_resolve(const char* path);
+
+// Measure dropped frames of emotion while it plays path, replacing any video
+// measured before; NULL stops measuring. Judged when measuring stops.
+void proxy_watch(Evas_Object* emotion, const char* path);
+
+#endif /* PROXY_H */
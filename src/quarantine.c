@@ -0,0 +1,329 @@
+#include <limits.h>
+#include <sys/stat.h>
+#include <Ecore.h>
+#include <Eet.h>
+#include "quarantine.h"
+#include "app_config.h"
+#include "decode.h"
+#include "media.h"
+
+// Timeouts needed before a file is skipped
+#define QUARANTINE_TIMEOUT_STRIKES 3
+// Changes are written out at most this often (seconds)
+#define QUARANTINE_SAVE_DELAY 5.0
+// Longest wait for a cancelled re-probe to finish at shutdown (seconds)
+#define QUARANTINE_PROBE_WAIT 2.0
+
+typedef struct {
+    const char* path; // stringshare
+    unsigned long long inode;
+    long long size;
+    long long mtime;
+    int reason;
+    int strikes;
+    Eina_Bool probing; // not persisted
+} Quarantine_Entry;
+
+// On-disk container
+typedef struct {
+    Eina_List* entries;
+} Quarantine_File;
+
+// Background re-probe of a quarantined file that changed on disk
+typedef struct {
+    char* path;
+    struct stat st;
+    Eina_Bool ok;
+} Quarantine_Probe;
+
+static Eina_Hash* entries = NULL; // path -> Quarantine_Entry*
+static Eina_List* probes = NULL;  // in-flight Ecore_Thread*
+static char* cache_path = NULL;
+static Ecore_Timer* save_timer = NULL;
+static Eet_Data_Descriptor* _entry_edd = NULL;
+static Eet_Data_Descriptor* _file_edd = NULL;
+
+static void _entry_free(void* data)
+{
+    Quarantine_Entry* e = data;
+    if (!e)
+        return;
+    eina_stringshare_del(e->path);
+    free(e);
+}
+
+static void _edd_setup(void)
+{
+    if (_file_edd)
+        return;
+    Eet_Data_Descriptor_Class eddc;
+    EET_EINA_STREAM_DATA_DESCRIPTOR_CLASS_SET(&eddc, Quarantine_Entry);
+    _entry_edd = eet_data_descriptor_stream_new(&eddc);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_entry_edd, Quarantine_Entry, "path", path, EET_T_STRING);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_entry_edd, Quarantine_Entry, "inode", inode, EET_T_ULONG_LONG);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_entry_edd, Quarantine_Entry, "size", size, EET_T_LONG_LONG);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_entry_edd, Quarantine_Entry, "mtime", mtime, EET_T_LONG_LONG);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_entry_edd, Quarantine_Entry, "reason", reason, EET_T_INT);
+    EET_DATA_DESCRIPTOR_ADD_BASIC(_entry_edd, Quarantine_Entry, "strikes", strikes, EET_T_INT);
+
+    EET_EINA_STREAM_DATA_DESCRIPTOR_CLASS_SET(&eddc, Quarantine_File);
+    _file_edd = eet_data_descriptor_stream_new(&eddc);
+    EET_DATA_DESCRIPTOR_ADD_LIST(_file_edd, Quarantine_File, "entries", entries, _entry_edd);
+}
+
+static Eina_Bool _entry_matches(const Quarantine_Entry* e, const struct stat* st)
+{
+    return e->inode == (unsigned long long) st->st_ino && e->size == (long long) st->st_size
+        && e->mtime == (long long) st->st_mtime;
+}
+
+static void _entry_key_set(Quarantine_Entry* e, const struct stat* st)
+{
+    e->inode = (unsigned long long) st->st_ino;
+    e->size = (long long) st->st_size;
+    e->mtime = (long long) st->st_mtime;
+}
+
+static Eina_Bool _entry_active(const Quarantine_Entry* e)
+{
+    return e->reason != QUARANTINE_TIMEOUT || e->strikes >= QUARANTINE_TIMEOUT_STRIKES;
+}
+
+static Eina_Bool _collect_entry(
+    const Eina_Hash* hash EINA_UNUSED, const void* key EINA_UNUSED, void* data, void* fdata)
+{
+    Eina_List** list = fdata;
+    *list = eina_list_append(*list, data);
+    return EINA_TRUE;
+}
+
+static void _save(void)
+{
+    if (!cache_path || !entries)
+        return;
+    Quarantine_File qf = { NULL };
+    eina_hash_foreach(entries, _collect_entry, &qf.entries);
+
+    Eet_File* ef = eet_open(cache_path, EET_FILE_MODE_WRITE);
+    if (!ef) {
+        WRN("Failed to open %s for writing", cache_path);
+        eina_list_free(qf.entries);
+        return;
+    }
+    if (!eet_data_write(ef, _file_edd, "quarantine", &qf, EET_COMPRESSION_DEFAULT))
+        WRN("Failed to write quarantine to %s", cache_path);
+    eet_close(ef);
+    eina_list_free(qf.entries);
+}
+
+static Eina_Bool _on_save_timer(void* data EINA_UNUSED)
+{
+    save_timer = NULL;
+    _save();
+    return ECORE_CALLBACK_CANCEL;
+}
+
+// Batch changes: a burst of strikes costs one write
+static void _save_later(void)
+{
+    if (!save_timer)
+        save_timer = ecore_timer_add(QUARANTINE_SAVE_DELAY, _on_save_timer, NULL);
+}
+
+// Catalog paths of PDF pages and pack frames stand for their whole file
+static int _stat(const char* path, struct stat* st)
+{
+    char file[PATH_MAX];
+    return stat(media_source_file(path, file, sizeof(file)), st);
+}
+
+static void _load(void)
+{
+    Eet_File* ef = eet_open(cache_path, EET_FILE_MODE_READ);
+    if (!ef)
+        return;
+    Quarantine_File* qf = eet_data_read(ef, _file_edd, "quarantine");
+    eet_close(ef);
+    if (!qf)
+        return;
+
+    Quarantine_Entry* e;
+    EINA_LIST_FREE(qf->entries, e)
+    {
+        struct stat st;
+        // Forget files that were deleted since the last run
+        if (!e->path || _stat(e->path, &st) != 0 || eina_hash_find(entries, e->path)) {
+            _entry_free(e);
+            continue;
+        }
+        e->probing = EINA_FALSE;
+        eina_hash_add(entries, e->path, e);
+    }
+    free(qf);
+    INF("Loaded %d quarantined media entries", eina_hash_population(entries));
+}
+
+void quarantine_init(void)
+{
+    if (entries)
+        return;
+    _edd_setup();
+    entries = eina_hash_string_superfast_new(_entry_free);
+    cache_path = config_get_xdg_config_path("eslide", "quarantine.eet");
+    if (cache_path)
+        _load();
+}
+
+void quarantine_shutdown(void)
+{
+    // Probes decode with Emile: they must be over before the decoder shuts down
+    Eina_List* pending = probes;
+    probes = NULL;
+    Ecore_Thread* thread;
+    EINA_LIST_FREE(pending, thread)
+    {
+        ecore_thread_cancel(thread);
+        if (!ecore_thread_wait(thread, QUARANTINE_PROBE_WAIT))
+            WRN("A quarantine re-probe is still running at shutdown");
+    }
+    if (save_timer) {
+        ecore_timer_del(save_timer);
+        save_timer = NULL;
+    }
+    if (entries) {
+        _save();
+        eina_hash_free(entries);
+        entries = NULL;
+    }
+    free(cache_path);
+    cache_path = NULL;
+    if (_file_edd) {
+        eet_data_descriptor_free(_file_edd);
+        _file_edd = NULL;
+    }
+    if (_entry_edd) {
+        eet_data_descriptor_free(_entry_edd);
+        _entry_edd = NULL;
+    }
+}
+
+void quarantine_add(const char* path, Quarantine_Reason reason)
+{
+    struct stat st;
+    if (!entries || !path || _stat(path, &st) != 0)
+        return;
+
+    Quarantine_Entry* e = eina_hash_find(entries, path);
+    if (e && _entry_matches(e, &st)) {
+        e->strikes++;
+        e->reason = reason;
+    } else {
+        if (!e) {
+            e = calloc(1, sizeof(Quarantine_Entry));
+            if (!e)
+                return;
+            e->path = eina_stringshare_add(path);
+            eina_hash_add(entries, e->path, e);
+        }
+        _entry_key_set(e, &st);
+        e->reason = reason;
+        e->strikes = 1;
+    }
+
+    if (_entry_active(e))
+        WRN("Quarantined %s (reason %d)", path, reason);
+    _save_later();
+}
+
+void quarantine_clear(const char* path)
+{
+    Quarantine_Entry* e = entries && path ? eina_hash_find(entries, path) : NULL;
+    if (!e || e->probing)
+        return;
+    if (_entry_active(e))
+        INF("%s displayed, releasing it from quarantine", path);
+    eina_hash_del_by_key(entries, path);
+    _save_later();
+}
+
+static void _probe_run(void* data, Ecore_Thread* thread)
+{
+    Quarantine_Probe* probe = data;
+    if (ecore_thread_check(thread))
+        return;
+    // Only JPEG/RAW can be decoded off the main loop; anything else that
+    // changed gets another chance with the Evas loaders
+    probe->ok = probe->st.st_size > 0
+        && (!decode_is_supported(probe->path) || decode_probe(probe->path));
+}
+
+static void _probe_end(void* data, Ecore_Thread* thread)
+{
+    Quarantine_Probe* probe = data;
+    probes = eina_list_remove(probes, thread);
+
+    Quarantine_Entry* e = entries ? eina_hash_find(entries, probe->path) : NULL;
+    if (e) {
+        if (probe->ok) {
+            INF("Re-probe passed, releasing %s from quarantine", probe->path);
+            eina_hash_del_by_key(entries, probe->path);
+        } else {
+            // Still broken in its new state; wait for the next change
+            e->probing = EINA_FALSE;
+            _entry_key_set(e, &probe->st);
+            e->reason = QUARANTINE_DECODE_ERROR;
+            e->strikes++;
+        }
+        _save_later();
+    }
+    free(probe->path);
+    free(probe);
+}
+
+static void _probe_cancel(void* data, Ecore_Thread* thread)
+{
+    Quarantine_Probe* probe = data;
+    probes = eina_list_remove(probes, thread);
+    Quarantine_Entry* e = entries ? eina_hash_find(entries, probe->path) : NULL;
+    if (e)
+        e->probing = EINA_FALSE;
+    free(probe->path);
+    free(probe);
+}
+
+Eina_Bool quarantine_contains(const char* path)
+{
+    if (!entries || !path)
+        return EINA_FALSE;
+    Quarantine_Entry* e = eina_hash_find(entries, path);
+    if (!e)
+        return EINA_FALSE;
+
+    struct stat st;
+    if (_stat(path, &st) != 0)
+        return EINA_TRUE;
+    if (_entry_matches(e, &st))
+        return _entry_active(e);
+
+    // File changed since it failed. Pending timeout strikes are simply reset;
+    // real failures stay skipped until a worker has decoded the new version.
+    if (!_entry_active(e)) {
+        eina_hash_del_by_key(entries, path);
+        _save_later();
+        return EINA_FALSE;
+    }
+    if (!e->probing) {
+        Quarantine_Probe* probe = calloc(1, sizeof(Quarantine_Probe));
+        if (probe) {
+            probe->path = strdup(path);
+            probe->st = st;
+            e->probing = EINA_TRUE;
+            DBG("Re-probing changed quarantined file %s", path);
+            Ecore_Thread* thread
+                = ecore_thread_run(_probe_run, _probe_end, _probe_cancel, probe);
+            if (thread)
+                probes = eina_list_append(probes, thread);
+        }
+    }
+    return EINA_TRUE;
+}
@@ -0,0 +1,34 @@
+#ifndef QUARANTINE_H
+#define QUARANTINE_H
+
+#include "common.h"
+
+// Negative cache for media that failed to display. Entries are keyed by the
+// file's inode, size and mtime and persisted with Eet, so a corrupt or
+// half-copied file is skipped on every loop and across restarts until it
+// changes on disk; a changed file is re-probed on a worker thread.
+
+typedef enum {
+    QUARANTINE_DECODE_ERROR = 1, // decoder rejected the file (incl. truncated JPEG)
+    QUARANTINE_TIMEOUT = 2,      // never reported ready within the fade hold
+    QUARANTINE_ZERO_SIZE = 3,    // loaded with zero width or height
+} Quarantine_Reason;
+
+// Load the persisted cache (call after config_eet_init) and save/free it
+void quarantine_init(void);
+void quarantine_shutdown(void);
+
+// Record a display failure for path. Decode errors and zero dimensions
+// quarantine immediately; timeouts only after repeated strikes, since a slow
+// disk can delay a perfectly good file.
+void quarantine_add(const char* path, Quarantine_Reason reason);
+
+// path was displayed: forget its strikes, so timeouts weeks apart on a slow
+// disk never add up to a quarantine
+void quarantine_clear(const char* path);
+
+// Whether path should be skipped. If the file changed since it failed, a
+// background re-probe is started and the entry stays skipped until it passes.
+Eina_Bool quarantine_contains(const char* path);
+
+#endif /* QUARANTINE_H */
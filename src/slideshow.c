@@ -1,5 +1,19 @@
 #include "slideshow.h"
+#include "anim.h"
+#include "contrast.h"
+#include "decode.h"
+#include "exif.h"
+#include "governor.h"
+#include "pano.h"
+#include "poster.h"
+#include "prefetch.h"
+#include "proxy.h"
+#include "quarantine.h"
+#include "timelapse.h"
+#include "transition.h"
 #include "ui.h"
+#include "vidbuf.h"
+#include "wall.h"
 
 // Slideshow state variables
 Eina_Bool slideshow_running = EINA_TRUE;
@@ -18,6 +32,9 @@ static Eina_Bool waiting_media_ready = EINA_FALSE;
 static double waiting_start_time = 0.0;
 // Forward declaration for image load readiness callback
 static void _on_image_load_ready(void* data, Evas_Object* obj, void* event_info);
+// Forward declarations for the front/back buffer transition
+static void _swap_run(const Decoded_Slide* slide);
+static void _swap_finish(Eina_Bool swapped);
 
 // Runtime-configurable timings (initialized to compile-time defaults)
 static double slideshow_interval_runtime = SLIDESHOW_INTERVAL;
@@ -25,8 +42,66 @@ static double fade_duration_runtime = FADE_DURATION;
 
 // Preloading support: hidden Evas image used to warm cache for next image
 static Evas_Object* preload_img = NULL;
+// Path whose background decode on preload_img has completed (warm in cache)
+static char* preloaded_path = NULL;
+// Path currently being decoded on preload_img
+static char* preload_pending_path = NULL;
+// Embedded EXIF/MPF preview shown while a cold image is still decoding
+static Evas_Object* preview_img = NULL;
+static int preview_w = 0, preview_h = 0;
+// Frames of an animated GIF, drawn over its still first frame in the widget
+static Evas_Object* anim_img = NULL;
+static int anim_w = 0, anim_h = 0;
+// Video whose poster frame stands in (in preview_img) until it shows a frame
+static char* poster_path = NULL;
+// Ken Burns motion path, precomputed when a slide becomes the front buffer.
+// Zoom starts at 1 (the plain fit) so the motion can begin without a jump.
+typedef struct {
+    double zoom_to;
+    double cx_to; // normalized centre of the final view
+    double cy_to;
+} Ken_Burns_Path;
+// Front/back pair of upright buffers from the background decoder, placed in
+// the letterbox fit rect. The next slide goes into the back buffer, which is
+// alpha-blended over the front one and then becomes the new front.
+typedef struct {
+    Evas_Object* obj;
+    int w;
+    int h;
+    Ken_Burns_Path kb;
+} Display_Buffer;
+static Display_Buffer display_buffers[2];
+static int front_buffer = 0;
+// Buffer swap progress: waiting for the back buffer to decode, or transitioning
+typedef enum { SWAP_NONE, SWAP_WAITING, SWAP_RUNNING } Swap_State;
+static Swap_State swap_state = SWAP_NONE;
+// Transition requested for buffer swaps ("random" or a registered name)
+static char* transition_name_runtime = NULL;
+// Ken Burns pan/zoom during the dwell. Slides are decoded oversampled to the
+// largest zoom's footprint so every frame samples a display-size buffer.
+#define KEN_BURNS_MAX_ZOOM 1.15
+#define KEN_BURNS_MIN_ZOOM 1.06
+// Frames sampled per slide before judging the frame budget
+#define KEN_BURNS_BUDGET_FRAMES 30
+#define KEN_BURNS_SLOW_FACTOR 1.5
+// Static slides shown after a budget overrun before motion is retried
+#define KEN_BURNS_RETRY_SLIDES 10
+static Eina_Bool ken_burns_enabled = EINA_FALSE;
+static Ecore_Animator* ken_burns_animator = NULL;
+static double ken_burns_start_time = 0.0;
+static double ken_burns_last_frame = 0.0;
+static double ken_burns_frame_sum = 0.0;
+static int ken_burns_frames = 0;
+static int ken_burns_static_slides = 0;
+// Image currently presented (or being decoded for presentation)
+static char* display_path = NULL;
+// Debounce re-decodes while the letterbox is being resized
+static Ecore_Timer* redecode_timer = NULL;
+#define REDECODE_DELAY 0.3
 // Navigation coalescing: queue next/prev requests during active fade
 static int pending_nav = 0; // 0 = none, 1 = next, -1 = prev
+// Slide announced by the wall leader while a transition was running
+static char* wall_pending_path = NULL;
 
 // Ensure the fade overlay exists and is configured
 static void _ensure_fade_overlay(void)
@@ -60,6 +135,768 @@ static void _update_fade_overlay_geometry(void)
     evas_object_resize(fade_overlay, w, h);
 }
 
+// Decode target: the letterbox size, or 0x0 (full resolution) before layout
+static void _letterbox_target(int* tw, int* th)
+{
+    Evas_Coord w = 0, h = 0;
+    if (letterbox_bg)
+        evas_object_geometry_get(letterbox_bg, NULL, NULL, &w, &h);
+    if (w <= 1 || h <= 1)
+        w = h = 0;
+    if (ken_burns_enabled) {
+        w = (Evas_Coord) (w * KEN_BURNS_MAX_ZOOM);
+        h = (Evas_Coord) (h * KEN_BURNS_MAX_ZOOM);
+    }
+    *tw = w;
+    *th = h;
+}
+
+// Place obj at the aspect-fit rectangle of an iw x ih image in the letterbox
+static void _fit_in_letterbox(Evas_Object* obj, int iw, int ih)
+{
+    if (!obj || !letterbox_bg || iw <= 0 || ih <= 0)
+        return;
+    Evas_Coord x, y, w, h;
+    evas_object_geometry_get(letterbox_bg, &x, &y, &w, &h);
+    double scale = (double) w / iw;
+    if ((double) h / ih < scale)
+        scale = (double) h / ih;
+    Evas_Coord pw = (Evas_Coord) (iw * scale + 0.5);
+    Evas_Coord ph = (Evas_Coord) (ih * scale + 0.5);
+    evas_object_move(obj, x + (w - pw) / 2, y + (h - ph) / 2);
+    evas_object_resize(obj, pw, ph);
+}
+
+// Decoded images cover elm_image, so forward single clicks like it would
+static void _on_display_image_click(
+    void* data EINA_UNUSED, Evas* e EINA_UNUSED, Evas_Object* obj, void* event_info EINA_UNUSED)
+{
+    on_media_click(NULL, obj, NULL);
+}
+
+// Create a filled image object for pre-decoded pixels, stacked directly above
+// the window so overlay labels and the fade overlay stay on top of it
+static Eina_Bool _ensure_image_object(Evas_Object** obj)
+{
+    if (*obj)
+        return EINA_TRUE;
+    if (!letterbox_bg)
+        return EINA_FALSE;
+    Evas* evas = evas_object_evas_get(letterbox_bg);
+    if (!evas)
+        return EINA_FALSE;
+
+    *obj = evas_object_image_filled_add(evas);
+    evas_object_image_colorspace_set(*obj, EVAS_COLORSPACE_ARGB8888);
+    evas_object_image_alpha_set(*obj, EINA_FALSE);
+    evas_object_image_smooth_scale_set(*obj, EINA_TRUE);
+    // Let double-clicks reach the letterbox underneath as well
+    evas_object_repeat_events_set(*obj, EINA_TRUE);
+    evas_object_event_callback_add(*obj, EVAS_CALLBACK_MOUSE_UP, _on_display_image_click, NULL);
+
+    Evas_Object* win = elm_object_top_widget_get(letterbox_bg);
+    if (win)
+        evas_object_stack_above(*obj, win);
+    else
+        evas_object_raise(*obj);
+    return EINA_TRUE;
+}
+
+// Copy a decoded buffer into an image object and size it to the letterbox
+static Eina_Bool _set_image_pixels(Evas_Object** obj, const Decoded_Slide* slide)
+{
+    if (!slide || !_ensure_image_object(obj))
+        return EINA_FALSE;
+    evas_object_image_size_set(*obj, slide->w, slide->h);
+    evas_object_image_data_copy_set(*obj, slide->pixels);
+    evas_object_image_data_update_add(*obj, 0, 0, slide->w, slide->h);
+    _fit_in_letterbox(*obj, slide->w, slide->h);
+    return EINA_TRUE;
+}
+
+// Hide the embedded preview once the full-quality image has replaced it
+static void _hide_embedded_preview(void)
+{
+    if (preview_img)
+        evas_object_hide(preview_img);
+}
+
+static Display_Buffer* _front(void)
+{
+    return &display_buffers[front_buffer];
+}
+
+static Display_Buffer* _back(void)
+{
+    return &display_buffers[!front_buffer];
+}
+
+static void _on_anim_frame(void* data EINA_UNUSED, const Decoded_Slide* frame)
+{
+    if (!_set_image_pixels(&anim_img, frame))
+        return;
+    anim_w = frame->w;
+    anim_h = frame->h;
+    if (!evas_object_visible_get(anim_img)) {
+        // Time-lapse frames replace a decoded first frame
+        if (_front()->obj)
+            evas_object_stack_above(anim_img, _front()->obj);
+        evas_object_show(anim_img);
+    }
+}
+
+// Stop the animation or time-lapse in progress and take its frames off screen
+static void _anim_stop(void)
+{
+    anim_stop();
+    timelapse_stop();
+    if (anim_img)
+        evas_object_hide(anim_img);
+}
+
+// Hold or resume whichever animation is playing
+static void _anim_pause(Eina_Bool pause)
+{
+    anim_pause(pause);
+    timelapse_pause(pause);
+    pano_pause(pause);
+}
+
+// Hide whichever object is playing a video
+static void _hide_video(void)
+{
+    if (slideshow_video)
+        evas_object_hide(slideshow_video);
+    vidbuf_stop();
+    proxy_watch(NULL, NULL);
+    free(poster_path);
+    poster_path = NULL;
+}
+
+static Eina_Bool _buffer_set(Display_Buffer* buf, const Decoded_Slide* slide)
+{
+    if (!_set_image_pixels(&buf->obj, slide))
+        return EINA_FALSE;
+    buf->w = slide->w;
+    buf->h = slide->h;
+    return EINA_TRUE;
+}
+
+static void _hide_decoded(void)
+{
+    for (int i = 0; i < 2; i++) {
+        if (display_buffers[i].obj)
+            evas_object_hide(display_buffers[i].obj);
+    }
+}
+
+// Decode the embedded JPEG preview of path, upright. A thumbnail of a few KB
+// is cheap enough to decode synchronously, so a cold navigation has something
+// on screen within one frame.
+static Decoded_Slide* _decode_embedded_preview(const char* path)
+{
+    unsigned char* data = NULL;
+    size_t size = 0;
+    // A whole-slide thumbnail would not line up with the other wall tiles
+    if (!path || wall_active() || !exif_preview_get(path, &data, &size))
+        return NULL;
+    // Thumbnails are stored sideways too; use the main image's orientation
+    Decoded_Slide* preview = decode_jpeg_memory(data, size, exif_orientation_get(path), 0, 0);
+    free(data);
+    return preview;
+}
+
+// Show the embedded JPEG preview scaled up to the letterbox fit rectangle
+static Eina_Bool _show_embedded_preview(const char* path)
+{
+    if (!letterbox_bg)
+        return EINA_FALSE;
+    Decoded_Slide* preview = _decode_embedded_preview(path);
+    if (!preview)
+        return EINA_FALSE;
+
+    Eina_Bool ok = _set_image_pixels(&preview_img, preview);
+    if (ok) {
+        preview_w = preview->w;
+        preview_h = preview->h;
+        evas_object_show(preview_img);
+        if (_front()->obj)
+            evas_object_stack_above(preview_img, _front()->obj);
+        DBG("Showing embedded preview %dx%d for %s", preview_w, preview_h, path);
+    }
+    decoded_slide_free(preview);
+    return ok;
+}
+
+// Random zoom-in towards a point that keeps the view inside the image
+static void _ken_burns_plan(Ken_Burns_Path* kb)
+{
+    double r = (double) rand() / RAND_MAX;
+    kb->zoom_to = KEN_BURNS_MIN_ZOOM + (KEN_BURNS_MAX_ZOOM - KEN_BURNS_MIN_ZOOM) * r;
+    double reach = (1.0 - 1.0 / kb->zoom_to) / 2.0;
+    kb->cx_to = 0.5 + reach * (2.0 * rand() / RAND_MAX - 1.0);
+    kb->cy_to = 0.5 + reach * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+// Show the part of buf's image along its path at t (0..1). The map keeps the
+// object's own rectangle and moves the image UVs, which are doubles, so the
+// motion is sub-pixel even when it advances less than a pixel per frame.
+static void _ken_burns_apply(Display_Buffer* buf, double t)
+{
+    if (!buf->obj || buf->w <= 0 || buf->h <= 0)
+        return;
+    double zoom = 1.0 + (buf->kb.zoom_to - 1.0) * t;
+    double cx = 0.5 + (buf->kb.cx_to - 0.5) * t;
+    double cy = 0.5 + (buf->kb.cy_to - 0.5) * t;
+    double vw = buf->w / zoom;
+    double vh = buf->h / zoom;
+    double u0 = cx * buf->w - vw / 2.0;
+    double v0 = cy * buf->h - vh / 2.0;
+
+    Evas_Map* m = evas_map_new(4);
+    if (!m)
+        return;
+    evas_map_util_points_populate_from_object(m, buf->obj);
+    evas_map_point_image_uv_set(m, 0, u0, v0);
+    evas_map_point_image_uv_set(m, 1, u0 + vw, v0);
+    evas_map_point_image_uv_set(m, 2, u0 + vw, v0 + vh);
+    evas_map_point_image_uv_set(m, 3, u0, v0 + vh);
+    evas_map_smooth_set(m, EINA_TRUE);
+    evas_object_map_set(buf->obj, m);
+    evas_object_map_enable_set(buf->obj, EINA_TRUE);
+    evas_map_free(m);
+}
+
+static void _ken_burns_stop(void)
+{
+    if (ken_burns_animator) {
+        ecore_animator_del(ken_burns_animator);
+        ken_burns_animator = NULL;
+    }
+}
+
+static Eina_Bool _ken_burns_animator_cb(void* data EINA_UNUSED)
+{
+    Display_Buffer* front = _front();
+    if (!front->obj || !evas_object_visible_get(front->obj)) {
+        ken_burns_animator = NULL;
+        return ECORE_CALLBACK_CANCEL;
+    }
+    // Hold still while a transition owns the buffers
+    if (swap_state != SWAP_NONE) {
+        ken_burns_last_frame = 0.0;
+        return ECORE_CALLBACK_RENEW;
+    }
+
+    double now = ecore_time_get();
+    if (ken_burns_last_frame > 0.0 && ken_burns_frames < KEN_BURNS_BUDGET_FRAMES) {
+        ken_burns_frame_sum += now - ken_burns_last_frame;
+        if (++ken_burns_frames == KEN_BURNS_BUDGET_FRAMES) {
+            double mean = ken_burns_frame_sum / ken_burns_frames;
+            double period = ecore_animator_frametime_get();
+            if (period > 0.0 && mean > period * KEN_BURNS_SLOW_FACTOR) {
+                // Freeze where we are rather than stutter
+                WRN("Ken Burns averaged %.1f ms/frame (target %.1f); showing static slides",
+                    mean * 1000.0, period * 1000.0);
+                ken_burns_static_slides = KEN_BURNS_RETRY_SLIDES;
+                ken_burns_animator = NULL;
+                return ECORE_CALLBACK_CANCEL;
+            }
+        }
+    }
+    ken_burns_last_frame = now;
+
+    // Span the whole dwell so motion never stops before the next transition
+    double span = slideshow_interval_runtime + fade_duration_runtime;
+    double t = span > 0.0 ? (now - ken_burns_start_time) / span : 1.0;
+    if (t > 1.0)
+        t = 1.0;
+    _ken_burns_apply(front, t);
+    return ECORE_CALLBACK_RENEW;
+}
+
+// A new slide became the front buffer: plan its path and start moving
+static void _ken_burns_start(void)
+{
+    Display_Buffer* front = _front();
+    if (front->obj)
+        evas_object_map_enable_set(front->obj, EINA_FALSE);
+    _ken_burns_stop();
+    if (!ken_burns_enabled || !front->obj)
+        return;
+    // A time-lapse plays over its first frame, which has to stay put, and
+    // wall tiles would each move their own part of the slide
+    if (timelapse_is_lead(display_path) || wall_active())
+        return;
+    if (ken_burns_static_slides > 0) {
+        ken_burns_static_slides--;
+        return;
+    }
+    _ken_burns_plan(&front->kb);
+    ken_burns_start_time = ecore_time_get();
+    ken_burns_last_frame = 0.0;
+    ken_burns_frame_sum = 0.0;
+    ken_burns_frames = 0;
+    ken_burns_animator = ecore_animator_add(_ken_burns_animator_cb, NULL);
+}
+
+// Present a slide from the background decoder in the front buffer
+static void _present_decoded(const Decoded_Slide* slide)
+{
+    Display_Buffer* front = _front();
+    if (!_buffer_set(front, slide))
+        return;
+    evas_object_color_set(front->obj, 255, 255, 255, 255);
+    evas_object_show(front->obj);
+    if (_back()->obj)
+        evas_object_hide(_back()->obj);
+    if (preview_img)
+        evas_object_stack_above(preview_img, front->obj);
+    contrast_apply(slide);
+    // Sharper re-decodes of the same slide keep their path going
+    if (!ken_burns_animator)
+        _ken_burns_start();
+}
+
+// New media is fully on screen: leave the hold phase and start fading in
+static void _media_ready(void)
+{
+    if (!is_fading)
+        return;
+    if (!waiting_media_ready)
+        return;
+
+    if (next_media_path) {
+        free(next_media_path);
+        next_media_path = NULL;
+    }
+    waiting_media_ready = EINA_FALSE;
+    fade_start_time = ecore_time_get();
+}
+
+// Whether the background preload already finished decoding this path
+static Eina_Bool _is_preloaded(const char* path)
+{
+    return preloaded_path && path && strcmp(preloaded_path, path) == 0;
+}
+
+// Remember which file finished preloading so navigation can tell warm from cold
+static void _on_preload_done(
+    void* data EINA_UNUSED, Evas* e EINA_UNUSED, Evas_Object* obj EINA_UNUSED,
+    void* event_info EINA_UNUSED)
+{
+    free(preloaded_path);
+    preloaded_path = preload_pending_path;
+    preload_pending_path = NULL;
+}
+
+// Point the display widget at an image. RAW files display their embedded
+// full-size JPEG preview through the same mapping the preloader used.
+static Eina_Bool _display_image_set(const char* path)
+{
+    if (!slideshow_image || !path)
+        return EINA_FALSE;
+    if (is_raw_file(path)) {
+        Eina_File* f = media_raw_preview_open(path);
+        if (!f)
+            return EINA_FALSE;
+        Eina_Bool ok = elm_image_mmap_set(slideshow_image, f, NULL);
+        eina_file_close(f);
+        return ok;
+    }
+    return elm_image_file_set(slideshow_image, path, NULL);
+}
+
+// A display failure was recorded: stop holding the overlay and move on
+static void _skip_failed_media(const char* path, Quarantine_Reason reason)
+{
+    quarantine_add(path, reason);
+    if (!is_fading)
+        return;
+    _media_ready();
+    // Advance again as soon as the fade-in completes
+    if (pending_nav == 0)
+        pending_nav = 1;
+}
+
+// Evas loader could not open the image at all
+static void _on_image_load_error(
+    void* data EINA_UNUSED, Evas_Object* obj, void* event_info EINA_UNUSED)
+{
+    evas_object_smart_callback_del(obj, "load,ready", _on_image_load_ready);
+    evas_object_smart_callback_del(obj, "load,error", _on_image_load_error);
+    if (!display_path)
+        return;
+    WRN("Failed to load %s", display_path);
+    _skip_failed_media(display_path, QUARANTINE_DECODE_ERROR);
+}
+
+// Load through the Evas loaders into the elm_image widget (PNG, GIF, BMP and
+// anything the background decoder rejected); readiness arrives via 'load,ready'
+static void _present_with_evas_loader(const char* path)
+{
+    if (!slideshow_image)
+        return;
+    _display_image_set(path);
+    contrast_apply(NULL);
+    elm_object_content_set(letterbox_bg, slideshow_image);
+    evas_object_show(slideshow_image);
+    // Frames are decoded while the fade finishes; they play once it is done
+    if (anim_is_animated(path)) {
+        int tw, th;
+        _letterbox_target(&tw, &th);
+        _anim_pause(is_fading);
+        anim_start(path, tw, th, _on_anim_frame, NULL);
+    }
+    // Begin preloading on the display image to trigger callback when ready
+    Evas_Object* img_obj = elm_image_object_get(slideshow_image);
+    if (img_obj)
+        evas_object_image_preload(img_obj, EINA_FALSE);
+    // Ensure only one callback instance is registered
+    evas_object_smart_callback_del(slideshow_image, "load,ready", _on_image_load_ready);
+    evas_object_smart_callback_add(slideshow_image, "load,ready", _on_image_load_ready, NULL);
+    evas_object_smart_callback_del(slideshow_image, "load,error", _on_image_load_error);
+    evas_object_smart_callback_add(slideshow_image, "load,error", _on_image_load_error, NULL);
+}
+
+// Background decode finished for a slide we asked to present
+static void _on_decode_done(void* data EINA_UNUSED, const char* path, const Decoded_Slide* slide)
+{
+    // Ignore decodes for slides that are no longer on screen
+    if (!display_path || strcmp(display_path, path) != 0)
+        return;
+    if (!slide) {
+        if (swap_state == SWAP_WAITING) {
+            // Nothing was blended in yet: keep the old slide, the timer moves on
+            quarantine_add(path, QUARANTINE_DECODE_ERROR);
+            _swap_finish(EINA_FALSE);
+            return;
+        }
+        // Evas' own JPEG loader is Emile too, so there is nothing to fall back to
+        if (swap_state == SWAP_NONE)
+            _hide_decoded();
+        _skip_failed_media(path, QUARANTINE_DECODE_ERROR);
+        return;
+    }
+    quarantine_clear(path);
+    if (swap_state == SWAP_WAITING) {
+        _swap_run(slide);
+        return;
+    }
+    if (swap_state == SWAP_RUNNING) {
+        // Replace the embedded preview being blended in, keeping its alpha
+        _buffer_set(_back(), slide);
+        return;
+    }
+    if (slideshow_image)
+        evas_object_hide(slideshow_image);
+    // A swap that timed out may have left the previous video up
+    _hide_video();
+    _present_decoded(slide);
+    _hide_embedded_preview();
+    _media_ready();
+}
+
+// Start playing the sequence when path leads a time-lapse. Frames are decoded
+// at the plain letterbox size and cover the first frame once they flow.
+static void _timelapse_begin(const char* path)
+{
+    if (!letterbox_bg || !timelapse_is_lead(path))
+        return;
+    Evas_Coord w = 0, h = 0;
+    evas_object_geometry_get(letterbox_bg, NULL, NULL, &w, &h);
+    _anim_pause(is_fading);
+    timelapse_start(path, w > 1 ? w : 0, h > 1 ? h : 0, _on_anim_frame, NULL);
+}
+
+// Panoramas pan on a single screen; a wall shows them spread across it
+static Eina_Bool _is_panorama(const char* path)
+{
+    return !wall_active() && pano_is_panorama(path);
+}
+
+// The panorama's first screenful is up, or the file could not be decoded
+static void _on_pano_ready(void* data EINA_UNUSED, Eina_Bool ok)
+{
+    if (ok) {
+        quarantine_clear(display_path);
+        _media_ready();
+    } else if (display_path) {
+        _skip_failed_media(display_path, QUARANTINE_DECODE_ERROR);
+    }
+}
+
+// Put an image on screen. Returns EINA_TRUE when something representative is
+// already visible (the decoded slide or its embedded preview) so a transition
+// can fade in at once; otherwise readiness is signalled through _media_ready().
+static Eina_Bool _present_image(const char* path)
+{
+    free(display_path);
+    display_path = strdup(path);
+    // A new slide gets a new motion path and ends any animation
+    _ken_burns_stop();
+    _anim_stop();
+    pano_stop();
+
+    // Panoramas pan across the slide in strips instead of being fitted
+    if (_is_panorama(path)) {
+        if (slideshow_image)
+            evas_object_hide(slideshow_image);
+        _hide_decoded();
+        _hide_embedded_preview();
+        contrast_apply(NULL);
+        _anim_pause(is_fading);
+        if (pano_start(path, slideshow_interval_runtime, _on_pano_ready, NULL))
+            return EINA_FALSE;
+    }
+
+    if (decode_is_supported(path)) {
+        int tw, th;
+        _letterbox_target(&tw, &th);
+        const Decoded_Slide* slide = decode_cache_get(path, tw, th);
+        if (slide) {
+            quarantine_clear(path);
+            if (slideshow_image)
+                evas_object_hide(slideshow_image);
+            _hide_embedded_preview();
+            _present_decoded(slide);
+            _timelapse_begin(path);
+            return EINA_TRUE;
+        }
+        // Cold: drop the previous slide and cover the decode with the preview
+        if (slideshow_image)
+            evas_object_hide(slideshow_image);
+        _hide_decoded();
+        _hide_embedded_preview();
+        Eina_Bool previewed = _show_embedded_preview(path);
+        decode_request(path, tw, th, _on_decode_done, NULL);
+        _timelapse_begin(path);
+        return previewed;
+    }
+
+    _hide_decoded();
+    _hide_embedded_preview();
+    _present_with_evas_loader(path);
+    return EINA_FALSE;
+}
+
+// Hide every still-image layer (before showing a video)
+static void _hide_still_images(void)
+{
+    if (slideshow_image)
+        evas_object_hide(slideshow_image);
+    _hide_decoded();
+    _hide_embedded_preview();
+    _anim_stop();
+    pano_stop();
+    // Nothing measured the video: overlays return to their default style
+    contrast_apply(NULL);
+}
+
+// Put a video's poster frame up in the preview layer
+static void _show_poster(const Decoded_Slide* poster)
+{
+    if (!_set_image_pixels(&preview_img, poster))
+        return;
+    preview_w = poster->w;
+    preview_h = poster->h;
+    evas_object_show(preview_img);
+    contrast_apply(poster);
+}
+
+static void _on_poster_done(void* data EINA_UNUSED, const char* path, const Decoded_Slide* slide)
+{
+    // Only while the video has not shown a frame of its own
+    if (slide && poster_path && strcmp(poster_path, path) == 0)
+        _show_poster(slide);
+}
+
+// The playing video has a frame on screen: the poster is no longer needed
+static void _on_video_shown(
+    void* data EINA_UNUSED, Evas_Object* obj EINA_UNUSED, void* event_info EINA_UNUSED)
+{
+    if (!poster_path)
+        return;
+    free(poster_path);
+    poster_path = NULL;
+    _hide_embedded_preview();
+}
+
+// Show a video, swapping in the prebuffered object when it holds this one.
+// Its poster frame covers the wait for the first decoded frame.
+static void _present_video(const char* path)
+{
+    _hide_still_images();
+    free(poster_path);
+    poster_path = NULL;
+    if (poster_is_supported(path)) {
+        poster_path = strdup(path);
+        int tw, th;
+        _letterbox_target(&tw, &th);
+        const Decoded_Slide* poster = decode_cache_get(path, tw, th);
+        if (poster)
+            _show_poster(poster);
+        else
+            decode_request(path, tw, th, _on_poster_done, NULL);
+    }
+    // Heavy sources play from their proxy once one has been transcoded
+    char* play = proxy_resolve(path);
+    Evas_Object* emotion = vidbuf_play(play);
+    if (emotion) {
+        if (slideshow_video) {
+            elm_video_stop(slideshow_video);
+            evas_object_hide(slideshow_video);
+        }
+    } else {
+        vidbuf_stop();
+        if (slideshow_video) {
+            elm_video_file_set(slideshow_video, play);
+            elm_object_content_set(letterbox_bg, slideshow_video);
+            elm_video_play(slideshow_video);
+            evas_object_show(slideshow_video);
+            emotion = elm_video_emotion_get(slideshow_video);
+        }
+    }
+    proxy_watch(emotion, path);
+    free(play);
+}
+
+// Re-decode the current slide at the new letterbox size once resizing settles
+static Eina_Bool _redecode_timer_cb(void* data EINA_UNUSED)
+{
+    redecode_timer = NULL;
+    Display_Buffer* front = _front();
+    if (!display_path || !front->obj || !evas_object_visible_get(front->obj))
+        return ECORE_CALLBACK_CANCEL;
+    int tw, th;
+    _letterbox_target(&tw, &th);
+    decode_request(display_path, tw, th, _on_decode_done, NULL);
+    return ECORE_CALLBACK_CANCEL;
+}
+
+void slideshow_redecode(void)
+{
+    if (redecode_timer) {
+        ecore_timer_del(redecode_timer);
+        redecode_timer = NULL;
+    }
+    _redecode_timer_cb(NULL);
+}
+
+// Keep pre-decoded layers and the overlay aligned with the letterbox
+static void _on_letterbox_geometry_changed(
+    void* data EINA_UNUSED, Evas* e EINA_UNUSED, Evas_Object* obj EINA_UNUSED,
+    void* event_info EINA_UNUSED)
+{
+    _update_fade_overlay_geometry();
+    if (swap_state == SWAP_RUNNING) {
+        Evas_Coord x, y, w, h;
+        evas_object_geometry_get(letterbox_bg, &x, &y, &w, &h);
+        transition_geometry_set(x, y, w, h);
+    }
+    for (int i = 0; i < 2; i++) {
+        Display_Buffer* buf = &display_buffers[i];
+        if (buf->obj && evas_object_visible_get(buf->obj))
+            _fit_in_letterbox(buf->obj, buf->w, buf->h);
+    }
+    Display_Buffer* front = _front();
+    if (front->obj && evas_object_visible_get(front->obj) && front->w > 0 && front->h > 0) {
+        int tw, th;
+        _letterbox_target(&tw, &th);
+        // Slides are resampled to their exact fit rectangle: any change in
+        // size means Evas would scale every frame until it is re-decoded
+        double fit = (double) tw / front->w;
+        if ((double) th / front->h < fit)
+            fit = (double) th / front->h;
+        if (tw > 0 && (fit > 1.01 || fit < 0.99)) {
+            if (redecode_timer)
+                ecore_timer_del(redecode_timer);
+            redecode_timer = ecore_timer_add(REDECODE_DELAY, _redecode_timer_cb, NULL);
+        }
+    }
+    if (preview_img && evas_object_visible_get(preview_img))
+        _fit_in_letterbox(preview_img, preview_w, preview_h);
+    if (anim_img && evas_object_visible_get(anim_img))
+        _fit_in_letterbox(anim_img, anim_w, anim_h);
+}
+
+// Whether the catalog entry at index may be shown (not quarantined)
+static Eina_Bool _index_usable(int index)
+{
+    char* path = get_media_path_at_index(index);
+    // Later frames of a time-lapse play as part of its first one
+    Eina_Bool usable = path && !quarantine_contains(path) && !timelapse_is_member(path);
+    free(path);
+    return usable;
+}
+
+// First usable index stepping from index in direction dir (+1/-1); index
+// itself when every entry is quarantined
+static int _skip_quarantined(int index, int dir, int count)
+{
+    for (int i = 0; i < count; i++) {
+        int candidate = ((index + dir * i) % count + count) % count;
+        if (_index_usable(candidate))
+            return candidate;
+    }
+    return index;
+}
+
+// Shuffle order planned ahead so the prefetcher knows which files come next
+static int shuffle_queue[PREFETCH_AHEAD];
+static int shuffle_queue_len = 0;
+
+// Top up the planned shuffle order, dropping entries a rescan invalidated
+static void _shuffle_plan(int count)
+{
+    int kept = 0;
+    for (int i = 0; i < shuffle_queue_len; i++) {
+        if (shuffle_queue[i] < count)
+            shuffle_queue[kept++] = shuffle_queue[i];
+    }
+    shuffle_queue_len = kept;
+    while (shuffle_queue_len < PREFETCH_AHEAD) {
+        int prev = shuffle_queue_len ? shuffle_queue[shuffle_queue_len - 1] : current_media_index;
+        int idx = 0;
+        if (count > 1) {
+            do {
+                idx = rand() % count;
+            } while (idx == prev);
+        }
+        shuffle_queue[shuffle_queue_len++] = idx;
+    }
+}
+
+// Take the next planned shuffle index (never the one on screen)
+static int _shuffle_pop(int count)
+{
+    int idx;
+    do {
+        _shuffle_plan(count);
+        idx = shuffle_queue[0];
+        shuffle_queue_len--;
+        memmove(shuffle_queue, shuffle_queue + 1, shuffle_queue_len * sizeof(int));
+    } while (count > 1 && idx == current_media_index);
+    return idx;
+}
+
+// Paths of the slides expected after the current one, in display order
+static Eina_List* _upcoming_paths(int count)
+{
+    Eina_List* paths = NULL;
+    int index = current_media_index;
+    if (is_shuffle_mode)
+        _shuffle_plan(count);
+    for (int i = 0; i < PREFETCH_AHEAD && i < count - 1; i++) {
+        index = is_shuffle_mode ? shuffle_queue[i] : (index + 1) % count;
+        index = _skip_quarantined(index, 1, count);
+        char* path = get_media_path_at_index(index);
+        if (path)
+            paths = eina_list_append(paths, path);
+    }
+    return paths;
+}
+
 // Helper to determine next index without mutating current state
 static int _compute_next_index(void)
 {
@@ -70,51 +907,130 @@ static int _compute_next_index(void)
     if (is_shuffle_mode) {
         if (count == 1)
             return 0;
-        int idx;
-        do {
-            idx = rand() % count;
-        } while (idx == current_media_index);
-        return idx;
+        _shuffle_plan(count);
+        return _skip_quarantined(shuffle_queue[0], 1, count);
     } else {
-        return (current_media_index + 1) % count;
+        return _skip_quarantined((current_media_index + 1) % count, 1, count);
     }
 }
 
-// Preload the next image into the Evas cache to reduce stutter
-static void preload_next_image(void)
+static void _preload_image(char* next_path);
+
+// The header probe of an upcoming JPEG is in: panoramas are decoded strip by
+// strip once on screen, other images are preloaded now
+static void _on_pano_probed(void* data EINA_UNUSED, const char* path, Eina_Bool panorama)
 {
-    int next_index = _compute_next_index();
-    if (next_index < 0)
-        return;
+    if (!panorama || wall_active())
+        _preload_image(strdup(path));
+}
 
-    char* next_path = get_media_path_at_index(next_index);
+// Get next_path ready to show: decoded, prebuffered or in the Evas cache.
+// Takes ownership of next_path.
+static void _preload_path(char* next_path)
+{
     if (!next_path)
         return;
 
+    if (is_video_file(next_path)) {
+        // Open it now and hold the first frame so the switch is just a play
+        char* play = proxy_resolve(next_path);
+        vidbuf_prepare(play);
+        free(play);
+        if (poster_is_supported(next_path)) {
+            int tw, th;
+            _letterbox_target(&tw, &th);
+            decode_prefetch(next_path, tw, th);
+        }
+        free(next_path);
+        return;
+    }
     if (!is_image_file(next_path)) {
-        // Only preload images for now
+        free(next_path);
+        return;
+    }
+    // Whether a JPEG is a panorama is read from its header off the main loop
+    if (eina_str_has_extension(next_path, ".jpg") || eina_str_has_extension(next_path, ".jpeg")) {
+        pano_probe(next_path, _on_pano_probed, NULL);
+        free(next_path);
+        return;
+    }
+    _preload_image(next_path);
+}
+
+// Preload an image that is not a panorama. Takes ownership of next_path.
+static void _preload_image(char* next_path)
+{
+    if (!next_path)
+        return;
+
+    // JPEG and RAW go through the background decoder at letterbox size
+    if (decode_is_supported(next_path)) {
+        int tw, th;
+        _letterbox_target(&tw, &th);
+        decode_prefetch(next_path, tw, th);
+        DBG("Prefetching next image: %s", next_path);
+        free(next_path);
         return;
     }
 
     if (!preload_img) {
         // Create a hidden Evas image tied to the same canvas
         Evas* evas = evas_object_evas_get(letterbox_bg);
-        if (!evas)
+        if (!evas) {
+            free(next_path);
             return;
+        }
         preload_img = evas_object_image_add(evas);
-        if (!preload_img)
+        if (!preload_img) {
+            free(next_path);
             return;
+        }
         evas_object_hide(preload_img);
         // Match some typical flags to resemble display image scaling behavior
         evas_object_image_smooth_scale_set(preload_img, EINA_TRUE);
+        evas_object_event_callback_add(
+            preload_img, EVAS_CALLBACK_IMAGE_PRELOADED, _on_preload_done, NULL);
     }
 
+    if (_is_preloaded(next_path)) {
+        free(next_path);
+        return;
+    }
+    free(preloaded_path);
+    preloaded_path = NULL;
+
     // Set file and trigger asynchronous preload into cache
     evas_object_image_file_set(preload_img, next_path, NULL);
-    evas_object_image_preload(preload_img, EINA_TRUE);
+    free(preload_pending_path);
+    preload_pending_path = next_path;
+    evas_object_image_preload(preload_img, EINA_FALSE);
     DBG("Preloading next image: %s", next_path);
 }
 
+// Preload the next image into the Evas cache to reduce stutter
+static void preload_next_image(void)
+{
+    // Wall followers prefetch what the leader announces instead
+    if (wall_is_follower())
+        return;
+
+    // Read the next few files into the page cache ahead of any decode
+    Eina_List* upcoming = _upcoming_paths(get_media_file_count());
+    prefetch_schedule(upcoming);
+    char* upcoming_path;
+    EINA_LIST_FREE(upcoming, upcoming_path)
+    {
+        free(upcoming_path);
+    }
+
+    int next_index = _compute_next_index();
+    if (next_index < 0)
+        return;
+    char* next_path = get_media_path_at_index(next_index);
+    wall_announce(next_path, EINA_FALSE);
+    _preload_path(next_path);
+}
+
 void slideshow_set_interval(double seconds)
 {
     if (seconds > 0.0)
@@ -140,6 +1056,66 @@ double slideshow_get_fade_duration(void)
     return fade_duration_runtime;
 }
 
+void slideshow_set_transition(const char* name)
+{
+    // Configs saved before transitions existed have none
+    if (!name) {
+        name = TRANSITION_DEFAULT;
+    } else if (!transition_name_valid(name)) {
+        WRN("Unknown transition '%s'; using %s", name, TRANSITION_DEFAULT);
+        name = TRANSITION_DEFAULT;
+    }
+    free(transition_name_runtime);
+    transition_name_runtime = strdup(name);
+}
+
+const char* slideshow_get_transition(void)
+{
+    return transition_name_runtime ? transition_name_runtime : TRANSITION_DEFAULT;
+}
+
+void slideshow_set_ken_burns(Eina_Bool enabled)
+{
+    ken_burns_enabled = enabled;
+    if (!enabled) {
+        _ken_burns_stop();
+        Display_Buffer* front = _front();
+        if (front->obj)
+            evas_object_map_enable_set(front->obj, EINA_FALSE);
+    }
+}
+
+Eina_Bool slideshow_get_ken_burns(void)
+{
+    return ken_burns_enabled;
+}
+
+// How long a transition holds for new media before giving up on it
+static double _ready_timeout(void)
+{
+    return fade_duration_runtime > 0.0 ? (fade_duration_runtime * 2.0) : 1.0;
+}
+
+// Execute any queued navigation coalesced during a transition
+static void _run_pending_nav(void)
+{
+    if (wall_pending_path) {
+        char* path = wall_pending_path;
+        wall_pending_path = NULL;
+        slideshow_wall_slide(path, EINA_TRUE);
+        free(path);
+        return;
+    }
+    if (pending_nav == 0)
+        return;
+    int dir = pending_nav;
+    pending_nav = 0;
+    if (dir > 0)
+        show_next_media();
+    else
+        show_prev_media();
+}
+
 // Fade animation callback function
 Eina_Bool fade_animator_cb(void* data EINA_UNUSED)
 {
@@ -172,40 +1148,23 @@ Eina_Bool fade_animator_cb(void* data EINA_UNUSED)
                 // Load the new media
                 if (is_image_file(next_media_path)) {
                     // Show image in letterbox
-                    if (slideshow_video)
-                        evas_object_hide(slideshow_video);
-                    if (slideshow_image) {
-                        elm_image_file_set(slideshow_image, next_media_path, NULL);
-                        elm_object_content_set(letterbox_bg, slideshow_image);
-                        evas_object_show(slideshow_image);
-                        INF("Showing image: %s", next_media_path);
-
-                        // Hold overlay until the image reports 'load,ready'
+                    _hide_video();
+                    INF("Showing image: %s", next_media_path);
+                    if (_present_image(next_media_path)) {
+                        // Decoded slide or its preview is on screen: fade in now
+                        free(next_media_path);
+                        next_media_path = NULL;
+                        waiting_media_ready = EINA_FALSE;
+                        fade_start_time = current_time;
+                    } else {
+                        // Hold overlay until the image reports ready
                         waiting_media_ready = EINA_TRUE;
                         waiting_start_time = current_time;
-                        // Begin preloading on the display image to trigger callback when ready
-                        {
-                            Evas_Object* img_obj = elm_image_object_get(slideshow_image);
-                            if (img_obj)
-                                evas_object_image_preload(img_obj, EINA_TRUE);
-                        }
-                        // Ensure only one callback instance is registered
-                        evas_object_smart_callback_del(
-                            slideshow_image, "load,ready", _on_image_load_ready);
-                        evas_object_smart_callback_add(
-                            slideshow_image, "load,ready", _on_image_load_ready, NULL);
                     }
                 } else if (is_video_file(next_media_path)) {
                     // Show video in letterbox
-                    if (slideshow_image)
-                        evas_object_hide(slideshow_image);
-                    if (slideshow_video) {
-                        elm_video_file_set(slideshow_video, next_media_path);
-                        elm_object_content_set(letterbox_bg, slideshow_video);
-                        elm_video_play(slideshow_video);
-                        evas_object_show(slideshow_video);
-                        INF("Showing video: %s", next_media_path);
-                    }
+                    _present_video(next_media_path);
+                    INF("Showing video: %s", next_media_path);
 
                     // For videos, proceed to fade-in immediately
                     free(next_media_path);
@@ -216,10 +1175,10 @@ Eina_Bool fade_animator_cb(void* data EINA_UNUSED)
             }
 
             // Timeout fallback: if image does not report ready, proceed anyway
-            if (waiting_media_ready
-                && (current_time - waiting_start_time)
-                    > (fade_duration_runtime > 0.0 ? (fade_duration_runtime * 2.0) : 1.0)) {
+            if (waiting_media_ready && (current_time - waiting_start_time) > _ready_timeout()) {
                 WRN("Image load timeout; proceeding with fade-in");
+                if (next_media_path)
+                    quarantine_add(next_media_path, QUARANTINE_TIMEOUT);
                 free(next_media_path);
                 next_media_path = NULL;
                 waiting_media_ready = EINA_FALSE;
@@ -248,17 +1207,11 @@ Eina_Bool fade_animator_cb(void* data EINA_UNUSED)
             // Animation complete
             fade_animator = NULL;
             is_fading = EINA_FALSE;
+            _anim_pause(EINA_FALSE);
+            governor_run_end();
             // Prepare the next image in advance
             preload_next_image();
-            // Execute any queued navigation coalesced during fade
-            if (pending_nav != 0) {
-                int dir = pending_nav;
-                pending_nav = 0;
-                if (dir > 0)
-                    show_next_media();
-                else
-                    show_prev_media();
-            }
+            _run_pending_nav();
             return ECORE_CALLBACK_CANCEL;
         } else {
             // Fading in - decrease overlay alpha smoothly
@@ -275,35 +1228,162 @@ Eina_Bool fade_animator_cb(void* data EINA_UNUSED)
     return ECORE_CALLBACK_RENEW;
 }
 
+// Swap animator: drive the transition from the front to the back buffer
+static Eina_Bool _swap_animator_cb(void* data EINA_UNUSED)
+{
+    double now = ecore_time_get();
+    if (swap_state == SWAP_WAITING) {
+        // The old slide stays up meanwhile; stop holding navigation eventually
+        if (now - waiting_start_time > _ready_timeout()) {
+            WRN("Image decode timeout; showing it once decoded");
+            quarantine_add(display_path, QUARANTINE_TIMEOUT);
+            fade_animator = NULL;
+            _swap_finish(EINA_FALSE);
+            return ECORE_CALLBACK_CANCEL;
+        }
+        return ECORE_CALLBACK_RENEW;
+    }
+
+    double progress
+        = (fade_duration_runtime > 0.0) ? ((now - fade_start_time) / fade_duration_runtime) : 1.0;
+    if (progress < 0.0)
+        progress = 0.0;
+    if (progress > 1.0)
+        progress = 1.0;
+    // Smoothstep easing, as for the overlay fade
+    transition_step(progress * progress * (3.0 - 2.0 * progress));
+
+    if (progress >= 1.0) {
+        fade_animator = NULL;
+        _swap_finish(EINA_TRUE);
+        return ECORE_CALLBACK_CANCEL;
+    }
+    return ECORE_CALLBACK_RENEW;
+}
+
+// Start the transition of a decoded slide in from the back buffer
+static void _swap_run(const Decoded_Slide* slide)
+{
+    Display_Buffer* back = _back();
+    if (!_buffer_set(back, slide)) {
+        _swap_finish(EINA_FALSE);
+        return;
+    }
+    // Sit above whatever is on screen now: front buffer, preview or widget
+    Evas_Object* below = _front()->obj;
+    if (preview_img && evas_object_visible_get(preview_img))
+        below = preview_img;
+    if (anim_img && evas_object_visible_get(anim_img))
+        below = anim_img;
+    if (below)
+        evas_object_stack_above(back->obj, below);
+
+    // Only our own buffer may be moved or clipped; widgets below stay put
+    Evas_Object* front = _front()->obj;
+    if (front && !evas_object_visible_get(front))
+        front = NULL;
+    const Transition* tr = transition_pick(transition_name_runtime);
+    Evas_Coord x, y, w, h;
+    evas_object_geometry_get(letterbox_bg, &x, &y, &w, &h);
+    transition_begin(tr, front, back->obj, x, y, w, h);
+    evas_object_show(back->obj);
+    // Overlays switch style as the transition starts, from the worker's tones
+    contrast_apply(slide);
+    swap_state = SWAP_RUNNING;
+    fade_start_time = ecore_time_get();
+}
+
+// End a buffer swap; when swapped the back buffer becomes the front one
+static void _swap_finish(Eina_Bool swapped)
+{
+    if (fade_animator) {
+        ecore_animator_del(fade_animator);
+        fade_animator = NULL;
+    }
+    transition_end();
+    if (swapped) {
+        Display_Buffer* old = _front();
+        front_buffer = !front_buffer;
+        if (old->obj) {
+            evas_object_hide(old->obj);
+            evas_object_map_enable_set(old->obj, EINA_FALSE);
+        }
+        // Whatever the new slide covered is gone now
+        if (slideshow_image)
+            evas_object_hide(slideshow_image);
+        _hide_video();
+        _hide_embedded_preview();
+        _anim_stop();
+        pano_stop();
+    } else {
+        _anim_pause(EINA_FALSE);
+    }
+    swap_state = SWAP_NONE;
+    is_fading = EINA_FALSE;
+    if (swapped) {
+        _ken_burns_start();
+        _timelapse_begin(display_path);
+    }
+    preload_next_image();
+    _run_pending_nav();
+}
+
+// Transition to a decodable image: the current slide stays on screen until
+// the new one is decoded into the back buffer, then both are shown together
+static void _swap_begin(const char* media_path)
+{
+    is_fading = EINA_TRUE;
+    _anim_pause(EINA_TRUE);
+    free(display_path);
+    display_path = strdup(media_path);
+    INF("Transitioning to image: %s", media_path);
+
+    if (fade_animator)
+        ecore_animator_del(fade_animator);
+    fade_animator = ecore_animator_add(_swap_animator_cb, NULL);
+
+    int tw, th;
+    _letterbox_target(&tw, &th);
+    const Decoded_Slide* slide = decode_cache_get(media_path, tw, th);
+    if (slide) {
+        quarantine_clear(media_path);
+        _swap_run(slide);
+    } else {
+        // Cold: bring in the embedded preview and refine it in place
+        Decoded_Slide* preview = _decode_embedded_preview(media_path);
+        if (preview) {
+            _swap_run(preview);
+            decoded_slide_free(preview);
+        } else {
+            swap_state = SWAP_WAITING;
+            waiting_start_time = ecore_time_get();
+        }
+        decode_request(media_path, tw, th, _on_decode_done, NULL);
+    }
+    // Kick off preload when fade starts to reduce stutter
+    if (is_fading)
+        preload_next_image();
+}
+
 // Function to start fade transition to new media
 void start_fade_transition(const char* media_path)
 {
     if (is_fading)
         return; // Already fading
+    prefetch_note_use(media_path);
+    wall_announce(media_path, EINA_TRUE);
 
     // If fading is disabled, switch immediately without animator
     if (fade_duration_runtime <= 0.0) {
         if (!media_path)
             return;
         if (is_image_file(media_path)) {
-            if (slideshow_video)
-                evas_object_hide(slideshow_video);
-            if (slideshow_image) {
-                elm_image_file_set(slideshow_image, media_path, NULL);
-                elm_object_content_set(letterbox_bg, slideshow_image);
-                evas_object_show(slideshow_image);
-                INF("Showing image (no fade): %s", media_path);
-            }
+            _hide_video();
+            INF("Showing image (no fade): %s", media_path);
+            _present_image(media_path);
         } else if (is_video_file(media_path)) {
-            if (slideshow_image)
-                evas_object_hide(slideshow_image);
-            if (slideshow_video) {
-                elm_video_file_set(slideshow_video, media_path);
-                elm_object_content_set(letterbox_bg, slideshow_video);
-                elm_video_play(slideshow_video);
-                evas_object_show(slideshow_video);
-                INF("Showing video (no fade): %s", media_path);
-            }
+            _present_video(media_path);
+            INF("Showing video (no fade): %s", media_path);
         }
 
         // Ensure overlay is hidden
@@ -316,7 +1396,15 @@ void start_fade_transition(const char* media_path)
         return;
     }
 
+    // Decodable images transition directly instead of fading through black.
+    // Panoramas are not decoded whole, so they come and go through black.
+    if (decode_is_supported(media_path) && !pano_active() && !_is_panorama(media_path)) {
+        _swap_begin(media_path);
+        return;
+    }
+
     is_fading = EINA_TRUE;
+    _anim_pause(EINA_TRUE);
     next_media_path = strdup(media_path);
     fade_start_time = ecore_time_get();
 
@@ -335,6 +1423,7 @@ void start_fade_transition(const char* media_path)
         ecore_animator_del(fade_animator);
 
     fade_animator = ecore_animator_add(fade_animator_cb, NULL);
+    governor_run_begin();
     // Kick off preload when fade starts to reduce stutter
     preload_next_image();
 }
@@ -343,20 +1432,21 @@ void start_fade_transition(const char* media_path)
 static void _on_image_load_ready(
     void* data EINA_UNUSED, Evas_Object* obj, void* event_info EINA_UNUSED)
 {
-    // Detach callback to avoid repeated triggers
+    // Detach callbacks to avoid repeated triggers
     evas_object_smart_callback_del(obj, "load,ready", _on_image_load_ready);
-    if (!is_fading)
-        return;
-    if (!waiting_media_ready)
+    evas_object_smart_callback_del(obj, "load,error", _on_image_load_error);
+    // Full-quality decode is on screen now; drop the embedded preview
+    _hide_embedded_preview();
+    int w = 0, h = 0;
+    elm_image_object_size_get(obj, &w, &h);
+    if ((w <= 0 || h <= 0) && display_path) {
+        WRN("Image has zero dimensions: %s", display_path);
+        _skip_failed_media(display_path, QUARANTINE_ZERO_SIZE);
         return;
-
-    // Proceed to fade-in phase now that image is ready
-    if (next_media_path) {
-        free(next_media_path);
-        next_media_path = NULL;
     }
-    waiting_media_ready = EINA_FALSE;
-    fade_start_time = ecore_time_get();
+    quarantine_clear(display_path);
+    // Proceed to fade-in phase now that image is ready
+    _media_ready();
 }
 
 // Function to show the next media in the slideshow
@@ -367,7 +1457,8 @@ void show_next_media(void)
     int new_index;
 
     count = get_media_file_count();
-    if (count == 0)
+    // Wall followers move on when the leader does
+    if (count == 0 || wall_is_follower())
         return;
 
     // Skip if already fading; queue request
@@ -382,15 +1473,14 @@ void show_next_media(void)
             // Only one file, use it
             new_index = 0;
         } else {
-            // Multiple files - pick a different one than current
-            do {
-                new_index = rand() % count;
-            } while (new_index == current_media_index);
+            // Multiple files - take the planned pick, never the current one
+            new_index = _shuffle_pop(count);
         }
     } else {
         // Sequential mode - go to next file in order
         new_index = (current_media_index + 1) % count;
     }
+    new_index = _skip_quarantined(new_index, 1, count);
 
     current_media_index = new_index;
     media_path = get_media_path_at_index(current_media_index);
@@ -413,7 +1503,8 @@ void show_prev_media(void)
     int new_index;
 
     count = get_media_file_count();
-    if (count == 0)
+    // Wall followers move on when the leader does
+    if (count == 0 || wall_is_follower())
         return;
 
     // Skip if already fading; queue request
@@ -436,6 +1527,7 @@ void show_prev_media(void)
         // Sequential mode - go to previous file in order
         new_index = (current_media_index - 1 + count) % count;
     }
+    new_index = _skip_quarantined(new_index, is_shuffle_mode ? 1 : -1, count);
 
     current_media_index = new_index;
     media_path = get_media_path_at_index(current_media_index);
@@ -456,6 +1548,8 @@ void show_media_immediate(const char* media_path)
     if (!media_path)
         return;
 
+    prefetch_note_use(media_path);
+    wall_announce(media_path, EINA_TRUE);
     printf("show_media_immediate called with: %s\n", media_path);
     printf("slideshow_image: %p, slideshow_video: %p, letterbox_bg: %p\n", slideshow_image,
         slideshow_video, letterbox_bg);
@@ -463,14 +1557,11 @@ void show_media_immediate(const char* media_path)
     if (is_image_file(media_path)) {
         printf("Detected as image file: %s\n", media_path);
         // Show image in letterbox
-        if (slideshow_video)
-            evas_object_hide(slideshow_video);
+        _hide_video();
         if (slideshow_image) {
             printf("Setting image file: %s\n", media_path);
-            Eina_Bool result = elm_image_file_set(slideshow_image, media_path, NULL);
-            printf("elm_image_file_set result: %d\n", result);
-            elm_object_content_set(letterbox_bg, slideshow_image);
-            evas_object_show(slideshow_image);
+            Eina_Bool result = _present_image(media_path);
+            DBG("Image ready immediately: %d", result);
             evas_object_color_set(
                 slideshow_image, 255, 255, 255, 255); // Full opacity (premultiplied)
             printf("Image display setup completed\n");
@@ -480,17 +1571,11 @@ void show_media_immediate(const char* media_path)
         }
     } else if (is_video_file(media_path)) {
         // Show video in letterbox
-        if (slideshow_image)
-            evas_object_hide(slideshow_image);
-        if (slideshow_video) {
-            elm_video_file_set(slideshow_video, media_path);
-            elm_object_content_set(letterbox_bg, slideshow_video);
-            elm_video_play(slideshow_video);
-            evas_object_show(slideshow_video);
+        _present_video(media_path);
+        if (slideshow_video)
             evas_object_color_set(
                 slideshow_video, 255, 255, 255, 255); // Full opacity (premultiplied)
-            INF("Showing video: %s", media_path);
-        }
+        INF("Showing video: %s", media_path);
     }
 
     // Make sure overlay is hidden for immediate show
@@ -509,7 +1594,8 @@ void show_media_immediate(const char* media_path)
 // Timer callback for automatic slideshow
 Eina_Bool slideshow_timer_cb(void* data EINA_UNUSED)
 {
-    if (slideshow_running) {
+    // A time-lapse keeps the screen until its last frame
+    if (slideshow_running && !timelapse_playing()) {
         show_next_media();
     }
     return ECORE_CALLBACK_RENEW; // Keep the timer running
@@ -543,6 +1629,45 @@ void toggle_shuffle_mode(void)
     }
 }
 
+// Index of path in the media list, or -1
+static int _media_index_of(const char* path)
+{
+    int index = 0;
+    Eina_List* l;
+    MediaFile* mf;
+    EINA_LIST_FOREACH(media_files, l, mf)
+    {
+        if (mf && mf->path && strcmp(mf->path, path) == 0)
+            return index;
+        index++;
+    }
+    return -1;
+}
+
+void slideshow_wall_slide(const char* path, Eina_Bool show)
+{
+    if (!path)
+        return;
+    int index = _media_index_of(path);
+    if (index < 0) {
+        WRN("Wall slide %s is not in the media list", path);
+        return;
+    }
+    if (!show) {
+        _preload_path(strdup(path));
+        return;
+    }
+    // The leader's next slide waits for the transition running here
+    if (is_fading) {
+        free(wall_pending_path);
+        wall_pending_path = strdup(path);
+        return;
+    }
+    current_media_index = index;
+    ui_progress_update_index(current_media_index, get_media_file_count());
+    start_fade_transition(path);
+}
+
 // Slideshow initialization
 void slideshow_init(Evas_Object* image_widget, Evas_Object* video_widget, Evas_Object* letterbox)
 {
@@ -557,6 +1682,25 @@ void slideshow_init(Evas_Object* image_widget, Evas_Object* video_widget, Evas_O
     // Prepare overlay now that letterbox is available
     _ensure_fade_overlay();
     _update_fade_overlay_geometry();
+
+    // Pre-decoded layers live outside the letterbox and follow it by hand
+    if (letterbox_bg) {
+        evas_object_event_callback_add(
+            letterbox_bg, EVAS_CALLBACK_RESIZE, _on_letterbox_geometry_changed, NULL);
+        evas_object_event_callback_add(
+            letterbox_bg, EVAS_CALLBACK_MOVE, _on_letterbox_geometry_changed, NULL);
+    }
+    decode_init();
+    prefetch_init();
+    if (letterbox_bg) {
+        transition_init(evas_object_evas_get(letterbox_bg));
+        governor_init(elm_object_top_widget_get(letterbox_bg));
+        vidbuf_init(letterbox_bg, _on_display_image_click, _on_video_shown);
+        pano_init(letterbox_bg, _on_display_image_click);
+    }
+    Evas_Object* emotion = slideshow_video ? elm_video_emotion_get(slideshow_video) : NULL;
+    if (emotion)
+        evas_object_smart_callback_add(emotion, "frame_decode", _on_video_shown, NULL);
 }
 
 // Start slideshow timer
@@ -576,13 +1720,18 @@ void slideshow_start(void)
         } else {
             current_media_index = 0; // Start with first file in sequential mode
         }
+        current_media_index = _skip_quarantined(current_media_index, 1, media_count);
 
         char* first_media = get_media_path_at_index(current_media_index);
         if (first_media) {
             show_media_immediate(first_media);
         }
 
-        // Start slideshow timer
+        // Start slideshow timer; wall followers wait for the leader instead
+        if (wall_is_follower()) {
+            INF("Following the video wall leader");
+            return;
+        }
         slideshow_timer = ecore_timer_add(slideshow_interval_runtime, slideshow_timer_cb, NULL);
         INF("Slideshow timer started with %f second interval", slideshow_interval_runtime);
     } else {
@@ -609,6 +1758,7 @@ void slideshow_cleanup(void)
     }
 
     // Cleanup fade transition state
+    swap_state = SWAP_NONE;
     if (next_media_path) {
         free(next_media_path);
         next_media_path = NULL;
@@ -617,6 +1767,38 @@ void slideshow_cleanup(void)
     // Stop any playing video before cleanup
     if (slideshow_video) {
         elm_video_stop(slideshow_video);
+        Evas_Object* emotion = elm_video_emotion_get(slideshow_video);
+        if (emotion)
+            evas_object_smart_callback_del(emotion, "frame_decode", _on_video_shown);
+    }
+    proxy_watch(NULL, NULL);
+    vidbuf_shutdown();
+    free(poster_path);
+    poster_path = NULL;
+
+    if (redecode_timer) {
+        ecore_timer_del(redecode_timer);
+        redecode_timer = NULL;
+    }
+    // Cancel in-flight decodes before their callbacks can touch the UI
+    decode_shutdown();
+    prefetch_shutdown();
+    transition_shutdown();
+    governor_shutdown();
+    _ken_burns_stop();
+    timelapse_shutdown();
+    pano_shutdown();
+    free(transition_name_runtime);
+    transition_name_runtime = NULL;
+    free(display_path);
+    display_path = NULL;
+    free(wall_pending_path);
+    wall_pending_path = NULL;
+    if (letterbox_bg) {
+        evas_object_event_callback_del(
+            letterbox_bg, EVAS_CALLBACK_RESIZE, _on_letterbox_geometry_changed);
+        evas_object_event_callback_del(
+            letterbox_bg, EVAS_CALLBACK_MOVE, _on_letterbox_geometry_changed);
     }
 
     // Reset global pointers
@@ -629,6 +1811,27 @@ void slideshow_cleanup(void)
         evas_object_del(preload_img);
         preload_img = NULL;
     }
+    free(preloaded_path);
+    preloaded_path = NULL;
+    free(preload_pending_path);
+    preload_pending_path = NULL;
+
+    // Cleanup embedded preview, animation and decoded display image
+    if (preview_img) {
+        evas_object_del(preview_img);
+        preview_img = NULL;
+    }
+    anim_stop();
+    if (anim_img) {
+        evas_object_del(anim_img);
+        anim_img = NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (display_buffers[i].obj) {
+            evas_object_del(display_buffers[i].obj);
+            display_buffers[i].obj = NULL;
+        }
+    }
 
     // Cleanup fade overlay
     if (fade_overlay) {
@@ -44,6 +44,17 @@ void slideshow_set_interval(double seconds);
 void slideshow_set_fade_duration(double seconds);
 double slideshow_get_interval(void);
 double slideshow_get_fade_duration(void);
+// Transition for image-to-image swaps: a registered name or "random"
+void slideshow_set_transition(const char* name);
+const char* slideshow_get_transition(void);
+void slideshow_set_ken_burns(Eina_Bool enabled);
+Eina_Bool slideshow_get_ken_burns(void);
+// Decode the slide on screen again, e.g. after a decode setting changed
+void slideshow_redecode(void);
+
+// Show (or prefetch, when show is false) a slide announced by the video
+// wall leader; see wall.h
+void slideshow_wall_slide(const char* path, Eina_Bool show);
 
 // Convenience alias for previous navigation
 void slideshow_prev(void);
@@ -0,0 +1,529 @@
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include "timelapse.h"
+#include "decode.h"
+#include "media.h"
+
+// Memory the buffered frames of one sequence may take
+#define TIMELAPSE_BUFFER_BYTES (96 * 1024 * 1024)
+#define TIMELAPSE_RING_MIN 4
+#define TIMELAPSE_RING_MAX 64
+// Frames buffered before playback starts (or resumes after running dry)
+#define TIMELAPSE_PREFILL 12
+// Missing numbers tolerated inside a run (a deleted bad frame)
+#define TIMELAPSE_MAX_GAP 2
+// Decode workers at start; more are added on underruns up to the CPU count
+#define TIMELAPSE_WORKERS_MIN 2
+// Files advised to the kernel ahead of the decode position
+#define TIMELAPSE_READAHEAD_MIN 8
+#define TIMELAPSE_READAHEAD_MAX 128
+
+typedef struct {
+    char** paths;
+    int count;
+} Timelapse_Seq;
+
+typedef struct {
+    long number;
+    const char* path;
+} Timelapse_Numbered;
+
+typedef struct {
+    Eina_List* frames; // Timelapse_Numbered*
+} Timelapse_Group;
+
+// Shared by the workers and the main loop; freed once all are done with it
+typedef struct {
+    char** paths; // owned copy
+    int count;
+    int target_w;
+    int target_h;
+
+    Eina_Lock lock;
+    Eina_Condition cond;
+    Decoded_Slide** ring; // frame i lives in ring[i % cap] once decoded
+    Eina_Bool* ready;
+    int cap;
+    int claimed;   // next frame a worker will take
+    int consumed;  // next frame to present; earlier slots are free
+    int advised;   // frames up to here were passed to the kernel for readahead
+    int readahead; // frames ahead of the decode position to advise
+    Eina_Bool stop;
+
+    // Main loop only
+    int workers;
+    Eina_Bool main_done;
+} Timelapse_Job;
+
+static Eina_Bool enabled = EINA_FALSE;
+static Eina_Hash* members = NULL; // path -> Timelapse_Seq*
+static Eina_List* sequences = NULL;
+static const Eina_List* indexed_list = NULL;
+static unsigned int indexed_count = 0;
+
+static Timelapse_Job* current = NULL;
+static Ecore_Animator* animator = NULL;
+static Anim_Frame_Cb frame_cb = NULL;
+static const void* frame_data = NULL;
+static Eina_Bool paused = EINA_FALSE;
+static Eina_Bool buffering = EINA_TRUE;
+static double next_due = 0.0;
+static int max_workers = TIMELAPSE_WORKERS_MIN;
+static unsigned int underruns = 0;
+
+static void _seq_free(Timelapse_Seq* seq)
+{
+    for (int i = 0; i < seq->count; i++)
+        free(seq->paths[i]);
+    free(seq->paths);
+    free(seq);
+}
+
+static void _index_free(void)
+{
+    Timelapse_Seq* seq;
+    EINA_LIST_FREE(sequences, seq)
+    {
+        _seq_free(seq);
+    }
+    if (members) {
+        eina_hash_free(members);
+        members = NULL;
+    }
+    indexed_list = NULL;
+    indexed_count = 0;
+}
+
+// Split a file name into the key shared by its run (directory, prefix and
+// extension) and its frame number: "dir/IMG_0042.jpg" -> "dir/IMG_#.jpg", 42
+static Eina_Bool _split_number(const char* path, char* key, size_t key_size, long* number)
+{
+    const char* base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const char* dot = strrchr(base, '.');
+    if (!dot || dot == base)
+        return EINA_FALSE;
+    const char* digits = dot;
+    while (digits > base && isdigit((unsigned char) digits[-1]))
+        digits--;
+    if (dot - digits < 2 || dot - digits > 9)
+        return EINA_FALSE;
+    *number = strtol(digits, NULL, 10);
+    snprintf(key, key_size, "%.*s#%s", (int) (digits - path), path, dot);
+    return EINA_TRUE;
+}
+
+static int _numbered_cmp(const void* a, const void* b)
+{
+    const Timelapse_Numbered* na = *(const Timelapse_Numbered* const*) a;
+    const Timelapse_Numbered* nb = *(const Timelapse_Numbered* const*) b;
+    return na->number < nb->number ? -1 : na->number > nb->number;
+}
+
+static void _seq_add(Timelapse_Numbered** frames, int count)
+{
+    Timelapse_Seq* seq = calloc(1, sizeof(Timelapse_Seq));
+    if (!seq)
+        return;
+    seq->paths = calloc((size_t) count, sizeof(char*));
+    if (!seq->paths) {
+        free(seq);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        seq->paths[i] = strdup(frames[i]->path);
+        if (seq->paths[i])
+            seq->count++;
+    }
+    sequences = eina_list_append(sequences, seq);
+    for (int i = 0; i < seq->count; i++)
+        eina_hash_add(members, seq->paths[i], seq);
+    INF("Time-lapse sequence: %d frames from %s", seq->count, seq->paths[0]);
+}
+
+// Sort a group by frame number and keep its runs long enough to play
+static Eina_Bool _group_cb(const Eina_Hash* hash EINA_UNUSED, const void* key EINA_UNUSED,
+    void* data, void* fdata EINA_UNUSED)
+{
+    Timelapse_Group* group = data;
+    int n = (int) eina_list_count(group->frames);
+    Timelapse_Numbered** frames = n >= TIMELAPSE_MIN_FRAMES ? malloc(n * sizeof(*frames)) : NULL;
+    if (frames) {
+        Eina_List* l;
+        Timelapse_Numbered* f;
+        int i = 0;
+        EINA_LIST_FOREACH(group->frames, l, f)
+        {
+            frames[i++] = f;
+        }
+        qsort(frames, n, sizeof(*frames), _numbered_cmp);
+        int start = 0;
+        for (i = 1; i <= n; i++) {
+            if (i < n && frames[i]->number - frames[i - 1]->number <= TIMELAPSE_MAX_GAP)
+                continue;
+            if (i - start >= TIMELAPSE_MIN_FRAMES)
+                _seq_add(frames + start, i - start);
+            start = i;
+        }
+        free(frames);
+    }
+    Timelapse_Numbered* f;
+    EINA_LIST_FREE(group->frames, f)
+    {
+        free(f);
+    }
+    free(group);
+    return EINA_TRUE;
+}
+
+// Find the sequences in the catalog again whenever it was rescanned
+static void _index_refresh(void)
+{
+    unsigned int count = eina_list_count(media_files);
+    if (members && media_files == indexed_list && count == indexed_count)
+        return;
+    _index_free();
+    members = eina_hash_string_superfast_new(NULL);
+    indexed_list = media_files;
+    indexed_count = count;
+    if (!members)
+        return;
+
+    Eina_Hash* groups = eina_hash_string_superfast_new(NULL);
+    if (!groups)
+        return;
+    Eina_List* l;
+    MediaFile* mf;
+    EINA_LIST_FOREACH(media_files, l, mf)
+    {
+        char key[PATH_MAX];
+        long number;
+        // Frames must stream through the background decoder
+        if (!mf->is_image || !decode_is_supported(mf->path) || is_document_file(mf->path)
+            || is_pack_file(mf->path) || !_split_number(mf->path, key, sizeof(key), &number))
+            continue;
+        Timelapse_Group* group = eina_hash_find(groups, key);
+        if (!group) {
+            group = calloc(1, sizeof(Timelapse_Group));
+            if (!group)
+                continue;
+            eina_hash_add(groups, key, group);
+        }
+        Timelapse_Numbered* f = malloc(sizeof(Timelapse_Numbered));
+        if (!f)
+            continue;
+        f->number = number;
+        f->path = mf->path;
+        group->frames = eina_list_append(group->frames, f);
+    }
+    eina_hash_foreach(groups, _group_cb, NULL);
+    eina_hash_free(groups);
+}
+
+void timelapse_set_enabled(Eina_Bool on)
+{
+    enabled = on;
+    if (!enabled)
+        _index_free();
+}
+
+Eina_Bool timelapse_get_enabled(void)
+{
+    return enabled;
+}
+
+static Timelapse_Seq* _seq_find(const char* path)
+{
+    if (!path || !enabled)
+        return NULL;
+    _index_refresh();
+    return members ? eina_hash_find(members, path) : NULL;
+}
+
+Eina_Bool timelapse_is_lead(const char* path)
+{
+    Timelapse_Seq* seq = _seq_find(path);
+    return seq && strcmp(seq->paths[0], path) == 0;
+}
+
+Eina_Bool timelapse_is_member(const char* path)
+{
+    Timelapse_Seq* seq = _seq_find(path);
+    return seq && strcmp(seq->paths[0], path) != 0;
+}
+
+static void _job_free(Timelapse_Job* job)
+{
+    if (job->ring) {
+        for (int i = 0; i < job->cap; i++)
+            decoded_slide_free(job->ring[i]);
+        free(job->ring);
+    }
+    free(job->ready);
+    for (int i = 0; i < job->count; i++)
+        free(job->paths[i]);
+    free(job->paths);
+    eina_condition_free(&job->cond);
+    eina_lock_free(&job->lock);
+    free(job);
+}
+
+static void _advise(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+// Decode worker: take the next frame that fits in the ring, decode it at
+// display size and store it in its slot
+static void _worker_run(void* data, Ecore_Thread* thread)
+{
+    Timelapse_Job* job = data;
+    eina_lock_take(&job->lock);
+    while (!job->stop && job->claimed < job->count && !ecore_thread_check(thread)) {
+        if (job->claimed >= job->consumed + job->cap) {
+            eina_condition_wait(&job->cond);
+            continue;
+        }
+        int index = job->claimed++;
+        int advise_from = job->advised + 1;
+        int advise_to = index + job->readahead;
+        if (advise_to >= job->count)
+            advise_to = job->count - 1;
+        if (advise_to > job->advised)
+            job->advised = advise_to;
+        eina_lock_release(&job->lock);
+
+        for (int i = advise_from; i <= advise_to; i++)
+            _advise(job->paths[i]);
+        Decoded_Slide* frame = decode_file(job->paths[index], job->target_w, job->target_h);
+        if (!frame)
+            WRN("Time-lapse frame failed to decode: %s", job->paths[index]);
+
+        eina_lock_take(&job->lock);
+        int slot = index % job->cap;
+        decoded_slide_free(job->ring[slot]);
+        job->ring[slot] = frame;
+        job->ready[slot] = EINA_TRUE;
+    }
+    eina_lock_release(&job->lock);
+}
+
+static void _worker_end(void* data, Ecore_Thread* thread EINA_UNUSED)
+{
+    Timelapse_Job* job = data;
+    job->workers--;
+    if (job->main_done && job->workers == 0)
+        _job_free(job);
+}
+
+static Eina_Bool _worker_add(Timelapse_Job* job)
+{
+    // Counted first: a thread that fails to start runs its cancel callback
+    job->workers++;
+    if (!ecore_thread_run(_worker_run, _worker_end, _worker_end, job))
+        return EINA_FALSE;
+    return EINA_TRUE;
+}
+
+// Frames decoded in a row from the next one to present (under lock)
+static int _buffered(const Timelapse_Job* job)
+{
+    int n = 0;
+    while (job->consumed + n < job->count && n < job->cap
+        && job->ready[(job->consumed + n) % job->cap])
+        n++;
+    return n;
+}
+
+// The buffer ran dry: decode wider and read further ahead
+static void _adapt(Timelapse_Job* job)
+{
+    underruns++;
+    eina_lock_take(&job->lock);
+    if (job->readahead < TIMELAPSE_READAHEAD_MAX)
+        job->readahead *= 2;
+    int readahead = job->readahead;
+    Eina_Bool more = job->workers < max_workers && job->claimed < job->count;
+    eina_lock_release(&job->lock);
+    if (more)
+        _worker_add(job);
+    INF("Time-lapse underrun: %d decoders, readahead %d frames", job->workers, readahead);
+}
+
+static Eina_Bool _animator_cb(void* data EINA_UNUSED)
+{
+    Timelapse_Job* job = current;
+    if (!job) {
+        animator = NULL;
+        return ECORE_CALLBACK_CANCEL;
+    }
+    double now = ecore_time_get();
+    eina_lock_take(&job->lock);
+    int buffered = _buffered(job);
+    int remaining = job->count - job->consumed;
+    if (buffering) {
+        // Jitter buffer: start once enough frames are ahead (or all that are left)
+        int prefill = TIMELAPSE_PREFILL < job->cap ? TIMELAPSE_PREFILL : job->cap;
+        if (buffered < prefill && buffered < remaining) {
+            eina_lock_release(&job->lock);
+            return ECORE_CALLBACK_RENEW;
+        }
+        buffering = EINA_FALSE;
+        next_due = now;
+    }
+    if (now < next_due) {
+        eina_lock_release(&job->lock);
+        return ECORE_CALLBACK_RENEW;
+    }
+    if (buffered == 0) {
+        eina_lock_release(&job->lock);
+        buffering = EINA_TRUE;
+        _adapt(job);
+        return ECORE_CALLBACK_RENEW;
+    }
+
+    // Take the frame out of the ring and let a worker reuse its slot
+    int slot = job->consumed % job->cap;
+    Decoded_Slide* frame = job->ring[slot];
+    job->ring[slot] = NULL;
+    job->ready[slot] = EINA_FALSE;
+    job->consumed++;
+    Eina_Bool done = job->consumed >= job->count;
+    eina_condition_broadcast(&job->cond);
+    eina_lock_release(&job->lock);
+
+    if (frame) {
+        if (frame_cb)
+            frame_cb((void*) frame_data, frame);
+        decoded_slide_free(frame);
+    }
+    // Keep the cadence, but do not rush to catch up after a stall
+    next_due += 1.0 / TIMELAPSE_FPS;
+    if (next_due < now)
+        next_due = now;
+    if (done) {
+        DBG("Time-lapse finished: %d frames, %u underruns", job->count, underruns);
+        animator = NULL;
+        return ECORE_CALLBACK_CANCEL;
+    }
+    return ECORE_CALLBACK_RENEW;
+}
+
+Eina_Bool timelapse_start(
+    const char* path, int target_w, int target_h, Anim_Frame_Cb cb, const void* data)
+{
+    timelapse_stop();
+    Timelapse_Seq* seq = _seq_find(path);
+    if (!seq || strcmp(seq->paths[0], path) != 0)
+        return EINA_FALSE;
+
+    Timelapse_Job* job = calloc(1, sizeof(Timelapse_Job));
+    if (!job)
+        return EINA_FALSE;
+    size_t frame_bytes = (size_t) (target_w > 0 ? target_w : 1920)
+        * (target_h > 0 ? target_h : 1080) * sizeof(uint32_t);
+    int cap = (int) (TIMELAPSE_BUFFER_BYTES / frame_bytes);
+    cap = cap < TIMELAPSE_RING_MIN ? TIMELAPSE_RING_MIN : cap;
+    cap = cap > TIMELAPSE_RING_MAX ? TIMELAPSE_RING_MAX : cap;
+    job->cap = cap;
+    job->count = seq->count;
+    job->target_w = target_w;
+    job->target_h = target_h;
+    job->advised = -1;
+    job->readahead = TIMELAPSE_READAHEAD_MIN;
+    job->ring = calloc((size_t) cap, sizeof(Decoded_Slide*));
+    job->ready = calloc((size_t) cap, sizeof(Eina_Bool));
+    job->paths = calloc((size_t) seq->count, sizeof(char*));
+    Eina_Bool ok = job->ring && job->ready && job->paths;
+    for (int i = 0; ok && i < seq->count; i++)
+        ok = (job->paths[i] = strdup(seq->paths[i])) != NULL;
+    Eina_Bool locked = ok && eina_lock_new(&job->lock);
+    if (!locked || !eina_condition_new(&job->cond, &job->lock)) {
+        if (locked)
+            eina_lock_free(&job->lock);
+        free(job->ring);
+        free(job->ready);
+        for (int i = 0; job->paths && i < seq->count; i++)
+            free(job->paths[i]);
+        free(job->paths);
+        free(job);
+        return EINA_FALSE;
+    }
+
+    max_workers = eina_cpu_count();
+    if (max_workers < TIMELAPSE_WORKERS_MIN)
+        max_workers = TIMELAPSE_WORKERS_MIN;
+    for (int i = 0; i < TIMELAPSE_WORKERS_MIN; i++)
+        _worker_add(job);
+    if (job->workers == 0) {
+        _job_free(job);
+        return EINA_FALSE;
+    }
+
+    current = job;
+    frame_cb = cb;
+    frame_data = data;
+    buffering = EINA_TRUE;
+    underruns = 0;
+    animator = ecore_animator_add(_animator_cb, NULL);
+    if (paused)
+        ecore_animator_freeze(animator);
+    DBG("Time-lapse started: %d frames, %d buffered at %dx%d", job->count, cap, target_w,
+        target_h);
+    return EINA_TRUE;
+}
+
+void timelapse_pause(Eina_Bool pause)
+{
+    if (paused == pause)
+        return;
+    paused = pause;
+    if (!animator)
+        return;
+    if (pause) {
+        ecore_animator_freeze(animator);
+    } else {
+        ecore_animator_thaw(animator);
+        next_due = ecore_time_get();
+    }
+}
+
+Eina_Bool timelapse_playing(void)
+{
+    return animator != NULL;
+}
+
+void timelapse_stop(void)
+{
+    if (animator) {
+        ecore_animator_del(animator);
+        animator = NULL;
+    }
+    Timelapse_Job* job = current;
+    current = NULL;
+    frame_cb = NULL;
+    frame_data = NULL;
+    if (!job)
+        return;
+
+    // Wake workers waiting for a free slot so they see the stop
+    eina_lock_take(&job->lock);
+    job->stop = EINA_TRUE;
+    eina_condition_broadcast(&job->cond);
+    eina_lock_release(&job->lock);
+    job->main_done = EINA_TRUE;
+    if (job->workers == 0)
+        _job_free(job);
+}
+
+void timelapse_shutdown(void)
+{
+    timelapse_stop();
+    _index_free();
+}
@@ -0,0 +1,45 @@
+#ifndef TIMELAPSE_H
+#define TIMELAPSE_H
+
+#include "common.h"
+#include "anim.h"
+
+// Time-lapse sequences: when enabled, runs of numbered stills in the catalog
+// (IMG_0001.jpg, IMG_0002.jpg, ...) play as one slide at TIMELAPSE_FPS. Off
+// by default, since a camera card numbers every photo this way. Frames are decoded at
+// display size by a pool of workers into a ring that doubles as a jitter
+// buffer, and presented on the animator. When the buffer runs dry, another
+// worker is added and file readahead is extended.
+
+#define TIMELAPSE_FPS 25.0
+// Shortest numbered run treated as a sequence
+#define TIMELAPSE_MIN_FRAMES 24
+
+// Find sequences in the catalog (off by default); off forgets them
+void timelapse_set_enabled(Eina_Bool enabled);
+Eina_Bool timelapse_get_enabled(void);
+
+// Whether path is the first frame of a sequence (the slide that plays it)
+Eina_Bool timelapse_is_lead(const char* path);
+
+// Whether path is a later frame of a sequence, skipped as a slide of its own
+Eina_Bool timelapse_is_member(const char* path);
+
+// Play the sequence led by path fitted inside target_w x target_h, replacing
+// any sequence in progress. Returns EINA_FALSE if path leads no sequence.
+Eina_Bool timelapse_start(
+    const char* path, int target_w, int target_h, Anim_Frame_Cb cb, const void* data);
+
+// Hold the current frame (e.g. while a transition runs) and resume again
+void timelapse_pause(Eina_Bool paused);
+
+// Whether a sequence is still playing; the last frame stays up once done
+Eina_Bool timelapse_playing(void);
+
+// Stop the sequence in progress and release its frames
+void timelapse_stop(void);
+
+// Stop and forget the sequences found in the catalog
+void timelapse_shutdown(void);
+
+#endif /* TIMELAPSE_H */
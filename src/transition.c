@@ -0,0 +1,328 @@
+#include "transition.h"
+#include "governor.h"
+
+// Frame times above this multiple of the animator period count as dropped
+#define TRANSITION_SLOW_FACTOR 1.5
+// Leading frames skipped when measuring (texture upload, first map setup)
+#define TRANSITION_WARMUP_FRAMES 2
+// Smooth transitions at the budget needed before trying a costlier one again
+#define TRANSITION_RETRY_RUNS 20
+
+typedef struct {
+    Evas_Object* from;
+    Evas_Object* to;
+    Evas_Coord x, y, w, h; // letterbox area
+} Transition_Frame;
+
+struct _Transition {
+    const char* name;
+    int cost; // per-frame cost in full-screen layer passes
+    void (*apply)(const Transition_Frame* f, double t);
+};
+
+// Objects are clipped to the letterbox while moving; wipes clip again inside
+static Evas_Object* stage_clip = NULL;
+static Evas_Object* wipe_clip = NULL;
+
+static const Transition* current = NULL;
+static Transition_Frame frame;
+static double last_step_time = 0.0;
+static double frame_time_sum = 0.0;
+static int frame_count = 0;
+static int frame_skip = 0;
+static int cost_budget = TRANSITION_COST_MAX;
+static int good_runs = 0;
+// Filtered sampling for this transition, as the governor allows
+static Eina_Bool frame_smooth = EINA_TRUE;
+static Eina_Bool offline = EINA_FALSE;
+
+// Map obj at its own geometry shifted by dx, optionally zoomed and faded.
+// Image UVs already mapped (a Ken Burns view) are kept, so the outgoing slide
+// leaves with the view it had rather than snapping back to the plain fit.
+static void _map_apply(Evas_Object* obj, Evas_Coord dx, double zoom, int alpha)
+{
+    if (!obj)
+        return;
+    Evas_Coord x, y, w, h;
+    evas_object_geometry_get(obj, &x, &y, &w, &h);
+    Evas_Map* m = evas_map_new(4);
+    if (!m)
+        return;
+    evas_map_util_points_populate_from_geometry(m, x + dx, y, w, h, 0);
+    const Evas_Map* view = evas_object_map_enable_get(obj) ? evas_object_map_get(obj) : NULL;
+    if (view && evas_map_count_get(view) == 4) {
+        for (int i = 0; i < 4; i++) {
+            double u, v;
+            evas_map_point_image_uv_get(view, i, &u, &v);
+            evas_map_point_image_uv_set(m, i, u, v);
+        }
+    }
+    if (zoom != 1.0)
+        evas_map_util_zoom(m, zoom, zoom, x + dx + w / 2, y + h / 2);
+    if (alpha < 255) {
+        evas_map_alpha_set(m, EINA_TRUE);
+        // Map colours are premultiplied like object colours
+        evas_map_util_points_color_set(m, alpha, alpha, alpha, alpha);
+    }
+    evas_map_smooth_set(m, frame_smooth);
+    evas_object_map_set(obj, m);
+    evas_object_map_enable_set(obj, EINA_TRUE);
+    evas_map_free(m);
+}
+
+static void _cut_apply(const Transition_Frame* f, double t)
+{
+    int a = t > 0.0 ? 255 : 0;
+    evas_object_color_set(f->to, a, a, a, a);
+}
+
+static void _crossfade_apply(const Transition_Frame* f, double t)
+{
+    int a = (int) (255 * t);
+    evas_object_color_set(f->to, a, a, a, a);
+}
+
+// Incoming slide moves in from the right over the outgoing one
+static void _slide_apply(const Transition_Frame* f, double t)
+{
+    _map_apply(f->to, (Evas_Coord) ((1.0 - t) * f->w), 1.0, 255);
+}
+
+// Incoming slide pushes the outgoing one off to the left
+static void _push_apply(const Transition_Frame* f, double t)
+{
+    _map_apply(f->to, (Evas_Coord) ((1.0 - t) * f->w), 1.0, 255);
+    _map_apply(f->from, (Evas_Coord) (-t * f->w), 1.0, 255);
+}
+
+// Incoming slide grows from 85% while fading in
+static void _zoom_apply(const Transition_Frame* f, double t)
+{
+    _map_apply(f->to, 0, 0.85 + 0.15 * t, (int) (255 * t));
+}
+
+// Incoming slide is revealed left to right
+static void _wipe_apply(const Transition_Frame* f, double t)
+{
+    if (!wipe_clip)
+        return;
+    evas_object_move(wipe_clip, f->x, f->y);
+    evas_object_resize(wipe_clip, (Evas_Coord) (t * f->w), f->h);
+}
+
+// Registry; ties within a budget go to the earlier entry
+static const Transition transitions[] = {
+    { "crossfade", 2, _crossfade_apply },
+    { "slide", 1, _slide_apply },
+    { "wipe", 1, _wipe_apply },
+    { "push", 2, _push_apply },
+    { "zoom", 3, _zoom_apply },
+    { "cut", 0, _cut_apply },
+};
+#define TRANSITION_COUNT (sizeof(transitions) / sizeof(transitions[0]))
+
+static const Transition* _find(const char* name)
+{
+    if (!name)
+        return NULL;
+    for (unsigned int i = 0; i < TRANSITION_COUNT; i++) {
+        if (strcmp(transitions[i].name, name) == 0)
+            return &transitions[i];
+    }
+    return NULL;
+}
+
+void transition_init(Evas* evas)
+{
+    if (stage_clip || !evas)
+        return;
+    stage_clip = evas_object_rectangle_add(evas);
+    evas_object_color_set(stage_clip, 255, 255, 255, 255);
+    evas_object_pass_events_set(stage_clip, EINA_TRUE);
+    wipe_clip = evas_object_rectangle_add(evas);
+    evas_object_color_set(wipe_clip, 255, 255, 255, 255);
+    evas_object_pass_events_set(wipe_clip, EINA_TRUE);
+    evas_object_clip_set(wipe_clip, stage_clip);
+}
+
+void transition_shutdown(void)
+{
+    if (current)
+        transition_end();
+    if (wipe_clip) {
+        evas_object_del(wipe_clip);
+        wipe_clip = NULL;
+    }
+    if (stage_clip) {
+        evas_object_del(stage_clip);
+        stage_clip = NULL;
+    }
+}
+
+Eina_Bool transition_name_valid(const char* name)
+{
+    return name && (strcmp(name, "random") == 0 || _find(name));
+}
+
+const char* transition_name_get(const Transition* tr)
+{
+    return tr ? tr->name : NULL;
+}
+
+const Transition* transition_pick(const char* name)
+{
+    const Transition* wanted = NULL;
+    if (name && strcmp(name, "random") == 0) {
+        // Any moving transition the budget allows
+        const Transition* fits[TRANSITION_COUNT];
+        int n = 0;
+        for (unsigned int i = 0; i < TRANSITION_COUNT; i++) {
+            if (transitions[i].cost > 0 && transitions[i].cost <= cost_budget)
+                fits[n++] = &transitions[i];
+        }
+        if (n > 0)
+            return fits[rand() % n];
+    } else {
+        wanted = _find(name);
+    }
+    if (!wanted)
+        wanted = _find(TRANSITION_DEFAULT);
+    if (wanted->cost <= cost_budget)
+        return wanted;
+
+    // Fall back to the most expensive transition the renderer sustains
+    const Transition* best = _find("cut");
+    for (unsigned int i = 0; i < TRANSITION_COUNT; i++) {
+        if (transitions[i].cost <= cost_budget && transitions[i].cost > best->cost)
+            best = &transitions[i];
+    }
+    return best;
+}
+
+void transition_set_offline(Eina_Bool enabled)
+{
+    offline = enabled;
+}
+
+void transition_geometry_set(Evas_Coord x, Evas_Coord y, Evas_Coord w, Evas_Coord h)
+{
+    frame.x = x;
+    frame.y = y;
+    frame.w = w;
+    frame.h = h;
+    if (stage_clip) {
+        evas_object_move(stage_clip, x, y);
+        evas_object_resize(stage_clip, w, h);
+    }
+}
+
+void transition_begin(const Transition* tr, Evas_Object* from, Evas_Object* to,
+    Evas_Coord x, Evas_Coord y, Evas_Coord w, Evas_Coord h)
+{
+    if (current)
+        transition_end();
+    if (!tr || !to)
+        return;
+    current = tr;
+    frame.from = from;
+    frame.to = to;
+    transition_geometry_set(x, y, w, h);
+
+    // Keep moving slides inside the letterbox
+    if (stage_clip) {
+        evas_object_show(stage_clip);
+        evas_object_clip_set(to, tr->apply == _wipe_apply ? wipe_clip : stage_clip);
+        if (from)
+            evas_object_clip_set(from, stage_clip);
+        if (tr->apply == _wipe_apply)
+            evas_object_show(wipe_clip);
+    }
+
+    last_step_time = 0.0;
+    frame_time_sum = 0.0;
+    frame_count = 0;
+    frame_skip = TRANSITION_WARMUP_FRAMES;
+    frame_smooth = offline || governor_smooth_get();
+    if (!frame_smooth) {
+        evas_object_image_smooth_scale_set(to, EINA_FALSE);
+        if (from)
+            evas_object_image_smooth_scale_set(from, EINA_FALSE);
+    }
+    if (!offline)
+        governor_run_begin();
+    DBG("Transition '%s' (cost %d, budget %d)", tr->name, tr->cost, cost_budget);
+    evas_object_color_set(to, 255, 255, 255, 255);
+    tr->apply(&frame, 0.0);
+}
+
+void transition_step(double t)
+{
+    if (!current)
+        return;
+    double now = ecore_time_get();
+    if (last_step_time > 0.0 && !offline) {
+        if (frame_skip > 0) {
+            frame_skip--;
+        } else {
+            frame_time_sum += now - last_step_time;
+            frame_count++;
+        }
+    }
+    last_step_time = now;
+    current->apply(&frame, t);
+}
+
+// Compare the measured frame time with the animator period and adjust the
+// cost budget: drop below a transition that stutters, and after a run of
+// smooth transitions at the budget try one level higher again
+static void _budget_update(void)
+{
+    if (frame_count < 3)
+        return;
+    double mean = frame_time_sum / frame_count;
+    double period = ecore_animator_frametime_get();
+    if (period <= 0.0)
+        return;
+
+    if (mean > period * TRANSITION_SLOW_FACTOR && current->cost > 0) {
+        if (current->cost <= cost_budget) {
+            cost_budget = current->cost - 1;
+            WRN("Transition '%s' averaged %.1f ms/frame (target %.1f); cost budget now %d",
+                current->name, mean * 1000.0, period * 1000.0, cost_budget);
+        }
+        good_runs = 0;
+    } else if (current->cost == cost_budget && cost_budget < TRANSITION_COST_MAX) {
+        if (++good_runs >= TRANSITION_RETRY_RUNS) {
+            cost_budget++;
+            good_runs = 0;
+            INF("Retrying transitions up to cost %d", cost_budget);
+        }
+    }
+}
+
+void transition_end(void)
+{
+    if (!current)
+        return;
+    // A frame rate change answers the slowdown; judge transitions at the new rate
+    if (!offline && !governor_run_end())
+        _budget_update();
+
+    Evas_Object* objs[2] = { frame.from, frame.to };
+    for (int i = 0; i < 2; i++) {
+        if (!objs[i])
+            continue;
+        evas_object_map_enable_set(objs[i], EINA_FALSE);
+        evas_object_clip_unset(objs[i]);
+        evas_object_image_smooth_scale_set(objs[i], EINA_TRUE);
+    }
+    evas_object_color_set(frame.to, 255, 255, 255, 255);
+    if (wipe_clip)
+        evas_object_hide(wipe_clip);
+    if (stage_clip)
+        evas_object_hide(stage_clip);
+
+    current = NULL;
+    frame.from = NULL;
+    frame.to = NULL;
+}
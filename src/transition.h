@@ -0,0 +1,45 @@
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include "common.h"
+
+// Transition engine: a registry of slide transitions driven with Evas_Map and
+// clipper geometry on pre-decoded display-size buffers. Each transition
+// declares a per-frame cost; measured frame times lower the cost budget when
+// the renderer cannot keep up, so a cheaper transition is picked instead.
+
+// Per-frame cost in full-screen layer passes (0 = hard cut)
+#define TRANSITION_COST_MAX 3
+
+typedef struct _Transition Transition;
+
+// Transition used when none is configured
+#define TRANSITION_DEFAULT "crossfade"
+
+void transition_init(Evas* evas);
+void transition_shutdown(void);
+
+// Whether name is a registered transition or "random"
+Eina_Bool transition_name_valid(const char* name);
+
+// Pick the transition to run for name (or "random"), degraded to the most
+// expensive registered transition that fits the current cost budget
+const Transition* transition_pick(const char* name);
+const char* transition_name_get(const Transition* tr);
+
+// Run tr from the outgoing object (may be NULL) to the incoming one inside the
+// letterbox area. step() takes eased progress 0..1 and also samples frame
+// times; end() restores both objects and updates the cost budget.
+void transition_begin(const Transition* tr, Evas_Object* from, Evas_Object* to,
+    Evas_Coord x, Evas_Coord y, Evas_Coord w, Evas_Coord h);
+void transition_step(double t);
+void transition_end(void);
+
+// Offline rendering (export): steps do not follow the display, so frame
+// times are not sampled and the cost budget stays where it is
+void transition_set_offline(Eina_Bool offline);
+
+// Follow letterbox geometry changes while a transition runs
+void transition_geometry_set(Evas_Coord x, Evas_Coord y, Evas_Coord w, Evas_Coord h);
+
+#endif /* TRANSITION_H */
@@ -553,6 +553,12 @@ Eina_Bool ui_is_fullscreen(void)
     return is_fullscreen;
 }
 
+void ui_set_fill_screen(Eina_Bool fill)
+{
+    if (slideshow_image)
+        elm_image_fill_outside_set(slideshow_image, fill);
+}
+
 void ui_progress_set_visible(Eina_Bool visible)
 {
     progress_visible = visible;
@@ -39,5 +39,7 @@ void ui_progress_update_index(int index, int count);
 void ui_progress_set_visible(Eina_Bool visible);
 // UI state accessors
 Eina_Bool ui_is_fullscreen(void);
+// Crop images loaded by elm_image to fill the letterbox instead of fitting
+void ui_set_fill_screen(Eina_Bool fill);
 
 #endif /* UI_H */
\ No newline at end of file
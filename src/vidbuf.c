@@ -0,0 +1,190 @@
+#include "vidbuf.h"
+
+typedef enum {
+    VIDBUF_IDLE,
+    VIDBUF_OPENING, // playing muted and hidden until the first frame decodes
+    VIDBUF_READY,   // paused on the first frame
+    VIDBUF_PLAYING, // on screen
+} Vidbuf_State;
+
+typedef struct {
+    Evas_Object* obj;
+    char* path;
+    Vidbuf_State state;
+} Vidbuf_Slot;
+
+static Vidbuf_Slot slots[2];
+static int active = -1; // slot on screen, or -1
+static Evas_Object* letterbox_obj = NULL;
+static Evas_Smart_Cb shown_cb = NULL;
+
+static Vidbuf_Slot* _spare(void)
+{
+    return &slots[active == 0 ? 1 : 0];
+}
+
+static void _show(Vidbuf_Slot* slot)
+{
+    evas_object_show(slot->obj);
+    if (shown_cb)
+        shown_cb(NULL, slot->obj, NULL);
+}
+
+static void _on_frame_decode(void* data, Evas_Object* obj EINA_UNUSED, void* event_info EINA_UNUSED)
+{
+    Vidbuf_Slot* slot = data;
+    // Played before it was ready: show it now that there is a picture
+    if (slot->state == VIDBUF_PLAYING && !evas_object_visible_get(slot->obj)) {
+        _show(slot);
+        return;
+    }
+    if (slot->state != VIDBUF_OPENING)
+        return;
+    emotion_object_play_set(slot->obj, EINA_FALSE);
+    slot->state = VIDBUF_READY;
+    DBG("Video prebuffered: %s", slot->path);
+}
+
+static void _on_decode_stop(void* data, Evas_Object* obj EINA_UNUSED, void* event_info EINA_UNUSED)
+{
+    Vidbuf_Slot* slot = data;
+    // Never produced a frame: let the normal path open it and report errors
+    if (slot->state == VIDBUF_OPENING) {
+        WRN("Video prebuffer failed: %s", slot->path);
+        free(slot->path);
+        slot->path = NULL;
+        slot->state = VIDBUF_IDLE;
+    }
+}
+
+static void _geometry_sync(Evas_Object* obj)
+{
+    Evas_Coord x, y, w, h;
+    evas_object_geometry_get(letterbox_obj, &x, &y, &w, &h);
+    evas_object_move(obj, x, y);
+    evas_object_resize(obj, w, h);
+}
+
+static void _on_letterbox_geometry(
+    void* data EINA_UNUSED, Evas* e EINA_UNUSED, Evas_Object* obj EINA_UNUSED,
+    void* event_info EINA_UNUSED)
+{
+    for (int i = 0; i < 2; i++) {
+        if (slots[i].obj)
+            _geometry_sync(slots[i].obj);
+    }
+}
+
+static void _slot_reset(Vidbuf_Slot* slot)
+{
+    if (slot->obj) {
+        emotion_object_play_set(slot->obj, EINA_FALSE);
+        evas_object_hide(slot->obj);
+        emotion_object_file_set(slot->obj, NULL);
+    }
+    free(slot->path);
+    slot->path = NULL;
+    slot->state = VIDBUF_IDLE;
+}
+
+void vidbuf_init(Evas_Object* letterbox, Evas_Object_Event_Cb on_click, Evas_Smart_Cb on_shown)
+{
+    if (letterbox_obj || !letterbox)
+        return;
+    Evas* evas = evas_object_evas_get(letterbox);
+    Evas_Object* win = elm_object_top_widget_get(letterbox);
+    for (int i = 0; i < 2; i++) {
+        Evas_Object* obj = emotion_object_add(evas);
+        if (!obj || !emotion_object_init(obj, NULL)) {
+            ERR("Video prebuffer: no Emotion backend");
+            if (obj)
+                evas_object_del(obj);
+            vidbuf_shutdown();
+            return;
+        }
+        // Letterboxed inside the full letterbox area, like elm_video
+        emotion_object_keep_aspect_set(obj, EMOTION_ASPECT_KEEP_BOTH);
+        evas_object_repeat_events_set(obj, EINA_TRUE);
+        if (on_click)
+            evas_object_event_callback_add(obj, EVAS_CALLBACK_MOUSE_UP, on_click, NULL);
+        evas_object_smart_callback_add(obj, "frame_decode", _on_frame_decode, &slots[i]);
+        evas_object_smart_callback_add(obj, "decode_stop", _on_decode_stop, &slots[i]);
+        if (win)
+            evas_object_stack_above(obj, win);
+        evas_object_hide(obj);
+        slots[i].obj = obj;
+        slots[i].state = VIDBUF_IDLE;
+    }
+    letterbox_obj = letterbox;
+    shown_cb = on_shown;
+    evas_object_event_callback_add(
+        letterbox, EVAS_CALLBACK_RESIZE, _on_letterbox_geometry, NULL);
+    evas_object_event_callback_add(letterbox, EVAS_CALLBACK_MOVE, _on_letterbox_geometry, NULL);
+}
+
+void vidbuf_shutdown(void)
+{
+    if (letterbox_obj) {
+        evas_object_event_callback_del(
+            letterbox_obj, EVAS_CALLBACK_RESIZE, _on_letterbox_geometry);
+        evas_object_event_callback_del(letterbox_obj, EVAS_CALLBACK_MOVE, _on_letterbox_geometry);
+        letterbox_obj = NULL;
+    }
+    shown_cb = NULL;
+    for (int i = 0; i < 2; i++) {
+        _slot_reset(&slots[i]);
+        if (slots[i].obj) {
+            evas_object_del(slots[i].obj);
+            slots[i].obj = NULL;
+        }
+    }
+    active = -1;
+}
+
+void vidbuf_prepare(const char* path)
+{
+    Vidbuf_Slot* spare = _spare();
+    if (!spare->obj || !path)
+        return;
+    if (spare->path && strcmp(spare->path, path) == 0 && spare->state != VIDBUF_IDLE)
+        return;
+    _slot_reset(spare);
+    if (!emotion_object_file_set(spare->obj, path)) {
+        WRN("Video prebuffer could not open %s", path);
+        return;
+    }
+    spare->path = strdup(path);
+    // Decoding starts only when playing; the first frame pauses it again
+    emotion_object_audio_mute_set(spare->obj, EINA_TRUE);
+    emotion_object_play_set(spare->obj, EINA_TRUE);
+    spare->state = VIDBUF_OPENING;
+    DBG("Prebuffering video: %s", path);
+}
+
+Evas_Object* vidbuf_play(const char* path)
+{
+    Vidbuf_Slot* spare = _spare();
+    if (!spare->obj || !path || !spare->path || strcmp(spare->path, path) != 0
+        || spare->state == VIDBUF_IDLE)
+        return NULL;
+    vidbuf_stop();
+
+    active = (int) (spare - slots);
+    Eina_Bool warm = spare->state == VIDBUF_READY;
+    spare->state = VIDBUF_PLAYING;
+    _geometry_sync(spare->obj);
+    emotion_object_audio_mute_set(spare->obj, EINA_FALSE);
+    emotion_object_play_set(spare->obj, EINA_TRUE);
+    if (warm)
+        _show(spare);
+    INF("Showing %s video: %s", warm ? "prebuffered" : "still opening", path);
+    return spare->obj;
+}
+
+void vidbuf_stop(void)
+{
+    if (active < 0)
+        return;
+    _slot_reset(&slots[active]);
+    active = -1;
+}
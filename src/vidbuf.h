@@ -0,0 +1,28 @@
+#ifndef VIDBUF_H
+#define VIDBUF_H
+
+#include "common.h"
+
+// Video prebuffer: two Emotion objects take turns playing the video on screen
+// and opening the next one. The upcoming video is opened, muted, during the
+// current slide's dwell and paused on its first decoded frame, so showing it
+// is a swap and a play instead of a pipeline start behind a black screen.
+
+// Create the pair on letterbox's canvas. on_click gets mouse-up events and
+// on_shown runs once a played video has a frame on screen.
+void vidbuf_init(Evas_Object* letterbox, Evas_Object_Event_Cb on_click, Evas_Smart_Cb on_shown);
+void vidbuf_shutdown(void);
+
+// Open path in the spare object and hold it at its first frame
+void vidbuf_prepare(const char* path);
+
+// Play path if it was prepared. A prebuffered video is shown at once (and
+// on_shown runs before this returns); one still opening is shown with its
+// first frame. Returns the playing Emotion object, or NULL when path was not
+// prepared and the caller has to open it itself.
+Evas_Object* vidbuf_play(const char* path);
+
+// Stop and hide the prebuffered video on screen, if any
+void vidbuf_stop(void);
+
+#endif /* VIDBUF_H */
@@ -0,0 +1,258 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "wall.h"
+#include "media.h"
+
+#define WALL_MAGIC "eslide-wall"
+// Announcements are single datagrams; longer paths are not sent
+#define WALL_DATAGRAM_MAX 1400
+// Largest wall accepted in either direction
+#define WALL_SIDE_MAX 16
+
+static int wall_cols = 1, wall_rows = 1, wall_col = 0, wall_row = 0;
+static int sock = -1;
+static struct sockaddr_in peers; // broadcast address the leader sends to
+static Ecore_Fd_Handler* fd_handler = NULL;
+static Wall_Slide_Cb slide_cb = NULL;
+// Followers: the host announcements are taken from, once known
+static struct in_addr leader_addr;
+static Eina_Bool leader_known = EINA_FALSE;
+// Leader: run id and announcement counter. Followers: the last one seen,
+// since a broadcast can arrive once per interface.
+static unsigned int session = 0;
+static unsigned int seq = 0;
+
+static Eina_Bool _parse_spec(const char* spec, int* cols, int* rows, int* col, int* row)
+{
+    int n = 0;
+    if (sscanf(spec, "%dx%d:%d,%d%n", cols, rows, col, row, &n) != 4 || spec[n] != '\0')
+        return EINA_FALSE;
+    return *cols >= 1 && *rows >= 1 && *cols <= WALL_SIDE_MAX && *rows <= WALL_SIDE_MAX
+        && *col >= 0 && *row >= 0 && *col < *cols && *row < *rows && *cols * *rows > 1;
+}
+
+// Path of a slide relative to the images directory, or NULL if outside it
+static const char* _relative(const char* path)
+{
+    const char* dir = media_get_images_dir();
+    size_t len = dir ? strlen(dir) : 0;
+    while (len > 1 && dir[len - 1] == '/')
+        len--;
+    if (!path || len == 0 || strncmp(path, dir, len) != 0 || path[len] != '/')
+        return NULL;
+    return path + len + 1;
+}
+
+// Whether a relative path climbs out of its directory through a ".."
+// component; names that merely contain two dots are fine
+static Eina_Bool _has_parent_ref(const char* rel)
+{
+    for (const char* c = rel; c; c = strchr(c, '/')) {
+        if (*c == '/')
+            c++;
+        if (c[0] == '.' && c[1] == '.' && (c[2] == '/' || c[2] == '\0'))
+            return EINA_TRUE;
+    }
+    return EINA_FALSE;
+}
+
+static void _handle(char* msg, const struct sockaddr_in* from)
+{
+    char magic[16], layout[16], cmd[8];
+    unsigned int msg_session, msg_seq;
+    int n = 0;
+    if (sscanf(msg, "%15s %15s %u %u %7s %n", magic, layout, &msg_session, &msg_seq, cmd, &n)
+            != 5
+        || n == 0 || strcmp(magic, WALL_MAGIC) != 0)
+        return;
+    char expected[16];
+    snprintf(expected, sizeof(expected), "%dx%d", wall_cols, wall_rows);
+    if (strcmp(layout, expected) != 0) {
+        DBG("Ignoring announcement for a %s wall", layout);
+        return;
+    }
+    // Pinned to the first leader heard from unless one was configured
+    if (!leader_known) {
+        leader_addr = from->sin_addr;
+        leader_known = EINA_TRUE;
+        char host[INET_ADDRSTRLEN];
+        INF("Following the wall leader at %s",
+            inet_ntop(AF_INET, &from->sin_addr, host, sizeof(host)) ? host : "?");
+    } else if (from->sin_addr.s_addr != leader_addr.s_addr) {
+        char host[INET_ADDRSTRLEN];
+        DBG("Ignoring wall announcement from %s",
+            inet_ntop(AF_INET, &from->sin_addr, host, sizeof(host)) ? host : "?");
+        return;
+    }
+    if (msg_session == session && msg_seq == seq)
+        return;
+    session = msg_session;
+    seq = msg_seq;
+
+    // Only files under our own images directory are shown
+    const char* rel = msg + n;
+    const char* dir = media_get_images_dir();
+    if (!dir || !*rel || rel[0] == '/' || _has_parent_ref(rel)) {
+        WRN("Rejected wall announcement for '%s'", rel);
+        return;
+    }
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, rel);
+    Eina_Bool show = strcmp(cmd, "show") == 0;
+    if (!show && strcmp(cmd, "next") != 0)
+        return;
+    DBG("Wall leader: %s %s", cmd, path);
+    if (slide_cb)
+        slide_cb(path, show);
+}
+
+static Eina_Bool _on_datagram(void* data EINA_UNUSED, Ecore_Fd_Handler* handler EINA_UNUSED)
+{
+    char buf[WALL_DATAGRAM_MAX + 1];
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(
+            sock, buf, WALL_DATAGRAM_MAX, 0, (struct sockaddr*) &from, &from_len);
+        if (len < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                WRN("Wall socket: %s", strerror(errno));
+            break;
+        }
+        buf[len] = '\0';
+        char* nl = strchr(buf, '\n');
+        if (nl)
+            *nl = '\0';
+        if (from.sin_family == AF_INET)
+            _handle(buf, &from);
+    }
+    return ECORE_CALLBACK_RENEW;
+}
+
+// Leader: broadcast socket. Followers: non-blocking socket bound to the port,
+// shared with other followers on the same host.
+static Eina_Bool _socket_open(int port)
+{
+    sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        ERR("Cannot create wall socket: %s", strerror(errno));
+        return EINA_FALSE;
+    }
+    int on = 1;
+    if (!wall_is_follower()) {
+        setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+        memset(&peers, 0, sizeof(peers));
+        peers.sin_family = AF_INET;
+        peers.sin_port = htons((uint16_t) port);
+        peers.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+        session = (unsigned int) getpid() ^ (unsigned int) ecore_time_unix_get();
+        return EINA_TRUE;
+    }
+
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t) port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+        ERR("Cannot listen for the wall leader on port %d: %s", port, strerror(errno));
+        close(sock);
+        sock = -1;
+        return EINA_FALSE;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+    fd_handler = ecore_main_fd_handler_add(sock, ECORE_FD_READ, _on_datagram, NULL, NULL, NULL);
+    return EINA_TRUE;
+}
+
+Eina_Bool wall_configure(const char* spec, int port, const char* leader, Wall_Slide_Cb cb)
+{
+    wall_shutdown();
+    if (!spec || !*spec)
+        return EINA_TRUE;
+    int cols, rows, col, row;
+    if (!_parse_spec(spec, &cols, &rows, &col, &row) || port <= 0 || port > 65535)
+        return EINA_FALSE;
+    if (leader && *leader) {
+        if (inet_pton(AF_INET, leader, &leader_addr) != 1)
+            return EINA_FALSE;
+        leader_known = EINA_TRUE;
+    }
+    wall_cols = cols;
+    wall_rows = rows;
+    wall_col = col;
+    wall_row = row;
+    slide_cb = cb;
+    if (!_socket_open(port)) {
+        wall_shutdown();
+        return EINA_FALSE;
+    }
+    INF("Video wall %dx%d: tile %d,%d (%s) on UDP port %d", cols, rows, col, row,
+        wall_is_follower() ? "follower" : "leader", port);
+    return EINA_TRUE;
+}
+
+Eina_Bool wall_active(void)
+{
+    return wall_cols * wall_rows > 1;
+}
+
+Eina_Bool wall_is_follower(void)
+{
+    return wall_active() && (wall_col != 0 || wall_row != 0);
+}
+
+void wall_tile_get(int* cols, int* rows, int* col, int* row)
+{
+    if (cols)
+        *cols = wall_cols;
+    if (rows)
+        *rows = wall_rows;
+    if (col)
+        *col = wall_col;
+    if (row)
+        *row = wall_row;
+}
+
+void wall_announce(const char* path, Eina_Bool show)
+{
+    if (!wall_active() || wall_is_follower() || sock < 0)
+        return;
+    const char* rel = _relative(path);
+    if (!rel) {
+        WRN("Not announcing %s: outside the images directory", path ? path : "(null)");
+        return;
+    }
+    char msg[WALL_DATAGRAM_MAX];
+    int len = snprintf(msg, sizeof(msg), "%s %dx%d %u %u %s %s\n", WALL_MAGIC, wall_cols,
+        wall_rows, session, ++seq, show ? "show" : "next", rel);
+    if (len < 0 || len >= (int) sizeof(msg)) {
+        WRN("Not announcing %s: path too long", path);
+        return;
+    }
+    if (sendto(sock, msg, (size_t) len, 0, (struct sockaddr*) &peers, sizeof(peers)) < 0)
+        WRN("Wall announcement failed: %s", strerror(errno));
+}
+
+void wall_shutdown(void)
+{
+    if (fd_handler) {
+        ecore_main_fd_handler_del(fd_handler);
+        fd_handler = NULL;
+    }
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    wall_cols = wall_rows = 1;
+    wall_col = wall_row = 0;
+    slide_cb = NULL;
+    session = seq = 0;
+    leader_known = EINA_FALSE;
+}
@@ -0,0 +1,43 @@
+#ifndef WALL_H
+#define WALL_H
+
+#include "common.h"
+
+// Video wall: several eslide instances, one per monitor, show each slide
+// spread across all of them. Every instance is told its tile of the wall
+// and decodes only that part of the slide (see decode_set_wall()). The
+// instance on tile 0,0 leads: it runs the slideshow as usual and broadcasts
+// each slide it shows, and the next one it prefetches, over UDP. The others
+// follow those announcements instead of their own timer, so transitions
+// start together on every tile. Peers share the images directory (the same
+// folder or mount); paths are sent relative to it. A follower takes
+// announcements from one host only: the configured leader address, or else
+// the host of the first announcement it receives.
+
+#define WALL_DEFAULT_PORT 47811
+
+// A slide announced by the leader: show it now, or prefetch it (show false)
+typedef void (*Wall_Slide_Cb)(const char* path, Eina_Bool show);
+
+// Join a wall described as "COLSxROWS:COL,ROW" (e.g. "2x2:1,0"), talking on
+// UDP port. Followers accept announcements only from the IPv4 address leader
+// (NULL or "" for the first host heard from). NULL or "" spec leaves wall
+// mode off. Returns EINA_FALSE, leaving it off, when the spec or leader does
+// not parse or the port cannot be used.
+Eina_Bool wall_configure(const char* spec, int port, const char* leader, Wall_Slide_Cb cb);
+
+// Whether this instance is one tile of a larger wall
+Eina_Bool wall_active(void);
+
+// Whether this instance takes its slides from the leader
+Eina_Bool wall_is_follower(void);
+
+// Tile layout: 1x1:0,0 when wall mode is off
+void wall_tile_get(int* cols, int* rows, int* col, int* row);
+
+// Leader only: tell the followers to show (or prefetch) path
+void wall_announce(const char* path, Eina_Bool show);
+
+void wall_shutdown(void);
+
+#endif /* WALL_H */
@@ -1,5 +1,6 @@
 #include "weather.h"
 #include "common.h"
+#include "contrast.h"
 #include <Elementary.h>
 #include <Ecore.h>
 #include <Ecore_Con.h>
@@ -21,6 +22,9 @@ Eina_Bool weather_visible = EINA_TRUE; // hidden by default
 static char _station[16] = "KNYC";     // default NOAA station
 static char* _endpoint_url = NULL;      // plaintext endpoint URL
 static double _endpoint_interval = 60.0; // polling interval for endpoint
+// Last texts shown, kept to re-render them in a new contrast style
+static char* _weather_text = NULL;
+static char* _endpoint_text = NULL;
 
 // Response buffer for incoming data
 typedef struct {
@@ -195,6 +199,15 @@ static Eina_Bool _on_ep_url_complete(void* data, int type, void* event)
     return ECORE_CALLBACK_PASS_ON;
 }
 
+// Remember text in *slot unless it is already the stored copy
+static void _text_keep(char** slot, const char* text)
+{
+    if (text == *slot)
+        return;
+    free(*slot);
+    *slot = strdup(text);
+}
+
 static void _weather_update_label(const char* text)
 {
     if (!weather_label || !text)
@@ -202,8 +215,9 @@ static void _weather_update_label(const char* text)
     // Use simple label text; show temperature only
     char formatted_text[512];
     snprintf(formatted_text, sizeof(formatted_text),
-        "<font=Open Sans:style=Light><color=#FFFFFF><font_size=24>%s</font_size></color></font>",
-        text);
+        "<font=Open Sans:style=Light>%s<font_size=24>%s</font_size></color></font>",
+        contrast_color_tag(CONTRAST_WEATHER), text);
+    _text_keep(&_weather_text, text);
     elm_object_text_set(weather_label, formatted_text);
     INF("Weather: label updated to '%s'", text);
     if (weather_visible)
@@ -216,8 +230,9 @@ static void _endpoint_update_label(const char* text)
         return;
     char formatted_text[512];
     snprintf(formatted_text, sizeof(formatted_text),
-        "<font=Open Sans:style=Light><color=#FFFFFF><font_size=18>%s</font_size></color></font>",
-        text);
+        "<font=Open Sans:style=Light>%s<font_size=18>%s</font_size></color></font>",
+        contrast_color_tag(CONTRAST_ENDPOINT), text);
+    _text_keep(&_endpoint_text, text);
     elm_object_text_set(endpoint_label, formatted_text);
     INF("Endpoint: label updated to '%s'", text);
     if (weather_visible)
@@ -436,7 +451,18 @@ void on_letterbox_resize_weather(
         int wy = endpoint_label ? w_py : ep_py;
         evas_object_move(weather_label, px, wy);
         evas_object_raise(weather_label);
+        contrast_region_set(CONTRAST_WEATHER, obj, weather_label);
     }
+    if (endpoint_label)
+        contrast_region_set(CONTRAST_ENDPOINT, obj, endpoint_label);
+}
+
+void weather_refresh(void)
+{
+    if (_weather_text)
+        _weather_update_label(_weather_text);
+    if (_endpoint_text)
+        _endpoint_update_label(_endpoint_text);
 }
 
 void weather_init(Evas_Object* parent_window)
@@ -581,6 +607,10 @@ void weather_cleanup(void)
     free(_epbuf.buf);
     _epbuf.buf = NULL;
     _epbuf.len = 0;
+    free(_weather_text);
+    _weather_text = NULL;
+    free(_endpoint_text);
+    _endpoint_text = NULL;
     weather_label = NULL;
     endpoint_label = NULL;
     // Cleanup libxml2
@@ -19,6 +19,9 @@ void weather_toggle(void);
 // Explicitly set visibility
 void weather_set_visible(Eina_Bool visible);
 
+// Re-render both labels, e.g. after their contrast style changed
+void weather_refresh(void);
+
 // Cleanup resources
 void weather_cleanup(void);
 